@@ -2,11 +2,34 @@
 // FUNC : transfer data between FPGA and ARM
 // DATE : 2013.08.05 by Young
 // DESP : 16-bit data/addr multiplexed mode (default)
+//        8 / 16 / 32-bit port size (port_width module parameter, DSZ ioctl field)
+//        one device per enabled chip select (cs_mask module parameter, /dev/eim0 - 3)
+//        parameters / program mode profiles (EIM_IOC_SET_PROFILE, profile sysfs)
+//        SDMA write path for large writes (dma_write / dma_cutoff module parameters)
+//        SDMA read path for large reads (dma_read / dma_read_cutoff module parameters,
+//        cutoffs also in EIM_IOC_SET_CONFIG, per-engine counters EIM_IOC_GET_ENGINE_STATS)
+//        halfword, burst aligned CPU copies through a bounce buffer (copy16, eim_copy.h)
+//        mmap cache attribute selected by the mmap offset (EIM_MMAP_OFFSET)
 //        synchronous transmission mode
-//        dmode / MUM / BCD / WWSC sysfs
+//        dmode / MUM / BCD / WWSC / RWSC / BL sysfs
+//        bcd / bl / rwsc / wwsc module parameters (eim_tune result)
+//        every CS1 timing field through ioctl (eim_ioctl.h)
+//        loopback module parameter (RAM-backed window, no hardware access)
+//        loopback_timing module parameter (bus time from eim_timing.h)
 // HIST : V1.0 2013.08.05 - eim driver program
 //        V1.1 2013.09.04 - add FPP function
 //        V1.2 2013.09.20 - add WWSC device attribute
+//        V1.3 2026.10.19 - add RAM-backed loopback mode
+//        V1.4 2026.10.19 - pace loopback transfers by the eim timing model
+//        V1.5 2026.10.19 - add RWSC / BL device attributes and tuned timing parameters
+//        V1.6 2026.10.19 - add EIM_IOC_GET_CONFIG / EIM_IOC_SET_CONFIG (full CS1 timing set)
+//        V1.7 2026.10.19 - add 8 / 32-bit port size
+//        V1.8 2026.10.19 - add CS0 - CS3 instances with their own timing and lock
+//        V1.9 2026.10.19 - add precomputed mode profiles and lazy IOMUX setup
+//        V2.0 2026.10.19 - add SDMA write path with a calibrated CPU / DMA cutoff
+//        V2.1 2026.10.19 - add halfword, burst aligned window copies
+//        V2.2 2026.10.19 - add write-combine / strongly ordered window mappings
+//        V2.3 2026.10.19 - add SDMA read path, per-request engine choice and engine counters
 
 #include <linux/fs.h>
 #include <linux/ioport.h>
@@ -17,10 +40,27 @@
 #include <linux/mutex.h>
 #include <linux/gpio.h>
 #include <linux/delay.h>
+#include <linux/moduleparam.h>
+#include <linux/vmalloc.h>
+#include <linux/version.h>
+#include <linux/ktime.h>
 #include <asm/io.h>
 #include <asm/uaccess.h>
-
+#include <asm/div64.h>
+
+#ifndef EIM_HOST_BUILD
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
+#include <linux/completion.h>
+#include <linux/sched.h>
 #include <mach/iomux-mx6q.h>
+#include <mach/dma.h>
+#endif
+
+#include "eim_timing.h"
+#include "eim_ioctl.h"
+#include "eim_copy.h"
 
 
 // print debug information
@@ -31,8 +71,9 @@
 #define DOWNLOAD_PARAMETERS     (2)
 
 // registers address
-#define EIM_MEM_BASE  	        (0x0C000000)
-#define EIM_MEM_LEN             (0x4000000)
+#define EIM_MEM_BASE  	        (0x08000000)    // CS0 - CS3 windows
+#define EIM_MEM_LEN             (0x4000000)     // 64M per CS with CS0 / CS1 only
+#define EIM_MEM_LEN_4CS         (0x2000000)     // 32M per CS once CS2 / CS3 are enabled
 #define EIM_BASE 		        (0x021B8000)
 #define EIM_LEN  		        (0x98 + 0x4)
 #define CCM_BASE 		        (0x020C4000)
@@ -44,6 +85,55 @@
 
 #define DEVICE_NAME 	        "eim"
 
+// chip selects
+#define EIM_CS_MAX              (4)
+
+// the number of pads eim may own (mux + nomux + d32 + cs tables)
+#define EIM_PAD_MAX             (96)
+
+// CPU copy bounce buffer per chip select
+#define EIM_BOUNCE_LEN          (PAGE_SIZE)
+
+// SDMA write path
+#define EIM_DMA_PAGES           (256)           // pages pinned per transfer (1M)
+#define EIM_DMA_TIMEOUT_MS      (1000)
+#define EIM_DMA_CAL_MIN         (256)           // calibration sizes 256B - 64K
+#define EIM_DMA_CAL_MAX         (0x10000)
+#define EIM_DMA_CAL_LOOPS       (8)
+#define EIM_DMA_CUTOFF_DEFAULT  (4096)          // cutoff without dma_calibrate
+
+// CSx timing registers (offset from CSxGCR1) --- ref : IMX6DQRM p1038-1050
+#define EIM_CS_GCR1             (0x00)
+#define EIM_CS_GCR2             (0x04)
+#define EIM_CS_RCR1             (0x08)
+#define EIM_CS_RCR2             (0x0C)
+#define EIM_CS_WCR1             (0x10)
+#define EIM_CS_WCR2             (0x14)
+#define EIM_CS_REG_LEN          (0x18)
+
+// loopback mode (EIM_HOST_BUILD has no i.MX6 hardware, loading it with loopback=0 fails)
+#ifdef EIM_HOST_BUILD
+#define EIM_LOOPBACK_DEFAULT    (1)
+#define IMX_GPIO_NR(bank, nr)   (((bank) - 1) * 32 + (nr))
+#else
+#define EIM_LOOPBACK_DEFAULT    (0)
+#endif
+
+// host kernel compatibility
+#ifndef VM_RESERVED
+#define VM_RESERVED             (VM_DONTEXPAND | VM_DONTDUMP)
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+#define EIM_VM_FLAGS_SET(vma, flags)    vm_flags_set(vma, flags)
+#else
+#define EIM_VM_FLAGS_SET(vma, flags)    ((vma)->vm_flags |= (flags))
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 4, 0)
+#define EIM_CLASS_CREATE(name)  class_create(name)
+#else
+#define EIM_CLASS_CREATE(name)  class_create(THIS_MODULE, name)
+#endif
+
 // GPIO defination
 #define GPIO_FPP_UNUSE          IMX_GPIO_NR(4,14)   // KEY_COL4
 #define GPIO_FPP_nCONFIG        IMX_GPIO_NR(3,16)   // EIM_D16
@@ -63,7 +153,85 @@
 #define SET_DAT6_PUSHPULL()     iowrite32(0x0001B0B0, CSI0_DAT8_PCR)
 #define SET_DAT7_PUSHPULL()     iowrite32(0x0001B0B0, CSI0_DAT9_PCR)
 
-
+// loopback = 1 : EIM window is an ordinary kernel buffer and EIM/CCM registers
+//                are shadowed in RAM, IOMUX / GPIO / CS1 are never touched
+static int loopback = EIM_LOOPBACK_DEFAULT;
+module_param(loopback, int, S_IRUGO);
+MODULE_PARM_DESC(loopback, "RAM-backed loopback mode without EIM hardware (0 / 1)");
+
+// loopback_timing = 1 : loopback transfers busy-wait for the bus time predicted
+//                       from the current CS1 registers (EIM simulator)
+static int loopback_timing = 0;
+module_param(loopback_timing, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(loopback_timing, "emulate EIM bus time in loopback mode (0 / 1)");
+
+// iomux_lazy = 0 : every pad is set up again on each IOMUX change, as before
+//                  the lazy setup (eim_mode_bench baseline)
+static int iomux_lazy = 1;
+module_param(iomux_lazy, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(iomux_lazy, "set up only the pads that changed (0 / 1)");
+
+// tuned CS1 timing applied at load (-1 keeps the built-in value)
+// eim_tune writes them to eim_tune.conf : insmod eim.ko $(cat eim_tune.conf)
+static int bcd = -1;
+module_param(bcd, int, S_IRUGO);
+MODULE_PARM_DESC(bcd, "Burst Clock Divisor (0 - 3)");
+static int bl = -1;
+module_param(bl, int, S_IRUGO);
+MODULE_PARM_DESC(bl, "Burst Length (0 - 4)");
+static int rwsc = -1;
+module_param(rwsc, int, S_IRUGO);
+MODULE_PARM_DESC(rwsc, "Read Wait State Control (0 - 63)");
+static int wwsc = -1;
+module_param(wwsc, int, S_IRUGO);
+MODULE_PARM_DESC(wwsc, "Write Wait State Control (0 - 63)");
+
+// port size in bits (8 - DATA[7:0], 16 - DATA[15:0], 32 - DATA[31:0])
+// 32-bit uses EIM_D16 - EIM_D18 as data, so while any CS has a 32-bit port no
+// CS can download the FPGA program
+static int port_width = 16;
+module_param(port_width, int, S_IRUGO);
+MODULE_PARM_DESC(port_width, "EIM data port size in bits (8 / 16 / 32)");
+
+// enabled chip selects (bit n - CSn, /dev/eimn), CS1 alone is the original layout
+static int cs_mask = 0x2;
+module_param(cs_mask, int, S_IRUGO);
+MODULE_PARM_DESC(cs_mask, "enabled chip selects (bit 0 - 3 for CS0 - CS3)");
+
+// dma_write = 1 : writes of dma_cutoff bytes and more go through SDMA from the
+//                 pinned user pages, smaller ones are copied by the CPU
+// dma_cutoff < 0 : EIM_DMA_CUTOFF_DEFAULT, or measured at load with dma_calibrate = 1
+//                  (the first size SDMA beats the CPU copy)
+// dma_read / dma_read_cutoff : the same for reads, SDMA into the pinned user pages
+// both cutoffs can be changed later through EIM_IOC_SET_CONFIG
+// dma_calibrate = 1 : writes zeros to and reads the first CS window at load, so
+//                     it is off unless nothing on the bus can be disturbed
+// copy16 = 1 : CPU copies go through a cached bounce buffer and reach the
+//              window with halfword / LDM / STM accesses on burst boundaries
+// copy16 = 0 : copy_from_user / copy_to_user straight on the window
+static int copy16 = 1;
+module_param(copy16, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(copy16, "halfword, burst aligned window copies (0 / 1)");
+
+static int dma_write = 1;
+module_param(dma_write, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(dma_write, "SDMA write path (0 / 1)");
+static int dma_cutoff = -1;
+module_param(dma_cutoff, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(dma_cutoff, "smallest write in bytes sent through SDMA (-1 : default or calibrated)");
+
+static int dma_read = 1;
+module_param(dma_read, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(dma_read, "SDMA read path (0 / 1)");
+static int dma_read_cutoff = -1;
+module_param(dma_read_cutoff, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(dma_read_cutoff, "smallest read in bytes carried by SDMA (-1 : default or calibrated)");
+
+static int dma_calibrate = 0;
+module_param(dma_calibrate, int, S_IRUGO);
+MODULE_PARM_DESC(dma_calibrate, "measure the unset SDMA cutoffs on the bus at load (0 / 1)");
+
+#ifndef EIM_HOST_BUILD
 // IOMUX configuration (eim_mux)
 static iomux_v3_cfg_t eim_mux_pads[] = {
 	// 16-bit data/addr multiplexed
@@ -91,8 +259,6 @@ static iomux_v3_cfg_t eim_mux_pads[] = {
     MX6Q_PAD_EIM_RW__WEIM_WEIM_RW,
 	// address valid (active-L)
     MX6Q_PAD_EIM_LBA__WEIM_WEIM_LBA,
-	// cs1 64M (active-L)
-    MX6Q_PAD_EIM_CS1__WEIM_WEIM_CS_1,
     // KEY_COL4 -- UNUSE
     MX6Q_PAD_KEY_COL4__GPIO_4_14,
     // EIM_D16 -- nCONFIG
@@ -145,8 +311,6 @@ static iomux_v3_cfg_t eim_nomux_pads[] = {
     MX6Q_PAD_EIM_OE__WEIM_WEIM_OE,
 	// write to FPGA (active-L)
     MX6Q_PAD_EIM_RW__WEIM_WEIM_RW,
-	// cs1 64M (active-L)
-    MX6Q_PAD_EIM_CS1__WEIM_WEIM_CS_1,
     // KEY_COL4 -- UNUSE
     MX6Q_PAD_KEY_COL4__GPIO_4_14,
     // EIM_D16 -- nCONFIG
@@ -157,23 +321,75 @@ static iomux_v3_cfg_t eim_nomux_pads[] = {
     MX6Q_PAD_EIM_D18__GPIO_3_18,
 };
 
-// eim device struct
-typedef struct _eim_dev
+// IOMUX configuration (32-bit port, on top of eim_mux / eim_nomux)
+// DATA[31:16] - multiplexed with the upper address in eim_mux mode
+static iomux_v3_cfg_t eim_d32_pads[] = {
+    MX6Q_PAD_EIM_D16__WEIM_WEIM_D_16,
+    MX6Q_PAD_EIM_D17__WEIM_WEIM_D_17,
+    MX6Q_PAD_EIM_D18__WEIM_WEIM_D_18,
+    MX6Q_PAD_EIM_D19__WEIM_WEIM_D_19,
+    MX6Q_PAD_EIM_D20__WEIM_WEIM_D_20,
+    MX6Q_PAD_EIM_D21__WEIM_WEIM_D_21,
+    MX6Q_PAD_EIM_D22__WEIM_WEIM_D_22,
+    MX6Q_PAD_EIM_D23__WEIM_WEIM_D_23,
+    MX6Q_PAD_EIM_D24__WEIM_WEIM_D_24,
+    MX6Q_PAD_EIM_D25__WEIM_WEIM_D_25,
+    MX6Q_PAD_EIM_D26__WEIM_WEIM_D_26,
+    MX6Q_PAD_EIM_D27__WEIM_WEIM_D_27,
+    MX6Q_PAD_EIM_D28__WEIM_WEIM_D_28,
+    MX6Q_PAD_EIM_D29__WEIM_WEIM_D_29,
+    MX6Q_PAD_EIM_D30__WEIM_WEIM_D_30,
+    MX6Q_PAD_EIM_D31__WEIM_WEIM_D_31,
+};
+
+// IOMUX configuration (chip selects, active-L)
+static iomux_v3_cfg_t eim_cs_pads[EIM_CS_MAX] = {
+    MX6Q_PAD_EIM_CS0__WEIM_WEIM_CS_0,
+    MX6Q_PAD_EIM_CS1__WEIM_WEIM_CS_1,
+    MX6Q_PAD_SD2_DAT1__WEIM_WEIM_CS_2,
+    MX6Q_PAD_SD2_DAT2__WEIM_WEIM_CS_3,
+};
+#endif
+
+// the number of CSx timing registers
+#define EIM_CS_REG_CNT          (6)
+
+// mode profile (dmode, and the CSx register fields it owns as precomputed
+// masks / values, every other field keeps its live value)
+typedef struct _eim_profile
 {
-	// char device
-    struct cdev *cdev;
+    int dmode;
+    u32 mask[EIM_CS_REG_CNT];
+    u32 val[EIM_CS_REG_CNT];
+}eim_profile;
+
+// profile names (index is EIM_PROFILE_*)
+static const char *eim_profile_names[EIM_PROFILE_CNT] = {
+    "parameters",
+    "program",
+};
+
+// eim chip select struct ('/dev/eimN')
+typedef struct _eim_cs
+{
+    // chip select number
+    int cs;
 
-    // device number
+	// char device
+    struct cdev cdev;
     dev_t devno;
-    struct class *eim_class;
     struct device *eim_device;
 
-	// virtual address
+    // CS window
+    unsigned long mem_phys;
+    unsigned long mem_len;
     void __iomem *eim_mem_base;
-    void __iomem *eim_base;
-    void __iomem *ccm_base;
-    void __iomem *csi0_dat8_base;
-    void __iomem *csi0_dat9_base;
+
+    // CSxGCR1 virtual address
+    void __iomem *cs_base;
+
+    // cached bounce buffer of the CPU copies (EIM_BOUNCE_LEN)
+    void *bounce;
 
 	// device open state
     atomic_t open_state;
@@ -181,8 +397,57 @@ typedef struct _eim_dev
     // download mode
     int eim_dmode;
 
-    // mutex lock
+    // mode profiles and the last switch
+    eim_profile profile[EIM_PROFILE_CNT];
+    struct eim_profile_stats profile_stats;
+
+    // requests and bytes carried by the CPU copy and by SDMA
+    struct eim_engine_stats engine_stats;
+
+    // mutex lock (CS registers and window)
     struct mutex eim_mutex_lock;
+}eim_cs;
+
+// eim device struct
+typedef struct _eim_dev
+{
+    // device number (minor n is CSn)
+    dev_t devno;
+    struct class *eim_class;
+
+	// virtual address
+    void __iomem *eim_base;
+    void __iomem *ccm_base;
+    void __iomem *csi0_dat8_base;
+    void __iomem *csi0_dat9_base;
+
+    // enabled chip selects
+    eim_cs *cs[EIM_CS_MAX];
+
+#ifndef EIM_HOST_BUILD
+    // pads set up so far, and the pads wanted by the current chip selects
+    iomux_v3_cfg_t pad_state[EIM_PAD_MAX];
+    int pad_state_cnt;
+    iomux_v3_cfg_t pad_want[EIM_PAD_MAX];
+    int pad_want_cnt;
+#endif
+
+    // the number of pads set up by the last eim_iomux
+    int pad_set_cnt;
+
+    // DATA[31:16] own EIM_D16 - EIM_D31, no CS can download the FPGA program
+    int pads_d32;
+
+#ifndef EIM_HOST_BUILD
+    // SDMA channel of the read / write paths, shared by all chip selects
+    struct dma_chan *dma_chan;
+    struct completion dma_done;
+    struct mutex eim_dma_lock;
+#endif
+
+    // mutex lock (shared pads and FPP GPIOs)
+    struct mutex eim_iomux_lock;
+    struct mutex eim_fpp_lock;
 }eim_dev;
 static eim_dev *mdev = NULL;
 
@@ -203,19 +468,57 @@ static int eim_map(void)
 	int req_ccm_base = 0;
     int req_csi0_dat8_base = 0;
     int req_csi0_dat9_base = 0;
+    int n = 0;
 
-	// eim_mem_base
-	req_eim_mem_base = (int)request_mem_region(EIM_MEM_BASE, EIM_MEM_LEN, "EIM_MEM");
-    if (0 == req_eim_mem_base)
+    // loopback : windows in vmalloc memory (mmap-able), registers shadowed in RAM
+    if (loopback)
     {
-        printk(KERN_ERR "< eim.c > eim_map : request_mem_region EIM_MEM_BASE failed.\n");
-        return -EBUSY;
+        mdev->eim_base = (void __iomem *)kzalloc(EIM_LEN, GFP_KERNEL);
+        mdev->ccm_base = (void __iomem *)kzalloc(CCM_LEN, GFP_KERNEL);
+        if (!mdev->eim_base || !mdev->ccm_base)
+        {
+            printk(KERN_ERR "< eim.c > eim_map : allocate loopback memory failed.\n");
+            return -ENOMEM;
+        }
+        for (n = 0; n < EIM_CS_MAX; n++)
+        {
+            eim_cs *ecs = mdev->cs[n];
+            if (!ecs)
+            {
+                continue;
+            }
+            ecs->eim_mem_base = (void __iomem *)vmalloc_user(ecs->mem_len);
+            if (!ecs->eim_mem_base)
+            {
+                printk(KERN_ERR "< eim.c > eim_map : allocate loopback memory failed.\n");
+                return -ENOMEM;
+            }
+            ecs->cs_base = mdev->eim_base + n * EIM_CS_REG_LEN;
+        }
+        return 0;
     }
-	mdev->eim_mem_base = ioremap(EIM_MEM_BASE, EIM_MEM_LEN);
-    if (!mdev->eim_mem_base)
+
+	// eim_mem_base of every enabled CS
+    for (n = 0; n < EIM_CS_MAX; n++)
     {
-        printk(KERN_ERR "< eim.c > eim_map : ioremap EIM_MEM_BASE failed.\n");
-        return -EBUSY;
+        eim_cs *ecs = mdev->cs[n];
+        if (!ecs)
+        {
+            continue;
+        }
+        req_eim_mem_base = (int)request_mem_region(ecs->mem_phys, ecs->mem_len, "EIM_MEM");
+        if (0 == req_eim_mem_base)
+        {
+            printk(KERN_ERR "< eim.c > eim_map : request_mem_region EIM_MEM_BASE (CS%d) failed.\n", n);
+            return -EBUSY;
+        }
+        ecs->eim_mem_base = ioremap(ecs->mem_phys, ecs->mem_len);
+        if (!ecs->eim_mem_base)
+        {
+            printk(KERN_ERR "< eim.c > eim_map : ioremap EIM_MEM_BASE (CS%d) failed.\n", n);
+            release_mem_region(ecs->mem_phys, ecs->mem_len);
+            return -EBUSY;
+        }
     }
 
 	// eim_base
@@ -231,6 +534,13 @@ static int eim_map(void)
         printk(KERN_ERR "< eim.c > eim_map : ioremap EIM_BASE failed.\n");
         return -EBUSY;
     }
+    for (n = 0; n < EIM_CS_MAX; n++)
+    {
+        if (mdev->cs[n])
+        {
+            mdev->cs[n]->cs_base = mdev->eim_base + n * EIM_CS_REG_LEN;
+        }
+    }
 
 	// ccm_base
 	req_ccm_base = (int)request_mem_region(CCM_BASE, CCM_LEN, "CCM");
@@ -289,11 +599,36 @@ static int eim_map(void)
 // -------------------------------------------------------------
 static void eim_unmap(void)
 {
-	// eim_mem_base
-    if (mdev->eim_mem_base)
+    int n = 0;
+
+    // loopback memory
+    if (loopback)
+    {
+        for (n = 0; n < EIM_CS_MAX; n++)
+        {
+            if (mdev->cs[n])
+            {
+                vfree((void *)mdev->cs[n]->eim_mem_base);
+                mdev->cs[n]->eim_mem_base = NULL;
+            }
+        }
+        kfree((void *)mdev->eim_base);
+        kfree((void *)mdev->ccm_base);
+        mdev->eim_base = NULL;
+        mdev->ccm_base = NULL;
+        return;
+    }
+
+	// eim_mem_base of every enabled CS
+    for (n = 0; n < EIM_CS_MAX; n++)
     {
-        iounmap(mdev->eim_mem_base);
-        release_mem_region(EIM_MEM_BASE, EIM_MEM_LEN);
+        eim_cs *ecs = mdev->cs[n];
+        if (ecs && ecs->eim_mem_base)
+        {
+            iounmap(ecs->eim_mem_base);
+            release_mem_region(ecs->mem_phys, ecs->mem_len);
+            ecs->eim_mem_base = NULL;
+        }
     }
 
 	// eim_base
@@ -301,6 +636,7 @@ static void eim_unmap(void)
     {
         iounmap(mdev->eim_base);
         release_mem_region(EIM_BASE, EIM_LEN);
+        mdev->eim_base = NULL;
     }
 
 	// ccm_base
@@ -344,219 +680,1304 @@ static u32 bitfield(int shift, int bits, int val)
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function completes eim iomux configuration.
+// 	   This function gets the current port width of one chip select.
 // Parameters :
-//     eim_mum - eim iomux mode (1 is mux and 0 is NOT mux)
+//     ecs - eim chip select
 // Return Value :
-//     0 - eim_config success.
+//     1 / 2 / 4 - bytes per bus word (CSxGCR1 DSZ)
+//     0 - reserved DSZ value
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static int eim_port_bytes(eim_cs *ecs)
+{
+    u32 csxgcr1_rreg = 0;
+
+    csxgcr1_rreg = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    return eim_timing_port_bytes(eim_timing_field(csxgcr1_rreg, 16, 3));
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the window alignment of the CPU copies.
+// Parameters :
+//     ecs - eim chip select
+// Return Value :
+//     alignment in bytes (burst or page size, see eim_copy.h)
 // Errors :
 //     None.
 // -------------------------------------------------------------
-static int eim_iomux(int eim_mum)
+static size_t eim_copy_align_cs(eim_cs *ecs)
+{
+    u32 gcr1 = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    u32 rcr2 = ioread32(ecs->cs_base + EIM_CS_RCR2);
+
+    return eim_copy_align((gcr1 >> 8) & 0x7, (gcr1 >> 28) & 0xF, (rcr2 >> 15) & 0x1, eim_port_bytes(ecs));
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function copies a user buffer into a CS window by the CPU
+//     (called with the chip select lock held).
+// Parameters :
+//     ecs - eim chip select
+//     buf - buffer pointer in user space
+//     count - the number of bytes (no more than the window, even with copy16)
+// Return Value :
+//     0 - eim_copy_to_window success.
+// Errors :
+//     -EFAULT - copy_from_user failed
+//     -EINVAL - odd count, the window takes no byte stores (copy16)
+// -------------------------------------------------------------
+static int eim_copy_to_window(eim_cs *ecs, const char __user *buf, size_t count)
 {
-    if (1 == eim_mum)
+    size_t align = 0;
+    size_t done = 0;
+
+    if (!copy16)
     {
-        mxc_iomux_v3_setup_multiple_pads(eim_mux_pads, ARRAY_SIZE(eim_mux_pads));
+        return copy_from_user((void *)ecs->eim_mem_base, buf, count) ? -EFAULT : 0;
     }
-    else if (0 == eim_mum)
+    if (count & 1)
     {
-        mxc_iomux_v3_setup_multiple_pads(eim_nomux_pads, ARRAY_SIZE(eim_nomux_pads));
+        return -EINVAL;
     }
-    else
+
+    // bounce chunks are a multiple of the alignment, so every chunk after
+    // the first starts on a burst boundary
+    align = eim_copy_align_cs(ecs);
+    while (done < count)
     {
-    	printk(KERN_ERR "< eim.c > eim_iomux : the input is invalid. It should be 0 or 1.\n");
-    	return -EFAULT;
+        size_t n = min(count - done, (size_t)EIM_BOUNCE_LEN);
+        if (copy_from_user(ecs->bounce, buf + done, n))
+        {
+            return -EFAULT;
+        }
+        eim_copy_toio16((volatile void *)(ecs->eim_mem_base + done), ecs->bounce, n, align);
+        done += n;
     }
+
     return 0;
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function completes eim-related registers configuration.
+// 	   This function copies a CS window into a user buffer by the CPU
+//     (called with the chip select lock held).
+// Parameters :
+//     ecs - eim chip select
+//     buf - buffer pointer in user space
+//     count - the number of bytes (no more than the window)
+// Return Value :
+//     0 - eim_copy_from_window success.
+// Errors :
+//     -EFAULT - copy_to_user failed
+// -------------------------------------------------------------
+static int eim_copy_from_window(eim_cs *ecs, char __user *buf, size_t count)
+{
+    size_t align = 0;
+    size_t done = 0;
+
+    if (!copy16)
+    {
+        return copy_to_user(buf, (void *)ecs->eim_mem_base, count) ? -EFAULT : 0;
+    }
+
+    align = eim_copy_align_cs(ecs);
+    while (done < count)
+    {
+        size_t n = min(count - done, (size_t)EIM_BOUNCE_LEN);
+        eim_copy_fromio16(ecs->bounce, (const volatile void *)(ecs->eim_mem_base + done), n, align);
+        if (copy_to_user(buf + done, ecs->bounce, n))
+        {
+            return -EFAULT;
+        }
+        done += n;
+    }
+
+    return 0;
+}
+
+#ifndef EIM_HOST_BUILD
+// ------------------------------------------------------------
+// Description :
+// 	   This function adds pads to the wanted pad list, a later setting of
+//     the same pad replaces the earlier one.
+// Parameters :
+//     pads - pad table
+//     cnt - the number of pads
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_iomux_want(const iomux_v3_cfg_t *pads, int cnt)
+{
+    int i = 0;
+    int j = 0;
+
+    for (i = 0; i < cnt; i++)
+    {
+        for (j = 0; j < mdev->pad_want_cnt; j++)
+        {
+            if ((mdev->pad_want[j] & MUX_CTRL_OFS_MASK) == (pads[i] & MUX_CTRL_OFS_MASK))
+            {
+                break;
+            }
+        }
+        if (j == mdev->pad_want_cnt)
+        {
+            if (mdev->pad_want_cnt >= EIM_PAD_MAX)
+            {
+                printk(KERN_ERR "< eim.c > eim_iomux_want : too many pads.\n");
+                return;
+            }
+            mdev->pad_want_cnt++;
+        }
+        mdev->pad_want[j] = pads[i];
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function sets up the wanted pads which differ from the pad state
+//     (every wanted pad when iomux_lazy is 0).
 // Parameters :
 //     None.
 // Return Value :
-//     0 - eim_config success.
+//     the number of pads set up
 // Errors :
 //     None.
 // -------------------------------------------------------------
-static int eim_config(void)
+static int eim_iomux_apply(void)
 {
-    u32 iomuxc_gpr1_wreg = 0;
-	u32 cs1gpr1_wreg = 0;
-	u32 cs1gpr2_wreg = 0;
-	u32 cs1crc1_wreg = 0;
-	u32 cs1crc2_wreg = 0;
-	u32 cs1wrc1_wreg = 0;
-	u32 cs1wrc2_wreg = 0;
-    u32 ccm_ccgr6_rreg = 0;
-    u32 ccm_ccgr6_wreg = 0;
-    int ret_eim_iomux = 0;
+    int set = 0;
+    int i = 0;
+    int j = 0;
+
+    for (i = 0; i < mdev->pad_want_cnt; i++)
+    {
+        iomux_v3_cfg_t pad = mdev->pad_want[i];
+
+        for (j = 0; j < mdev->pad_state_cnt; j++)
+        {
+            if ((mdev->pad_state[j] & MUX_CTRL_OFS_MASK) == (pad & MUX_CTRL_OFS_MASK))
+            {
+                break;
+            }
+        }
+        if (iomux_lazy && (j < mdev->pad_state_cnt) && (mdev->pad_state[j] == pad))
+        {
+            continue;
+        }
+
+        mxc_iomux_v3_setup_pad(pad);
+        set++;
+        if (j == mdev->pad_state_cnt)
+        {
+            if (mdev->pad_state_cnt >= EIM_PAD_MAX)
+            {
+                continue;
+            }
+            mdev->pad_state_cnt++;
+        }
+        mdev->pad_state[j] = pad;
+    }
+
+    return set;
+}
+#endif
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function completes eim iomux configuration.
+//     The data / address pads are shared by all chip selects, so the
+//     pads of every MUM / port size in use are wanted together, and
+//     only the pads that differ from the current setting are touched.
+//     A program download in progress keeps the FPP GPIOs (eim_fpp_lock).
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_iomux success.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static int eim_iomux(void)
+{
+    int use_mux = 0;
+    int use_nomux = 0;
+    int use_d32 = 0;
+    int n = 0;
+
+    // no pads to configure in loopback mode
+    if (loopback)
+    {
+        mdev->pad_set_cnt = 0;
+        return 0;
+    }
+
+    mutex_lock(&mdev->eim_fpp_lock);
+    mutex_lock(&mdev->eim_iomux_lock);
+    for (n = 0; n < EIM_CS_MAX; n++)
+    {
+        eim_cs *ecs = mdev->cs[n];
+        if (!ecs)
+        {
+            continue;
+        }
+        if (eim_timing_field(ioread32(ecs->cs_base + EIM_CS_GCR1), 3, 1))
+        {
+            use_mux = 1;
+        }
+        else
+        {
+            use_nomux = 1;
+        }
+        if (4 == eim_port_bytes(ecs))
+        {
+            use_d32 = 1;
+        }
+    }
+
+#ifndef EIM_HOST_BUILD
+    mdev->pad_want_cnt = 0;
+    if (use_mux)
+    {
+        eim_iomux_want(eim_mux_pads, ARRAY_SIZE(eim_mux_pads));
+    }
+    if (use_nomux)
+    {
+        eim_iomux_want(eim_nomux_pads, ARRAY_SIZE(eim_nomux_pads));
+    }
+
+    // DATA[31:16] take over EIM_D16 - EIM_D31 (FPP GPIOs included)
+    if (use_d32)
+    {
+        eim_iomux_want(eim_d32_pads, ARRAY_SIZE(eim_d32_pads));
+    }
+
+    // chip selects
+    for (n = 0; n < EIM_CS_MAX; n++)
+    {
+        if (mdev->cs[n])
+        {
+            eim_iomux_want(&eim_cs_pads[n], 1);
+        }
+    }
 
-    // set register IOMUXC_GPR1 as CS1(64M) --- ref : IMX6DQRM p1903
-    int ADDRS1 	= 1;
-    int ACT_CS1 = 1;
-    int ADDRS0 	= 1;
-    int ACT_CS0 = 1;
+    mdev->pad_set_cnt = eim_iomux_apply();
+#endif
+    mdev->pads_d32 = use_d32;
+    mutex_unlock(&mdev->eim_iomux_lock);
+    mutex_unlock(&mdev->eim_fpp_lock);
+
+    return 0;
+}
+
+// CS timing register field (reg : 0 GCR1, 1 GCR2, 2 RCR1, 3 RCR2, 4 WCR1, 5 WCR2)
+typedef struct _eim_cs_field
+{
+    const char *name;
+    int offset;         // offset in struct eim_cs_config
+    int reg;
+    int shift;
+    int bits;
+    int min;
+    int max;
+}eim_cs_field;
+
+#define EIM_CS_FIELD(field, reg, shift, bits, min, max) \
+    { #field, offsetof(struct eim_cs_config, field), reg, shift, bits, min, max }
+
+static const eim_cs_field eim_cs_fields[] = {
+    // CSxGCR1
+    EIM_CS_FIELD(PSZ,   0, 28, 4, 0, 15),
+    EIM_CS_FIELD(WP,    0, 27, 1, 0, 1),
+    EIM_CS_FIELD(GBC,   0, 24, 3, 0, 7),
+    EIM_CS_FIELD(AUS,   0, 23, 1, 0, 1),
+    EIM_CS_FIELD(CSREC, 0, 20, 3, 0, 7),
+    EIM_CS_FIELD(SP,    0, 19, 1, 0, 1),
+    EIM_CS_FIELD(DSZ,   0, 16, 3, 1, 7),
+    EIM_CS_FIELD(BCS,   0, 14, 2, 0, 3),
+    EIM_CS_FIELD(BCD,   0, 12, 2, 0, 3),
+    EIM_CS_FIELD(WC,    0, 11, 1, 0, 1),
+    EIM_CS_FIELD(BL,    0, 8,  3, 0, 4),
+    EIM_CS_FIELD(CREP,  0, 7,  1, 0, 1),
+    EIM_CS_FIELD(CRE,   0, 6,  1, 0, 1),
+    EIM_CS_FIELD(RFL,   0, 5,  1, 0, 1),
+    EIM_CS_FIELD(WFL,   0, 4,  1, 0, 1),
+    EIM_CS_FIELD(MUM,   0, 3,  1, 0, 1),
+    EIM_CS_FIELD(SRD,   0, 2,  1, 0, 1),
+    EIM_CS_FIELD(SWR,   0, 1,  1, 0, 1),
+    EIM_CS_FIELD(CSEN,  0, 0,  1, 0, 1),
+    // CSxGCR2
+    EIM_CS_FIELD(M16BG, 1, 12, 1, 0, 1),
+    EIM_CS_FIELD(DAP,   1, 9,  1, 0, 1),
+    EIM_CS_FIELD(DAE,   1, 8,  1, 0, 1),
+    EIM_CS_FIELD(DAPS,  1, 4,  4, 0, 15),
+    EIM_CS_FIELD(ADH,   1, 0,  2, 0, 3),
+    // CSxRCR1
+    EIM_CS_FIELD(RWSC,  2, 24, 6, 0, 63),
+    EIM_CS_FIELD(RADVA, 2, 20, 3, 0, 7),
+    EIM_CS_FIELD(RAL,   2, 19, 1, 0, 1),
+    EIM_CS_FIELD(RADVN, 2, 16, 3, 0, 7),
+    EIM_CS_FIELD(OEA,   2, 12, 3, 0, 7),
+    EIM_CS_FIELD(OEN,   2, 8,  3, 0, 7),
+    EIM_CS_FIELD(RCSA,  2, 4,  3, 0, 7),
+    EIM_CS_FIELD(RCSN,  2, 0,  3, 0, 7),
+    // CSxRCR2
+    EIM_CS_FIELD(APR,   3, 15, 1, 0, 1),
+    EIM_CS_FIELD(PAT,   3, 12, 3, 0, 7),
+    EIM_CS_FIELD(RL,    3, 8,  2, 0, 3),
+    EIM_CS_FIELD(RBEA,  3, 4,  3, 0, 7),
+    EIM_CS_FIELD(RBE,   3, 3,  1, 0, 1),
+    EIM_CS_FIELD(RBEN,  3, 0,  3, 0, 7),
+    // CSxWCR1
+    EIM_CS_FIELD(WAL,   4, 31, 1, 0, 1),
+    EIM_CS_FIELD(WBED,  4, 30, 1, 0, 1),
+    EIM_CS_FIELD(WWSC,  4, 24, 6, 0, 63),
+    EIM_CS_FIELD(WADVA, 4, 21, 3, 0, 7),
+    EIM_CS_FIELD(WADVN, 4, 18, 3, 0, 7),
+    EIM_CS_FIELD(WBEA,  4, 15, 3, 0, 7),
+    EIM_CS_FIELD(WBEN,  4, 12, 3, 0, 7),
+    EIM_CS_FIELD(WEA,   4, 9,  3, 0, 7),
+    EIM_CS_FIELD(WEN,   4, 6,  3, 0, 7),
+    EIM_CS_FIELD(WCSA,  4, 3,  3, 0, 7),
+    EIM_CS_FIELD(WCSN,  4, 0,  3, 0, 7),
+    // CSxWCR2
+    EIM_CS_FIELD(WBCDD, 5, 0,  1, 0, 1),
+};
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function fills the built-in CS timing configuration.
+// Parameters :
+//     cfg - CS timing configuration
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_default_config(struct eim_cs_config *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
 
 	// set register CS1GCR1 --- ref : IMX6DQRM p1038-1041
-    int PSZ 	= 0;	// Page Size - 8 words page size
-	int WP 		= 0;	// Write Protect - allowed
-    int GBC 	= 1;	// Gap Between CS - 1 EIM clock cycle
-    int AUS		= 0;	// Address Unshifted - shifted
-    int CSREC 	= 1;	// CS Recovery - 1 EIM clock cycle
-    int SP 		= 0;	// Supervisor Protect - allowded
-    int DSZ 	= 1;	// Port Size - 16 bit port resides on DATA[15:0]
-    int BCS 	= 1;	// Wait Cycle Brfore Burst Clock Start - 1 EIM clock cycle
-    int BCD 	= 3;	// Burst Clock Divisor - 0(132M) 1(66M) 2(44M) 3(33M)
-    int WC 		= 0;	// Write Continuous - according to BL value
-    int BL 		= 3;	// Burst Length - 32 words Memory wrap burst length
-    int CREP 	= 0;	// Configuration Register Enable Polarity - NC
-    int CRE 	= 0;	// Configuration Register Enable - disabled
-    int RFL 	= 1;	// Read Fix Latency
-    int WFL 	= 1;	// Write Fix Latency
-    int MUM 	= 1;	// Multiplexed Mode
-    int SRD 	= 1;	// Synchronous Read Data
-    int SWR 	= 1;	// Synchronous Write Data
-    int CSEN 	= 1;	// CS Enable
+    cfg->PSZ 	= 0;	// Page Size - 8 words page size
+	cfg->WP 	= 0;	// Write Protect - allowed
+    cfg->GBC 	= 1;	// Gap Between CS - 1 EIM clock cycle
+    cfg->AUS	= 0;	// Address Unshifted - shifted by port size (word address on the bus)
+    cfg->CSREC 	= 1;	// CS Recovery - 1 EIM clock cycle
+    cfg->SP 	= 0;	// Supervisor Protect - allowded
+    cfg->DSZ 	= 1;	// Port Size - 16 bit port resides on DATA[15:0]
+    cfg->BCS 	= 1;	// Wait Cycle Brfore Burst Clock Start - 1 EIM clock cycle
+    cfg->BCD 	= 3;	// Burst Clock Divisor - 0(132M) 1(66M) 2(44M) 3(33M)
+    cfg->WC 	= 0;	// Write Continuous - according to BL value
+    cfg->BL 	= 3;	// Burst Length - 32 words Memory wrap burst length
+    cfg->CREP 	= 0;	// Configuration Register Enable Polarity - NC
+    cfg->CRE 	= 0;	// Configuration Register Enable - disabled
+    cfg->RFL 	= 1;	// Read Fix Latency
+    cfg->WFL 	= 1;	// Write Fix Latency
+    cfg->MUM 	= 1;	// Multiplexed Mode
+    cfg->SRD 	= 1;	// Synchronous Read Data
+    cfg->SWR 	= 1;	// Synchronous Write Data
+    cfg->CSEN 	= 1;	// CS Enable
 
 	// set register CS1GCR2 --- ref : IMX6DQRM p1042-1043
-    int M16BG   = 1;	// Muxed 16 bypass grant - EIM ignores the grant signal
-	int DAP     = 0;	// Data Acknowledge Polarity
-    int DAE     = 0;	// Data Acknowledge Enable
-    int DAPS    = 0;	// Data Acknowledge Poling Start
-    int ADH     = 0;	// Address Hold Time
+    cfg->M16BG  = 1;	// Muxed 16 bypass grant - EIM ignores the grant signal
+	cfg->DAP    = 0;	// Data Acknowledge Polarity
+    cfg->DAE    = 0;	// Data Acknowledge Enable
+    cfg->DAPS   = 0;	// Data Acknowledge Poling Start
+    cfg->ADH    = 0;	// Address Hold Time
 
     // set register CS1RCR1 --- ref : IMX6DQRM p1043-1045
-    int RWSC 	= 3;	// Read Wait State Control - The first 3 burst clocks are ignored
-	int RADVA 	= 0;	// ADV Assertion
-	int RAL		= 0;	// Read ADV Low
-	int RADVN	= 0;	// ADV Negtation
-	int OEA		= 0;	// OE Assertion
-	int OEN		= 0;	// OE Negtation
-	int RCSA	= 0;	// Read CS Assertion
-	int RCSN	= 0;	// Read CS Negation
+    cfg->RWSC 	= 3;	// Read Wait State Control - The first 3 burst clocks are ignored
+	cfg->RADVA 	= 0;	// ADV Assertion
+	cfg->RAL	= 0;	// Read ADV Low
+	cfg->RADVN	= 0;	// ADV Negtation
+	cfg->OEA	= 0;	// OE Assertion
+	cfg->OEN	= 0;	// OE Negtation
+	cfg->RCSA	= 0;	// Read CS Assertion
+	cfg->RCSN	= 0;	// Read CS Negation
 
     // set register CS1RCR2 --- ref : IMX6DQRM p1046-1047
-    int APR 	= 0;	// Asynchronous Page Read
-	int PAT 	= 7;	// Page Access Time - Address width is 9 EIM clock cycles
-	int RL		= 0;	// Read Latency
-	int RBEA	= 0;	// Read BE Assertion
-	int RBE		= 0;	// Read BE enable
-	int RBEN	= 0;	// Read BE Negation
+    cfg->APR 	= 0;	// Asynchronous Page Read
+	cfg->PAT 	= 7;	// Page Access Time - Address width is 9 EIM clock cycles
+	cfg->RL		= 0;	// Read Latency
+	cfg->RBEA	= 0;	// Read BE Assertion
+	cfg->RBE	= 0;	// Read BE enable
+	cfg->RBEN	= 0;	// Read BE Negation
 
 	// set register CS1WCR1 --- ref : IMX6DQRM p1047-1050
-    int WAL 	= 0;	// Write ADV Low
-	int WBED 	= 0;	// Write Byte Enable Disable
-	int WWSC	= 1;	// Write Wait State Control - The first burst clock is ignored
-	int WADVA	= 0;	// ADV Assertion
-	int WADVN	= 0;	// ADV Negation
-	int WBEA	= 0;	// BE Assertion
-	int WBEN	= 0;	// BE[3:0] Negation
-	int WEA		= 0;	// WE Assertion
-	int WEN		= 0;	// WE Negation
-	int WCSA	= 0;	// Write CS Assertion
-	int WCSN	= 0;	// Write CS Negation
+    cfg->WAL 	= 0;	// Write ADV Low
+	cfg->WBED 	= 0;	// Write Byte Enable Disable
+	cfg->WWSC	= 1;	// Write Wait State Control - The first burst clock is ignored
+	cfg->WADVA	= 0;	// ADV Assertion
+	cfg->WADVN	= 0;	// ADV Negation
+	cfg->WBEA	= 0;	// BE Assertion
+	cfg->WBEN	= 0;	// BE[3:0] Negation
+	cfg->WEA	= 0;	// WE Assertion
+	cfg->WEN	= 0;	// WE Negation
+	cfg->WCSA	= 0;	// Write CS Assertion
+	cfg->WCSN	= 0;	// Write CS Negation
 
     // set register CS1WCR2 --- ref : IMX6DQRM p1050
-    int WBCDD 	= 0;	// Write Burst Clock Divisor Decrement, NC
+    cfg->WBCDD 	= 0;	// Write Burst Clock Divisor Decrement, NC
 
-    // enable eim clock --- ref : IMX6DQRM p894-895
-    int EC = 3;	        // EIM Clock
+    // port size from module parameter
+    if (8 == port_width)
+    {
+        cfg->DSZ = 4;   // 8 bit port resides on DATA[7:0]
+    }
+    else if (32 == port_width)
+    {
+        cfg->DSZ = 3;   // 32 bit port resides on DATA[31:0]
+    }
+    else if (16 != port_width)
+    {
+        printk(KERN_ERR "< eim.c > eim_default_config : port_width %d is invalid, use 16.\n", port_width);
+    }
 
-    // IOMUXC_GPR1
-    iomuxc_gpr1_wreg = bitfield(4, 2, ADDRS1) |
-    	      	 	   bitfield(3, 1, ACT_CS1) |
-    	       		   bitfield(1, 2, ADDRS0) |
-    	       		   bitfield(0, 1, ACT_CS0);
-    mxc_iomux_set_gpr_register(1, 0, 6, iomuxc_gpr1_wreg);
-
-	// CS1GCR1
-	cs1gpr1_wreg = bitfield(28, 4, PSZ) |
-				   bitfield(27, 1, WP) |
-				   bitfield(24, 3, GBC) |
-				   bitfield(23, 1, AUS) |
-				   bitfield(20, 3, CSREC) |
-				   bitfield(19, 1, SP) |
-				   bitfield(16, 3, DSZ) |
-				   bitfield(14, 2, BCS) |
-				   bitfield(12, 2, BCD) |
-				   bitfield(11, 1, WC) |
-				   bitfield(8, 3, BL) |
-				   bitfield(7, 1, CREP) |
-				   bitfield(6, 1, CRE) |
-				   bitfield(5, 1, RFL) |
-				   bitfield(4, 1, WFL) |
-				   bitfield(3, 1, MUM) |
-				   bitfield(2, 1, SRD) |
-				   bitfield(1, 1, SWR) |
-				   bitfield(0, 1, CSEN);
-    iowrite32(cs1gpr1_wreg, mdev->eim_base + 0x18);
-
-	// CS1GCR2
-	cs1gpr2_wreg = bitfield(12, 1, M16BG) |
-				   bitfield(9, 1, DAP) |
-				   bitfield(8, 3, DAE) |
-				   bitfield(4, 4, DAPS) |
-				   bitfield(0, 2, ADH);
-    iowrite32(cs1gpr2_wreg, mdev->eim_base + 0x1C);
-
-    // CS1RCR1
-	cs1crc1_wreg = bitfield(24, 6, RWSC) |
-				   bitfield(20, 3, RADVA) |
-				   bitfield(19, 1, RAL) |
-				   bitfield(16, 3, RADVN) |
-				   bitfield(12, 3, OEA) |
-				   bitfield(8, 3, OEN) |
-				   bitfield(4, 3, RCSA) |
-				   bitfield(0, 3, RCSN);
-    iowrite32(cs1crc1_wreg, mdev->eim_base + 0x20);
-
-    // CS1RCR2
-	cs1crc2_wreg = bitfield(15, 1, APR) |
-				   bitfield(12, 3, PAT) |
-				   bitfield(8, 2, RL) |
-				   bitfield(4, 3, RBEA) |
-				   bitfield(3, 1, RBE) |
-				   bitfield(0, 3, RBEN);
-    iowrite32(cs1crc2_wreg, mdev->eim_base + 0x24);
-
-	// CS1WCR1
-	cs1wrc1_wreg = bitfield(31, 1, WAL) |
-				   bitfield(30, 1, WBED) |
-		 		   bitfield(24, 6, WWSC) |
-		 		   bitfield(21, 3, WADVA) |
-		 		   bitfield(18, 3, WADVN) |
-		 		   bitfield(15, 3, WBEA) |
-		 		   bitfield(12, 3, WBEN) |
-				   bitfield(9, 3, WEA) |
-				   bitfield(6, 3, WEN) |
-				   bitfield(3, 3, WCSA ) |
-				   bitfield(0, 3, WCSN);
-    iowrite32(cs1wrc1_wreg, mdev->eim_base + 0x28);
-
-    // CS1WCR2
-	cs1wrc2_wreg = bitfield(0, 1, WBCDD);
-    iowrite32(cs1wrc2_wreg, mdev->eim_base + 0x2C);
+    // tuned timing from module parameters
+    if (bcd >= 0 && bcd <= 3)
+    {
+        cfg->BCD = bcd;
+    }
+    if (bl >= 0 && bl <= 4)
+    {
+        cfg->BL = bl;
+    }
+    if (rwsc >= 0 && rwsc <= 63)
+    {
+        cfg->RWSC = rwsc;
+    }
+    if (wwsc >= 0 && wwsc <= 63)
+    {
+        cfg->WWSC = wwsc;
+    }
+}
 
-    // enable eim clock
-    ccm_ccgr6_rreg = ioread32(mdev->ccm_base + 0x80);
-    ccm_ccgr6_wreg = bitfield(10, 2, EC);
-    iowrite32(ccm_ccgr6_rreg | ccm_ccgr6_wreg, mdev->ccm_base + 0x80);
+// ------------------------------------------------------------
+// Description :
+// 	   This function checks the value range of every timing field.
+// Parameters :
+//     cfg - CS timing configuration
+// Return Value :
+//     0 - all fields are valid.
+// Errors :
+//     -EINVAL - one field is out of range.
+// -------------------------------------------------------------
+static int eim_config_check(const struct eim_cs_config *cfg)
+{
+    int i = 0;
 
-    // eim iomux configuration
-    ret_eim_iomux = eim_iomux(MUM);
-    if (ret_eim_iomux)
+    for (i = 0; i < ARRAY_SIZE(eim_cs_fields); i++)
+    {
+        const eim_cs_field *fd = &eim_cs_fields[i];
+        int val = *(const int *)((const char *)cfg + fd->offset);
+        if (val < fd->min || val > fd->max)
+        {
+            printk(KERN_ERR "< eim.c > eim_config_check : %s = %d is out of range [%d, %d].\n",
+                    fd->name, val, fd->min, fd->max);
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function encodes a timing configuration into CSx register words.
+// Parameters :
+//     cfg - CS timing configuration (checked by eim_config_check)
+//     wreg - CSxGCR1 / GCR2 / RCR1 / RCR2 / WCR1 / WCR2 words
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_config_encode(const struct eim_cs_config *cfg, u32 *wreg)
+{
+    int i = 0;
+
+    memset(wreg, 0, sizeof(u32) * EIM_CS_REG_CNT);
+    for (i = 0; i < ARRAY_SIZE(eim_cs_fields); i++)
+    {
+        const eim_cs_field *fd = &eim_cs_fields[i];
+        int val = *(const int *)((const char *)cfg + fd->offset);
+        wreg[fd->reg] |= bitfield(fd->shift, fd->bits, val);
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes a timing configuration to the CSx registers.
+// Parameters :
+//     ecs - eim chip select
+//     cfg - CS timing configuration (checked by eim_config_check)
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_config_write(eim_cs *ecs, const struct eim_cs_config *cfg)
+{
+    u32 wreg[EIM_CS_REG_CNT] = {0};
+    int i = 0;
+
+    eim_config_encode(cfg, wreg);
+    for (i = 0; i < EIM_CS_REG_CNT; i++)
+    {
+        iowrite32(wreg[i], ecs->cs_base + i * 4);
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function reads the timing configuration from the CSx registers.
+// Parameters :
+//     ecs - eim chip select
+//     cfg - CS timing configuration
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_config_read(eim_cs *ecs, struct eim_cs_config *cfg)
+{
+    u32 rreg[EIM_CS_REG_CNT] = {0};
+    int i = 0;
+
+    for (i = 0; i < EIM_CS_REG_CNT; i++)
+    {
+        rreg[i] = ioread32(ecs->cs_base + i * 4);
+    }
+
+    memset(cfg, 0, sizeof(*cfg));
+    for (i = 0; i < ARRAY_SIZE(eim_cs_fields); i++)
+    {
+        const eim_cs_field *fd = &eim_cs_fields[i];
+        *(int *)((char *)cfg + fd->offset) = (rreg[fd->reg] >> fd->shift) & ((1 << fd->bits) - 1);
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function reports the CPU / SDMA cutoffs in a configuration.
+// Parameters :
+//     cfg - CS timing configuration
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_cutoff_read(struct eim_cs_config *cfg)
+{
+    cfg->dma_read_cutoff = (dma_read_cutoff < 0) ? EIM_CUTOFF_CPU_ONLY : dma_read_cutoff;
+    cfg->dma_write_cutoff = (dma_cutoff < 0) ? EIM_CUTOFF_CPU_ONLY : dma_cutoff;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function overrides the CPU / SDMA cutoffs from a configuration
+//     (0 keeps a cutoff, a negative value selects CPU copies only).
+// Parameters :
+//     cfg - CS timing configuration
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_cutoff_write(const struct eim_cs_config *cfg)
+{
+    if (cfg->dma_read_cutoff)
+    {
+        dma_read_cutoff = (cfg->dma_read_cutoff < 0) ? EIM_CUTOFF_CPU_ONLY : cfg->dma_read_cutoff;
+    }
+    if (cfg->dma_write_cutoff)
+    {
+        dma_cutoff = (cfg->dma_write_cutoff < 0) ? EIM_CUTOFF_CPU_ONLY : cfg->dma_write_cutoff;
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function precomputes the mode profiles of one chip select.
+//     A profile owns MUM and WWSC only, so EIM_IOC_SET_CONFIG, the port
+//     size and the BCD / BL / RWSC sysfs survive a profile switch.
+// Parameters :
+//     ecs - eim chip select
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_profile_init(eim_cs *ecs)
+{
+    eim_profile *prof = NULL;
+    int i = 0;
+
+    for (i = 0; i < EIM_PROFILE_CNT; i++)
+    {
+        prof = &ecs->profile[i];
+        memset(prof, 0, sizeof(*prof));
+        prof->mask[EIM_CS_GCR1 / 4] = bitfield(3, 1, 1);
+        prof->mask[EIM_CS_WCR1 / 4] = bitfield(24, 6, 63);
+    }
+
+    // parameters : EIM_MUX, WWSC 5 clocks (or the tuned wwsc)
+    prof = &ecs->profile[EIM_PROFILE_PARAMETERS];
+    prof->dmode = DOWNLOAD_PARAMETERS;
+    prof->val[EIM_CS_GCR1 / 4] = bitfield(3, 1, 1);
+    prof->val[EIM_CS_WCR1 / 4] = bitfield(24, 6, (wwsc >= 0 && wwsc <= 63) ? wwsc : 1);
+
+    // program : EIM_NOMUX, WWSC 4 clocks
+    prof = &ecs->profile[EIM_PROFILE_PROGRAM];
+    prof->dmode = DOWNLOAD_PROGRAM;
+    prof->val[EIM_CS_GCR1 / 4] = bitfield(3, 1, 0);
+    prof->val[EIM_CS_WCR1 / 4] = bitfield(24, 6, 0);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function switches one chip select to a mode profile, merging
+//     the profile fields into the live registers, writing only the
+//     registers that differ and setting up only the pads that differ
+//     (called with the chip select lock held).
+// Parameters :
+//     ecs - eim chip select
+//     id - EIM_PROFILE_*
+// Return Value :
+//     0 - eim_profile_apply success.
+// Errors :
+//     -EINVAL - unknown profile
+// -------------------------------------------------------------
+static int eim_profile_apply(eim_cs *ecs, int id)
+{
+    const eim_profile *prof = NULL;
+    ktime_t start;
+    u32 mum_mask = bitfield(3, 1, 1) | bitfield(16, 3, 7);
+    int pads_changed = 0;
+    int regs = 0;
+    int i = 0;
+
+    if ((id < 0) || (id >= EIM_PROFILE_CNT))
+    {
+        printk(KERN_ERR "< eim.c > eim_profile_apply : unknown profile %d.\n", id);
+        return -EINVAL;
+    }
+    prof = &ecs->profile[id];
+
+    start = ktime_get();
+    for (i = 0; i < EIM_CS_REG_CNT; i++)
+    {
+        u32 rreg = 0;
+        u32 wreg = 0;
+        if (!prof->mask[i])
+        {
+            continue;
+        }
+        rreg = ioread32(ecs->cs_base + i * 4);
+        wreg = (rreg & ~prof->mask[i]) | prof->val[i];
+        if (rreg == wreg)
+        {
+            continue;
+        }
+        // MUM / DSZ decide the pads
+        if ((0 == i) && ((rreg ^ wreg) & mum_mask))
+        {
+            pads_changed = 1;
+        }
+        iowrite32(wreg, ecs->cs_base + i * 4);
+        regs++;
+    }
+    ecs->eim_dmode = prof->dmode;
+
+    mdev->pad_set_cnt = 0;
+    if (pads_changed)
+    {
+        eim_iomux();
+    }
+
+    ecs->profile_stats.profile = id;
+    ecs->profile_stats.switches++;
+    ecs->profile_stats.last_regs = regs;
+    ecs->profile_stats.last_pads = mdev->pad_set_cnt;
+    ecs->profile_stats.last_ns = (unsigned int)ktime_to_ns(ktime_sub(ktime_get(), start));
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function completes eim-related registers configuration.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_config success.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static int eim_config(void)
+{
+    struct eim_cs_config cfg;
+    u32 iomuxc_gpr1_wreg = 0;
+    u32 ccm_ccgr6_rreg = 0;
+    u32 ccm_ccgr6_wreg = 0;
+    int ret_eim_iomux = 0;
+    int cs_cnt = 0;
+    int n = 0;
+
+    // set register IOMUXC_GPR1 --- ref : IMX6DQRM p1903
+    // CS0(64M) + CS1(64M), or CS0 - CS3 (32M each) once CS2 / CS3 are enabled
+    int ADDRS 	= (cs_mask & 0xC) ? 0 : 1;
+    int ACT_CS  = 1;
+
+    // enable eim clock --- ref : IMX6DQRM p894-895
+    int EC = 3;	        // EIM Clock
+
+    // IOMUXC_GPR1 (CSn : ACT_CS bit 3n, ADDRS bits 3n+2 - 3n+1)
+    cs_cnt = (cs_mask & 0xC) ? EIM_CS_MAX : 2;
+    for (n = 0; n < cs_cnt; n++)
+    {
+        iomuxc_gpr1_wreg |= bitfield(3 * n + 1, 2, ADDRS) |
+                            bitfield(3 * n, 1, ACT_CS);
+    }
+#ifndef EIM_HOST_BUILD
+    if (!loopback)
+    {
+        mxc_iomux_set_gpr_register(1, 0, 3 * cs_cnt, iomuxc_gpr1_wreg);
+    }
+#endif
+
+    // CSxGCR1 / CSxGCR2 / CSxRCR1 / CSxRCR2 / CSxWCR1 / CSxWCR2
+    eim_default_config(&cfg);
+    if (eim_config_check(&cfg))
+    {
+        return -EINVAL;
+    }
+    for (n = 0; n < EIM_CS_MAX; n++)
+    {
+        if (mdev->cs[n])
+        {
+            eim_config_write(mdev->cs[n], &cfg);
+            eim_profile_init(mdev->cs[n]);
+        }
+    }
+
+    // enable eim clock
+    ccm_ccgr6_rreg = ioread32(mdev->ccm_base + 0x80);
+    ccm_ccgr6_wreg = bitfield(10, 2, EC);
+    iowrite32(ccm_ccgr6_rreg | ccm_ccgr6_wreg, mdev->ccm_base + 0x80);
+
+    // eim iomux configuration
+    ret_eim_iomux = eim_iomux();
+    if (ret_eim_iomux)
+    {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function emulates the EIM bus time of a loopback transfer.
+// Parameters :
+//     ecs - eim chip select
+//     count - the number of bytes transferred
+//     is_read - 1 for read bursts and 0 for write bursts
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_loopback_delay(eim_cs *ecs, int count, int is_read)
+{
+    struct eim_timing_regs regs;
+    struct eim_timing_fields f;
+    struct eim_timing_burst b;
+    unsigned long long ns = 0;
+    int bursts = 0;
+
+    regs.gcr1 = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    regs.gcr2 = ioread32(ecs->cs_base + EIM_CS_GCR2);
+    regs.rcr1 = ioread32(ecs->cs_base + EIM_CS_RCR1);
+    regs.rcr2 = ioread32(ecs->cs_base + EIM_CS_RCR2);
+    regs.wcr1 = ioread32(ecs->cs_base + EIM_CS_WCR1);
+    regs.wcr2 = ioread32(ecs->cs_base + EIM_CS_WCR2);
+    eim_timing_decode(&regs, &f);
+    eim_timing_predict(&f, &b);
+    if (b.bytes <= 0)
+    {
+        return;
+    }
+
+    bursts = (count + b.bytes - 1) / b.bytes;
+    ns = (unsigned long long)bursts * (is_read ? b.rd_ps : b.wr_ps);
+    do_div(ns, 1000);
+
+    // busy wait, a PIO copy over EIM keeps the CPU busy for the same time
+    while (ns >= 1000000)
+    {
+        mdelay(1);
+        ns -= 1000000;
+    }
+    udelay((unsigned long)ns / 1000);
+    ndelay((unsigned long)ns % 1000);
+}
+
+#ifndef EIM_HOST_BUILD
+static bool eim_dma_filter(struct dma_chan *chan, void *param)
+{
+	if (!imx_dma_is_general_purpose(chan))
+	{
+		return false;
+	}
+
+	chan->private = param;
+	return true;
+}
+
+static void eim_dma_callback(void *data)
+{
+	// trigger wait_for_completion process
+	complete(&mdev->dma_done);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function copies between mapped memory and a CS window by SDMA
+//     (called with eim_dma_lock held).
+// Parameters :
+//     ecs - eim chip select
+//     mem - DMA mapped memory scatterlist
+//     nents - the number of mapped entries
+//     offset - byte offset in the CS window
+//     to_window - 1 : memory to window (write), 0 : window to memory (read)
+// Return Value :
+//     0 - eim_dma_sg success.
+// Errors :
+//     -ENOMEM - no memory for the window scatterlist
+//     -EFAULT - descriptor preparation failed
+//     -ETIMEDOUT - SDMA did not complete
+// -------------------------------------------------------------
+static int eim_dma_sg(eim_cs *ecs, struct scatterlist *mem, int nents, unsigned long offset, int to_window)
+{
+    struct dma_chan *chan = mdev->dma_chan;
+    struct dma_async_tx_descriptor *desc = NULL;
+    struct scatterlist *win = NULL;
+    struct scatterlist *s = NULL;
+    int i = 0;
+
+    // the window side mirrors the memory entries on consecutive EIM addresses
+    win = kmalloc(sizeof(struct scatterlist) * nents, GFP_KERNEL);
+    if (!win)
+    {
+        return -ENOMEM;
+    }
+    sg_init_table(win, nents);
+    for_each_sg(mem, s, nents, i)
+    {
+        sg_dma_address(&win[i]) = ecs->mem_phys + offset;
+        sg_dma_len(&win[i]) = sg_dma_len(s);
+        offset += sg_dma_len(s);
+    }
+
+    INIT_COMPLETION(mdev->dma_done);
+
+    // M2M takes the source list first and then the destination list
+    desc = chan->device->device_prep_slave_sg(chan, to_window ? mem : win, nents, DMA_MEM_TO_MEM, 1);
+    if (desc)
+    {
+        desc = chan->device->device_prep_slave_sg(chan, to_window ? win : mem, nents, DMA_MEM_TO_MEM, 0);
+    }
+    if (!desc)
+    {
+        printk(KERN_ERR "< eim.c > eim_dma_sg : device_prep_slave_sg failed.\n");
+        kfree(win);
+        return -EFAULT;
+    }
+    desc->callback = eim_dma_callback;
+    desc->callback_param = ecs;
+
+    dmaengine_submit(desc);
+    dma_async_issue_pending(chan);
+
+    if (!wait_for_completion_timeout(&mdev->dma_done, msecs_to_jiffies(EIM_DMA_TIMEOUT_MS)))
+    {
+        printk(KERN_ERR "< eim.c > eim_dma_sg : SDMA timed out.\n");
+        dmaengine_terminate_all(chan);
+        kfree(win);
+        return -ETIMEDOUT;
+    }
+
+    kfree(win);
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function pins a user buffer and moves it to or from a CS
+//     window by SDMA, EIM_DMA_PAGES pages at a time.
+// Parameters :
+//     ecs - eim chip select
+//     uaddr - buffer address in user space
+//     count - the number of bytes (no more than the window)
+//     to_window - 1 : write the window, 0 : read the window
+// Return Value :
+//     0 - eim_dma_user success.
+// Errors :
+//     -ENOMEM - no memory for the page list
+//     -EFAULT - pinning, mapping or SDMA failed
+// -------------------------------------------------------------
+static int eim_dma_user(eim_cs *ecs, unsigned long uaddr, size_t count, int to_window)
+{
+    enum dma_data_direction dir = to_window ? DMA_TO_DEVICE : DMA_FROM_DEVICE;
+    struct page **pages = NULL;
+    struct scatterlist *mem = NULL;
+    struct device *dev = mdev->dma_chan->device->dev;
+    unsigned long done = 0;
+    int ret = 0;
+
+    pages = kmalloc(sizeof(struct page *) * EIM_DMA_PAGES, GFP_KERNEL);
+    mem = kmalloc(sizeof(struct scatterlist) * EIM_DMA_PAGES, GFP_KERNEL);
+    if (!pages || !mem)
+    {
+        kfree(pages);
+        kfree(mem);
+        return -ENOMEM;
+    }
+
+    mutex_lock(&mdev->eim_dma_lock);
+    while ((done < count) && (0 == ret))
+    {
+        unsigned long addr = uaddr + done;
+        unsigned long first = offset_in_page(addr);
+        unsigned long len = min((unsigned long)(count - done), EIM_DMA_PAGES * PAGE_SIZE - first);
+        int nr_pages = (first + len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+        int pinned = 0;
+        int nents = 0;
+        int i = 0;
+
+        // SDMA writes the user pages on reads only
+        down_read(&current->mm->mmap_sem);
+        pinned = get_user_pages(current, current->mm, addr & PAGE_MASK, nr_pages, !to_window, 0, pages, NULL);
+        up_read(&current->mm->mmap_sem);
+        if (pinned != nr_pages)
+        {
+            printk(KERN_ERR "< eim.c > eim_dma_user : get_user_pages failed.\n");
+            ret = -EFAULT;
+        }
+        else
+        {
+            unsigned long left = len;
+
+            sg_init_table(mem, nr_pages);
+            for (i = 0; i < nr_pages; i++)
+            {
+                unsigned int off = (0 == i) ? first : 0;
+                unsigned int n = min(left, PAGE_SIZE - off);
+                sg_set_page(&mem[i], pages[i], n, off);
+                left -= n;
+            }
+
+            nents = dma_map_sg(dev, mem, nr_pages, dir);
+            if (0 == nents)
+            {
+                printk(KERN_ERR "< eim.c > eim_dma_user : dma_map_sg failed.\n");
+                ret = -EFAULT;
+            }
+            else
+            {
+                ret = eim_dma_sg(ecs, mem, nents, done, to_window);
+                dma_unmap_sg(dev, mem, nr_pages, dir);
+            }
+        }
+
+        for (i = 0; i < pinned; i++)
+        {
+            if (!to_window && (0 == ret))
+            {
+                set_page_dirty_lock(pages[i]);
+            }
+            page_cache_release(pages[i]);
+        }
+        done += len;
+    }
+    mutex_unlock(&mdev->eim_dma_lock);
+
+    kfree(pages);
+    kfree(mem);
+
+    return ret ? -EFAULT : 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function finds the smallest transfer SDMA does faster than the
+//     CPU copy, for one direction. It uses the first enabled CS window at
+//     load, before any FPGA program is downloaded (writes put zeros on it),
+//     and runs only with dma_calibrate = 1.
+// Parameters :
+//     to_window - 1 : write cutoff, 0 : read cutoff
+// Return Value :
+//     the cutoff in bytes (EIM_CUTOFF_CPU_ONLY - SDMA never wins)
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static int eim_dma_calibrate(int to_window)
+{
+    enum dma_data_direction dir = to_window ? DMA_TO_DEVICE : DMA_FROM_DEVICE;
+    struct device *dev = mdev->dma_chan->device->dev;
+    struct scatterlist sg;
+    eim_cs *ecs = NULL;
+    void *kbuf = NULL;
+    int cutoff = EIM_CUTOFF_CPU_ONLY;
+    int size = 0;
+    int ret = 0;
+    int n = 0;
+
+    for (n = 0; n < EIM_CS_MAX && !ecs; n++)
+    {
+        ecs = mdev->cs[n];
+    }
+    kbuf = kzalloc(EIM_DMA_CAL_MAX, GFP_KERNEL);
+    if (!ecs || !kbuf)
+    {
+        kfree(kbuf);
+        return cutoff;
+    }
+
+    mutex_lock(&mdev->eim_dma_lock);
+    for (size = EIM_DMA_CAL_MIN; size <= EIM_DMA_CAL_MAX && size <= ecs->mem_len; size <<= 1)
+    {
+        ktime_t start;
+        s64 cpu_ns = 0;
+        s64 dma_ns = 0;
+        int i = 0;
+
+        start = ktime_get();
+        for (i = 0; i < EIM_DMA_CAL_LOOPS; i++)
+        {
+            if (to_window)
+            {
+                eim_copy_toio16((volatile void *)ecs->eim_mem_base, kbuf, size, eim_copy_align_cs(ecs));
+            }
+            else
+            {
+                eim_copy_fromio16(kbuf, (const volatile void *)ecs->eim_mem_base, size, eim_copy_align_cs(ecs));
+            }
+        }
+        cpu_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+        // the user path maps its pages on every transfer, so map here too
+        start = ktime_get();
+        for (i = 0; i < EIM_DMA_CAL_LOOPS; i++)
+        {
+            sg_init_one(&sg, kbuf, size);
+            if (0 == dma_map_sg(dev, &sg, 1, dir))
+            {
+                break;
+            }
+            ret = eim_dma_sg(ecs, &sg, 1, 0, to_window);
+            dma_unmap_sg(dev, &sg, 1, dir);
+            if (ret)
+            {
+                break;
+            }
+        }
+        dma_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+        if (i < EIM_DMA_CAL_LOOPS)
+        {
+            break;
+        }
+
+        if (dma_ns < cpu_ns)
+        {
+            cutoff = size;
+            break;
+        }
+    }
+    mutex_unlock(&mdev->eim_dma_lock);
+
+    kfree(kbuf);
+    return cutoff;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function requests the SDMA channel and sets the CPU / DMA
+//     cutoffs of both directions.
+// Parameters :
+//     None.
+// Return Value :
+//     None (the CPU copy is used for every transfer without a channel).
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_dma_init(void)
+{
+	dma_cap_mask_t dma_mask;
+	struct imx_dma_data dma_data = {0};
+	struct dma_slave_config dma_config = {0};
+
+    mutex_init(&mdev->eim_dma_lock);
+    init_completion(&mdev->dma_done);
+    if ((!dma_write && !dma_read) || loopback)
+    {
+        return;
+    }
+
+	dma_cap_zero(dma_mask);
+	dma_cap_set(DMA_SLAVE, dma_mask);
+	dma_data.peripheral_type = IMX_DMATYPE_MEMORY;
+	dma_data.priority = DMA_PRIO_HIGH;
+
+    mdev->dma_chan = dma_request_channel(dma_mask, eim_dma_filter, &dma_data);
+    if (!mdev->dma_chan)
+    {
+        printk(KERN_ERR "< eim.c > eim_dma_init : dma_request_channel failed, CPU copy only.\n");
+        return;
+    }
+	dma_config.direction = DMA_MEM_TO_MEM;
+	dma_config.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+	dmaengine_slave_config(mdev->dma_chan, &dma_config);
+
+    // calibration moves data on the bus, so it runs only when asked for
+    if (dma_cutoff < 0)
+    {
+        dma_cutoff = dma_calibrate ? eim_dma_calibrate(1) : EIM_DMA_CUTOFF_DEFAULT;
+    }
+    if (dma_read_cutoff < 0)
+    {
+        dma_read_cutoff = dma_calibrate ? eim_dma_calibrate(0) : EIM_DMA_CUTOFF_DEFAULT;
+    }
+    printk(KERN_INFO "< eim.c > eim_dma_init : SDMA writes from %d bytes, reads from %d bytes.\n",
+            dma_cutoff, dma_read_cutoff);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function releases the SDMA channel.
+// Parameters :
+//     None.
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_dma_exit(void)
+{
+    if (mdev->dma_chan)
+    {
+        dma_release_channel(mdev->dma_chan);
+        mdev->dma_chan = NULL;
+    }
+}
+#endif
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function tells if one transfer goes through SDMA.
+// Parameters :
+//     buf - buffer pointer in user space
+//     count - the number of bytes
+//     enable - dma_write / dma_read
+//     cutoff - dma_cutoff / dma_read_cutoff
+// Return Value :
+//     1 - SDMA, 0 - CPU copy
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static int eim_use_dma(const void __user *buf, size_t count, int enable, int cutoff)
+{
+#ifndef EIM_HOST_BUILD
+    // SDMA moves whole 32-bit words from / to word aligned buffers
+    return enable && mdev->dma_chan && (cutoff >= 0) && (count >= (size_t)cutoff) &&
+           (0 == (((unsigned long)buf | count) & 0x3));
+#else
+    return 0;
+#endif
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes a user buffer into a CS window, by SDMA from
+//     dma_cutoff bytes on and by the CPU below it
+//     (called with the chip select lock held).
+// Parameters :
+//     ecs - eim chip select
+//     buf - buffer pointer in user space
+//     count - the number of bytes (no more than the window)
+// Return Value :
+//     0 - eim_write_window success.
+// Errors :
+//     -EFAULT - copy or SDMA failed
+//     -EINVAL - odd count (copy16)
+// -------------------------------------------------------------
+static int eim_write_window(eim_cs *ecs, const char __user *buf, size_t count)
+{
+    int ret = 0;
+
+#ifndef EIM_HOST_BUILD
+    if (eim_use_dma(buf, count, dma_write, dma_cutoff))
+    {
+        ecs->engine_stats.dma_writes++;
+        ecs->engine_stats.dma_write_bytes += count;
+        return eim_dma_user(ecs, (unsigned long)buf, count, 1);
+    }
+#endif
+
+    ecs->engine_stats.cpu_writes++;
+    ecs->engine_stats.cpu_write_bytes += count;
+    ret = eim_copy_to_window(ecs, buf, count);
+    if (-EINVAL == ret)
+    {
+        printk(KERN_ERR "< eim.c > eim_write : odd length %d, the window takes halfwords only.\n", (int)count);
+    }
+    else if (ret)
+    {
+        printk(KERN_ERR "< eim.c > eim_write : copy_from_user failed.\n");
+    }
+
+    return ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function reads a CS window into a user buffer, by SDMA from
+//     dma_read_cutoff bytes on and by the CPU below it
+//     (called with the chip select lock held).
+// Parameters :
+//     ecs - eim chip select
+//     buf - buffer pointer in user space
+//     count - the number of bytes (no more than the window)
+// Return Value :
+//     0 - eim_read_window success.
+// Errors :
+//     -EFAULT - copy or SDMA failed
+// -------------------------------------------------------------
+static int eim_read_window(eim_cs *ecs, char __user *buf, size_t count)
+{
+#ifndef EIM_HOST_BUILD
+    if (eim_use_dma(buf, count, dma_read, dma_read_cutoff))
     {
-        return -EFAULT;
+        ecs->engine_stats.dma_reads++;
+        ecs->engine_stats.dma_read_bytes += count;
+        return eim_dma_user(ecs, (unsigned long)buf, count, 0);
     }
+#endif
 
-    return 0;
+    ecs->engine_stats.cpu_reads++;
+    ecs->engine_stats.cpu_read_bytes += count;
+    return eim_copy_from_window(ecs, buf, count);
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function ensures that eim device can be only opened once .
+// 	   This function ensures that every eim chip select can be only opened once .
 // Parameters :
 //     None.
 // Return Value :
@@ -567,20 +1988,23 @@ static int eim_config(void)
 static int eim_open(struct inode *inode, struct file *filp)
 {
 	int ret = 0;
+    eim_cs *ecs = NULL;
 
     if (!mdev)
     {
         printk(KERN_ERR "< eim.c > eim_open : eim device is not valid (mdev is NULL).\n");
         return -EFAULT;
     }
+    ecs = container_of(inode->i_cdev, eim_cs, cdev);
 
-	ret = atomic_dec_and_test(&mdev->open_state);
+	ret = atomic_dec_and_test(&ecs->open_state);
     if (0 == ret)
     {
-        printk(KERN_ERR "< eim.c > eim_open : eim device has been opened already.\n");
-        atomic_inc(&mdev->open_state);
+        printk(KERN_ERR "< eim.c > eim_open : eim%d device has been opened already.\n", ecs->cs);
+        atomic_inc(&ecs->open_state);
         return -EBUSY;
     }
+    filp->private_data = ecs;
 
 #if DEBUG == 1
     printk(KERN_INFO "< eim.c > eim open.\n");
@@ -601,13 +2025,15 @@ static int eim_open(struct inode *inode, struct file *filp)
 // -------------------------------------------------------------
 static int eim_release(struct inode *inode, struct file *filp)
 {
+    eim_cs *ecs = filp->private_data;
+
     if (!mdev)
     {
         printk(KERN_ERR "< eim.c > eim_release : eim device is not valid (mdev is NULL).\n");
         return -EFAULT;
     }
 
-    atomic_inc(&mdev->open_state);
+    atomic_inc(&ecs->open_state);
 
 #if DEBUG == 1
     printk(KERN_INFO "< eim.c > eim release.\n");
@@ -618,26 +2044,32 @@ static int eim_release(struct inode *inode, struct file *filp)
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function implements write file operation.
+// 	   This function writes data to one chip select (called with its lock held).
 // Parameters :
-//	   filp - object file
+//	   ecs - eim chip select
 //	   buf - buffer pointer in user space
 //	   count - the actual number of data to written
-//	   fops - the offset of data
 // Return Value :
 //     positive value - the actual number of data copied
 //	   negative value - copy_from_user error
 // Errors :
 //     None.
 // -------------------------------------------------------------
-static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count, loff_t *fpos)
+static ssize_t eim_write_cs(eim_cs *ecs, const char __user *buf, size_t count)
 {
     int mode = 0;
-    mode = mdev->eim_dmode;
-    if (DOWNLOAD_PROGRAM == mode)
+    mode = ecs->eim_dmode;
+    if ((DOWNLOAD_PROGRAM == mode) && !loopback)
     {
         int ret = 0;
 
+        // nCONFIG / nSTATUS / CONF_DONE are data lines while any CS has a 32-bit port
+        if (mdev->pads_d32)
+        {
+            printk(KERN_ERR "< eim.c > eim_write : FPGA program download needs every CS at 8 / 16 bits.\n");
+            return -EFAULT;
+        }
+
         // put nCONFIG low and then pull it up
         DRIVE_nCONFIG_LOW();
         ndelay(500);
@@ -663,11 +2095,10 @@ static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count
 
         // drive config_data on data bus
         // config_data should be driven on the bus on the rising edge of DCLK
-	    ret = copy_from_user((void *)mdev->eim_mem_base, buf, min(EIM_MEM_LEN, (int)count));
+	    ret = eim_write_window(ecs, buf, min((int)ecs->mem_len, (int)count));
 	    if (ret)
 	    {
-	        printk(KERN_ERR "< eim.c > eim_write : copy_from_user failed.\n");
-	        return -EFAULT;
+	        return ret;
 	    }
 
         // check CONF_DONE if it is asserted or not
@@ -682,16 +2113,20 @@ static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count
 #endif
 
     }
-    else if (DOWNLOAD_PARAMETERS == mode)
+    else if ((DOWNLOAD_PARAMETERS == mode) || loopback)
     {
         int ret = 0;
-	    ret = copy_from_user((void *)mdev->eim_mem_base, buf, min(EIM_MEM_LEN, (int)count));
+	    ret = eim_write_window(ecs, buf, min((int)ecs->mem_len, (int)count));
 	    if (ret)
 	    {
-	        printk(KERN_ERR "< eim.c > eim_write : copy_from_user failed.\n");
-	        return -EFAULT;
+	        return ret;
 	    }
 
+        if (loopback && loopback_timing)
+        {
+            eim_loopback_delay(ecs, min((int)ecs->mem_len, (int)count), 0);
+        }
+
 #if DEBUG == 1
     printk(KERN_INFO "< eim.c > eim write : download front-end parameters.\n");
 #endif
@@ -707,7 +2142,47 @@ static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count
     printk(KERN_INFO "< eim.c > eim write.\n");
 #endif
 
-    return min(EIM_MEM_LEN, (int)count);
+    return min((int)ecs->mem_len, (int)count);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function implements write file operation.
+// Parameters :
+//	   filp - object file
+//	   buf - buffer pointer in user space
+//	   count - the actual number of data to written
+//	   fops - the offset of data
+// Return Value :
+//     positive value - the actual number of data copied
+//	   negative value - copy_from_user error
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count, loff_t *fpos)
+{
+    eim_cs *ecs = filp->private_data;
+    int fpp = 0;
+    ssize_t ret = 0;
+
+    mutex_lock(&ecs->eim_mutex_lock);
+
+    // FPP GPIOs are shared by all chip selects
+    fpp = (DOWNLOAD_PROGRAM == ecs->eim_dmode);
+    if (fpp)
+    {
+        mutex_lock(&mdev->eim_fpp_lock);
+    }
+
+    ret = eim_write_cs(ecs, buf, count);
+
+    if (fpp)
+    {
+        mutex_unlock(&mdev->eim_fpp_lock);
+    }
+    mutex_unlock(&ecs->eim_mutex_lock);
+
+    return ret;
 }
 
 // ------------------------------------------------------------
@@ -726,19 +2201,29 @@ static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count
 // -------------------------------------------------------------
 static ssize_t eim_read(struct file *filp, char __user *buf, size_t count, loff_t *fpos)
 {
+    eim_cs *ecs = filp->private_data;
 	int ret = 0;
-	ret = copy_to_user(buf, (void *)mdev->eim_mem_base, min(EIM_MEM_LEN, (int)count));
+
+    mutex_lock(&ecs->eim_mutex_lock);
+	ret = eim_read_window(ecs, buf, min((int)ecs->mem_len, (int)count));
     if (ret)
     {
-    	printk(KERN_ERR "< eim.c > eim_read : copy_to_user failed.\n");
+        mutex_unlock(&ecs->eim_mutex_lock);
+    	printk(KERN_ERR "< eim.c > eim_read : copy_to_user or SDMA failed.\n");
         return -EFAULT;
     }
 
+    if (loopback && loopback_timing)
+    {
+        eim_loopback_delay(ecs, min((int)ecs->mem_len, (int)count), 1);
+    }
+    mutex_unlock(&ecs->eim_mutex_lock);
+
 #if DEBUG == 1
     printk(KERN_INFO "< eim.c > eim read.\n");
 #endif
 
-    return min(EIM_MEM_LEN, (int)count);
+    return min((int)ecs->mem_len, (int)count);
 }
 
 // ------------------------------------------------------------
@@ -751,39 +2236,163 @@ static ssize_t eim_read(struct file *filp, char __user *buf, size_t count, loff_
 // Return Value :
 //	   0 - eim_ioctl success
 // Errors :
-//     None.
+//     -EFAULT - copy from / to user space failed
+//     -EINVAL - a timing field is out of range
+//     -ENOTTY - unknown command
 // ------------------------------------------------------------
 static long eim_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
-	// Nothing to do
+    eim_cs *ecs = filp->private_data;
+    struct eim_cs_config cfg;
+    int old_mum = 0;
+    int old_dsz = 0;
+    int ret = 0;
 
 #if DEBUG == 1
     printk(KERN_INFO "< eim.c > eim IO control.\n");
     printk(KERN_INFO "< eim.c > cmd:%d, arg:%ld.\n", cmd, arg);
 #endif
 
-    return 0;
+    switch (cmd)
+    {
+    case EIM_IOC_GET_CONFIG:
+        mutex_lock(&ecs->eim_mutex_lock);
+        eim_config_read(ecs, &cfg);
+        mutex_unlock(&ecs->eim_mutex_lock);
+        eim_cutoff_read(&cfg);
+        if (copy_to_user((void __user *)arg, &cfg, sizeof(cfg)))
+        {
+            printk(KERN_ERR "< eim.c > eim_ioctl : copy_to_user failed.\n");
+            return -EFAULT;
+        }
+        break;
+
+    case EIM_IOC_SET_CONFIG:
+        if (copy_from_user(&cfg, (void __user *)arg, sizeof(cfg)))
+        {
+            printk(KERN_ERR "< eim.c > eim_ioctl : copy_from_user failed.\n");
+            return -EFAULT;
+        }
+        ret = eim_config_check(&cfg);
+        if (ret)
+        {
+            return ret;
+        }
+
+        mutex_lock(&ecs->eim_mutex_lock);
+        old_mum = eim_timing_field(ioread32(ecs->cs_base + EIM_CS_GCR1), 3, 1);
+        old_dsz = eim_timing_field(ioread32(ecs->cs_base + EIM_CS_GCR1), 16, 3);
+        eim_config_write(ecs, &cfg);
+        if ((old_mum != cfg.MUM) || (old_dsz != cfg.DSZ))
+        {
+            ret = eim_iomux();
+        }
+        mutex_unlock(&ecs->eim_mutex_lock);
+        eim_cutoff_write(&cfg);
+        break;
+
+    case EIM_IOC_SET_PROFILE:
+        mutex_lock(&ecs->eim_mutex_lock);
+        ret = eim_profile_apply(ecs, (int)arg);
+        mutex_unlock(&ecs->eim_mutex_lock);
+        break;
+
+    case EIM_IOC_GET_PROFILE_STATS:
+        {
+            struct eim_profile_stats stats;
+
+            mutex_lock(&ecs->eim_mutex_lock);
+            stats = ecs->profile_stats;
+            mutex_unlock(&ecs->eim_mutex_lock);
+            if (copy_to_user((void __user *)arg, &stats, sizeof(stats)))
+            {
+                printk(KERN_ERR "< eim.c > eim_ioctl : copy_to_user failed.\n");
+                return -EFAULT;
+            }
+        }
+        break;
+
+    case EIM_IOC_GET_ENGINE_STATS:
+        {
+            struct eim_engine_stats stats;
+
+            mutex_lock(&ecs->eim_mutex_lock);
+            stats = ecs->engine_stats;
+            mutex_unlock(&ecs->eim_mutex_lock);
+            if (copy_to_user((void __user *)arg, &stats, sizeof(stats)))
+            {
+                printk(KERN_ERR "< eim.c > eim_ioctl : copy_to_user failed.\n");
+                return -EFAULT;
+            }
+        }
+        break;
+
+    default:
+        return -ENOTTY;
+    }
+
+    return ret;
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function maps physical memory into user space.
+// 	   This function maps a CS window into user space. The mmap offset
+//     carries the cache attribute (EIM_MMAP_OFFSET) and the window offset.
 // Parameters :
 //	   filp - object file
 //	   vma - virtual memory area struct
 // Return Value :
 //	   0 - eim_mmap success
 // Errors :
-//     None.
+//     -EINVAL - unknown attribute, cached I/O window or mapping too large
+//     -ENXIO - remap failed
 // ------------------------------------------------------------
 static int eim_mmap(struct file *filp, struct vm_area_struct *vma)
 {
+    eim_cs *ecs = filp->private_data;
+    unsigned long size = vma->vm_end - vma->vm_start;
+    unsigned long mode = vma->vm_pgoff >> (EIM_MMAP_MODE_SHIFT - PAGE_SHIFT);
+    unsigned long pgoff = vma->vm_pgoff & ((1UL << (EIM_MMAP_MODE_SHIFT - PAGE_SHIFT)) - 1);
 	int ret = 0;
 
-    vma->vm_flags |= VM_RESERVED;
-    vma->vm_flags |= VM_IO;
+    if ((mode >= EIM_MMAP_MODE_CNT) || ((pgoff << PAGE_SHIFT) + size > ecs->mem_len))
+    {
+        printk(KERN_ERR "< eim.c > eim_mmap : invalid mapping of the CS%d window.\n", ecs->cs);
+        return -EINVAL;
+    }
+
+    // loopback window is vmalloc memory, always cached
+    if (loopback)
+    {
+        ret = remap_vmalloc_range(vma, (void *)ecs->eim_mem_base, pgoff);
+        if (ret)
+        {
+            printk(KERN_ERR "< eim.c > eim_mmap : remap_vmalloc_range failed.\n");
+            return -ENXIO;
+        }
+        return 0;
+    }
+
+    EIM_VM_FLAGS_SET(vma, VM_RESERVED | VM_IO);
+
+    // the FPGA window has no cache maintenance, CPU caches would go stale
+    switch (mode)
+    {
+    case EIM_MMAP_LEGACY:
+        vma->vm_page_prot = PAGE_SHARED;
+        break;
+    case EIM_MMAP_WC:
+        vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+        break;
+    case EIM_MMAP_SO:
+        vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+        break;
+    default:
+        printk(KERN_ERR "< eim.c > eim_mmap : the CS%d window can not be mapped cached.\n", ecs->cs);
+        return -EINVAL;
+    }
 
-	ret = remap_pfn_range(vma, vma->vm_start, EIM_MEM_BASE >> PAGE_SHIFT, EIM_MEM_LEN, PAGE_SHARED);
+	ret = remap_pfn_range(vma, vma->vm_start, (ecs->mem_phys >> PAGE_SHIFT) + pgoff, size, vma->vm_page_prot);
     if (ret)
     {
         printk(KERN_ERR "< eim.c > eim_mmap : remap_pfn_range failed.\n");
@@ -808,263 +2417,497 @@ static struct file_operations eim_fops =
     .mmap               =   eim_mmap,
 };
 
-// READ & WRITE methods of '/sys/class/eim/eim/dmode' device attribute
+// READ & WRITE methods of '/sys/class/eim/eimN/dmode' device attribute
 static ssize_t eim_dmode_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_dmode = 0;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    eim_dmode = mdev->eim_dmode;
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    eim_dmode = ecs->eim_dmode;
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return sprintf(buf, "%d\n", eim_dmode);
 }
 
 static ssize_t eim_dmode_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_dmode = 0;
 
 	eim_dmode = simple_strtoul(buf, NULL, 10);
     eim_dmode = eim_dmode <DOWNLOAD_PROGRAM ? DOWNLOAD_PROGRAM : eim_dmode;
 	eim_dmode = eim_dmode > DOWNLOAD_PARAMETERS ? DOWNLOAD_PARAMETERS : eim_dmode;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    mdev->eim_dmode = eim_dmode;
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    ecs->eim_dmode = eim_dmode;
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return count;
 }
 
-// READ & WRITE methods of '/sys/class/eim/eim/MUM' device attribute
+// READ & WRITE methods of '/sys/class/eim/eimN/MUM' device attribute
 static ssize_t eim_mum_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_mum = 0;
     int eim_mum_mask = 1;
-    u32 cs1gpr1_rreg = 0;
+    u32 csxgcr1_rreg = 0;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    cs1gpr1_rreg = ioread32(mdev->eim_base + 0x18);
-    eim_mum = ( cs1gpr1_rreg & bitfield(3, 1, eim_mum_mask) ) >> 3;
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxgcr1_rreg = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    eim_mum = ( csxgcr1_rreg & bitfield(3, 1, eim_mum_mask) ) >> 3;
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return sprintf(buf, "%d\n", eim_mum);
 }
 
 static ssize_t eim_mum_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_mum = 0;
     int eim_mum_mask = 1;
-    u32 cs1gpr1_rreg = 0;
-    u32 cs1gpr1_wreg = 0;
+    u32 csxgcr1_rreg = 0;
+    u32 csxgcr1_wreg = 0;
 
 	eim_mum = simple_strtoul(buf, NULL, 10);
 	eim_mum = eim_mum < 0 ? 0 : eim_mum;
 	eim_mum = eim_mum > eim_mum_mask ? eim_mum_mask : eim_mum;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    cs1gpr1_rreg = ioread32(mdev->eim_base + 0x18);
-    cs1gpr1_wreg = (cs1gpr1_rreg & ~bitfield(3, 1, eim_mum_mask)) | bitfield(3, 1, eim_mum);
-    iowrite32(cs1gpr1_wreg, mdev->eim_base + 0x18);
-    eim_iomux(eim_mum);
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxgcr1_rreg = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    csxgcr1_wreg = (csxgcr1_rreg & ~bitfield(3, 1, eim_mum_mask)) | bitfield(3, 1, eim_mum);
+    iowrite32(csxgcr1_wreg, ecs->cs_base + EIM_CS_GCR1);
+    eim_iomux();
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return count;
 }
 
-// READ & WRITE methods of '/sys/class/eim/eim/BCD' device attribute
+// READ & WRITE methods of '/sys/class/eim/eimN/BCD' device attribute
 static ssize_t eim_bcd_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_bcd = 0;
     int eim_bcd_mask = 3;
-	u32 cs1gpr1_rreg = 0;
+	u32 csxgcr1_rreg = 0;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    cs1gpr1_rreg = ioread32(mdev->eim_base + 0x18);
-    eim_bcd = ( cs1gpr1_rreg & bitfield(12, 2, eim_bcd_mask) ) >> 12;
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxgcr1_rreg = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    eim_bcd = ( csxgcr1_rreg & bitfield(12, 2, eim_bcd_mask) ) >> 12;
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return sprintf(buf, "%d\n", eim_bcd);
 }
 
 static ssize_t eim_bcd_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_bcd = 0;
     int eim_bcd_mask = 3;
-    u32 cs1gpr1_rreg = 0;
-    u32 cs1gpr1_wreg = 0;
+    u32 csxgcr1_rreg = 0;
+    u32 csxgcr1_wreg = 0;
 
 	eim_bcd = simple_strtoul(buf, NULL, 10);
     eim_bcd = eim_bcd < 0 ? 0 : eim_bcd;
 	eim_bcd = eim_bcd > eim_bcd_mask ? eim_bcd_mask : eim_bcd;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    cs1gpr1_rreg = ioread32(mdev->eim_base + 0x18);
-    cs1gpr1_wreg = (cs1gpr1_rreg & ~bitfield(12, 2, eim_bcd_mask)) | bitfield(12, 2, eim_bcd);
-    iowrite32(cs1gpr1_wreg, mdev->eim_base + 0x18);
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxgcr1_rreg = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    csxgcr1_wreg = (csxgcr1_rreg & ~bitfield(12, 2, eim_bcd_mask)) | bitfield(12, 2, eim_bcd);
+    iowrite32(csxgcr1_wreg, ecs->cs_base + EIM_CS_GCR1);
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return count;
 }
 
-// READ & WRITE methods of '/sys/class/eim/eim/WWSC' device attribute
+// READ & WRITE methods of '/sys/class/eim/eimN/WWSC' device attribute
 static ssize_t eim_wwsc_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_wwsc = 0;
     int eim_wwsc_mask = 63;
-	u32 cs1wcr1_rreg = 0;
+	u32 csxwcr1_rreg = 0;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    cs1wcr1_rreg = ioread32(mdev->eim_base + 0x28);
-    eim_wwsc = ( cs1wcr1_rreg & bitfield(24, 6, eim_wwsc_mask) ) >> 24;
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxwcr1_rreg = ioread32(ecs->cs_base + EIM_CS_WCR1);
+    eim_wwsc = ( csxwcr1_rreg & bitfield(24, 6, eim_wwsc_mask) ) >> 24;
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return sprintf(buf, "%d\n", eim_wwsc);
 }
 
 static ssize_t eim_wwsc_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
+    eim_cs *ecs = dev_get_drvdata(dev);
 	int eim_wwsc = 0;
     int eim_wwsc_mask = 63;
-    u32 cs1wcr1_rreg = 0;
-    u32 cs1wcr1_wreg = 0;
+    u32 csxwcr1_rreg = 0;
+    u32 csxwcr1_wreg = 0;
 
 	eim_wwsc = simple_strtoul(buf, NULL, 10);
     eim_wwsc = eim_wwsc < 0 ? 0 : eim_wwsc;
 	eim_wwsc = eim_wwsc > eim_wwsc_mask ? eim_wwsc_mask : eim_wwsc;
 
-	mutex_lock(&mdev->eim_mutex_lock);
-    cs1wcr1_rreg = ioread32(mdev->eim_base + 0x28);
-    cs1wcr1_wreg = (cs1wcr1_rreg & ~bitfield(24, 6, eim_wwsc_mask)) | bitfield(24, 6, eim_wwsc);
-    iowrite32(cs1wcr1_wreg, mdev->eim_base + 0x28);
-	mutex_unlock(&mdev->eim_mutex_lock);
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxwcr1_rreg = ioread32(ecs->cs_base + EIM_CS_WCR1);
+    csxwcr1_wreg = (csxwcr1_rreg & ~bitfield(24, 6, eim_wwsc_mask)) | bitfield(24, 6, eim_wwsc);
+    iowrite32(csxwcr1_wreg, ecs->cs_base + EIM_CS_WCR1);
+	mutex_unlock(&ecs->eim_mutex_lock);
+
+	return count;
+}
+
+// READ & WRITE methods of '/sys/class/eim/eimN/RWSC' device attribute
+static ssize_t eim_rwsc_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    eim_cs *ecs = dev_get_drvdata(dev);
+	int eim_rwsc = 0;
+    int eim_rwsc_mask = 63;
+	u32 csxrcr1_rreg = 0;
+
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxrcr1_rreg = ioread32(ecs->cs_base + EIM_CS_RCR1);
+    eim_rwsc = ( csxrcr1_rreg & bitfield(24, 6, eim_rwsc_mask) ) >> 24;
+	mutex_unlock(&ecs->eim_mutex_lock);
+
+	return sprintf(buf, "%d\n", eim_rwsc);
+}
+
+static ssize_t eim_rwsc_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    eim_cs *ecs = dev_get_drvdata(dev);
+	int eim_rwsc = 0;
+    int eim_rwsc_mask = 63;
+    u32 csxrcr1_rreg = 0;
+    u32 csxrcr1_wreg = 0;
+
+	eim_rwsc = simple_strtoul(buf, NULL, 10);
+    eim_rwsc = eim_rwsc < 0 ? 0 : eim_rwsc;
+	eim_rwsc = eim_rwsc > eim_rwsc_mask ? eim_rwsc_mask : eim_rwsc;
+
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxrcr1_rreg = ioread32(ecs->cs_base + EIM_CS_RCR1);
+    csxrcr1_wreg = (csxrcr1_rreg & ~bitfield(24, 6, eim_rwsc_mask)) | bitfield(24, 6, eim_rwsc);
+    iowrite32(csxrcr1_wreg, ecs->cs_base + EIM_CS_RCR1);
+	mutex_unlock(&ecs->eim_mutex_lock);
+
+	return count;
+}
+
+// READ & WRITE methods of '/sys/class/eim/eimN/BL' device attribute
+static ssize_t eim_bl_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    eim_cs *ecs = dev_get_drvdata(dev);
+	int eim_bl = 0;
+    int eim_bl_mask = 7;
+	u32 csxgcr1_rreg = 0;
+
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxgcr1_rreg = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    eim_bl = ( csxgcr1_rreg & bitfield(8, 3, eim_bl_mask) ) >> 8;
+	mutex_unlock(&ecs->eim_mutex_lock);
+
+	return sprintf(buf, "%d\n", eim_bl);
+}
+
+static ssize_t eim_bl_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    eim_cs *ecs = dev_get_drvdata(dev);
+	int eim_bl = 0;
+    int eim_bl_mask = 7;
+    int eim_bl_max = 4;     // 100 - continuous burst
+    u32 csxgcr1_rreg = 0;
+    u32 csxgcr1_wreg = 0;
+
+	eim_bl = simple_strtoul(buf, NULL, 10);
+    eim_bl = eim_bl < 0 ? 0 : eim_bl;
+	eim_bl = eim_bl > eim_bl_max ? eim_bl_max : eim_bl;
+
+	mutex_lock(&ecs->eim_mutex_lock);
+    csxgcr1_rreg = ioread32(ecs->cs_base + EIM_CS_GCR1);
+    csxgcr1_wreg = (csxgcr1_rreg & ~bitfield(8, 3, eim_bl_mask)) | bitfield(8, 3, eim_bl);
+    iowrite32(csxgcr1_wreg, ecs->cs_base + EIM_CS_GCR1);
+	mutex_unlock(&ecs->eim_mutex_lock);
 
 	return count;
 }
 
+// READ & WRITE methods of '/sys/class/eim/eimN/profile' device attribute
+static ssize_t eim_profile_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    eim_cs *ecs = dev_get_drvdata(dev);
+	int eim_profile = 0;
+
+	mutex_lock(&ecs->eim_mutex_lock);
+    eim_profile = ecs->profile_stats.profile;
+	mutex_unlock(&ecs->eim_mutex_lock);
+
+	return sprintf(buf, "%s\n", eim_profile_names[eim_profile]);
+}
+
+static ssize_t eim_profile_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    eim_cs *ecs = dev_get_drvdata(dev);
+	int eim_profile = 0;
+    int ret = 0;
+
+    // profile name or number
+    for (eim_profile = 0; eim_profile < EIM_PROFILE_CNT; eim_profile++)
+    {
+        if (0 == strncmp(buf, eim_profile_names[eim_profile], strlen(eim_profile_names[eim_profile])))
+        {
+            break;
+        }
+    }
+    if (EIM_PROFILE_CNT == eim_profile)
+    {
+        eim_profile = simple_strtoul(buf, NULL, 10);
+    }
+
+	mutex_lock(&ecs->eim_mutex_lock);
+    ret = eim_profile_apply(ecs, eim_profile);
+	mutex_unlock(&ecs->eim_mutex_lock);
+
+	return ret ? ret : count;
+}
+
 // define device attributes
 static DEVICE_ATTR(dmode, S_IRUGO | S_IWUSR, eim_dmode_show, eim_dmode_store);
 static DEVICE_ATTR(MUM, S_IRUGO | S_IWUSR, eim_mum_show, eim_mum_store);
 static DEVICE_ATTR(BCD, S_IRUGO | S_IWUSR, eim_bcd_show, eim_bcd_store);
 static DEVICE_ATTR(WWSC, S_IRUGO | S_IWUSR, eim_wwsc_show, eim_wwsc_store);
+static DEVICE_ATTR(RWSC, S_IRUGO | S_IWUSR, eim_rwsc_show, eim_rwsc_store);
+static DEVICE_ATTR(BL, S_IRUGO | S_IWUSR, eim_bl_show, eim_bl_store);
+static DEVICE_ATTR(profile, S_IRUGO | S_IWUSR, eim_profile_show, eim_profile_store);
 
 // ------------------------------------------------------------
 // Description :
-// 	   EIM initialization.
+// 	   This function creates the device of one chip select.
 // Parameters :
-//	   None.
+//	   n - chip select number
 // Return Value :
-//	   0 - eim_init success.
+//	   0 - eim_cs_setup success.
 // Errors :
-//     None.
+//     -ENOMEM - kzalloc failed
+//     -EFAULT - cdev / device / attribute creation failed
 // ------------------------------------------------------------
-static int __init eim_init(void)
+static int eim_cs_setup(int n)
 {
-	int err = 0;
-    int ret_alloc_chrdev_region = 0;
+    eim_cs *ecs = NULL;
     int ret_cdev_add = 0;
     int ret_device_create_file_dmode = 0;
 	int ret_device_create_file_mum = 0;
     int ret_device_create_file_bcd = 0;
     int ret_device_create_file_wwsc = 0;
-    int ret_eim_map = 0;
-    int ret_eim_config_1 = 0;
-	int ret_eim_config_2 = 0;
-
-	// allocate memory for eim device
-	// kzalloc() is equivalent to kmalloc() and memset()
-    mdev = kzalloc(sizeof(eim_dev), GFP_KERNEL);
-    if (!mdev)
-    {
-        err = -ENOMEM;
-        goto kfree_mdev;
-    }
+    int ret_device_create_file_rwsc = 0;
+    int ret_device_create_file_bl = 0;
+    int ret_device_create_file_profile = 0;
 
-	// register device major and minor number dynamically
-    ret_alloc_chrdev_region = alloc_chrdev_region(&mdev->devno, 0, 1, DEVICE_NAME);
-    if (ret_alloc_chrdev_region < 0)
+    ecs = kzalloc(sizeof(eim_cs), GFP_KERNEL);
+    if (!ecs)
     {
-        printk(KERN_ERR "< eim.c > setup_eim : alloc_chrdev region failed.\n");
-        goto unregister_mdev;
+        return -ENOMEM;
     }
 
-	// allocate memory for char device
-    mdev->cdev = kzalloc(sizeof(struct cdev), GFP_KERNEL);
-    if (!mdev->cdev)
+	// initiate cs / window / open_state / eim_dmode / eim_mutex_lock
+    ecs->cs = n;
+    ecs->devno = MKDEV(MAJOR(mdev->devno), n);
+    ecs->mem_len = (cs_mask & 0xC) ? EIM_MEM_LEN_4CS : EIM_MEM_LEN;
+    ecs->mem_phys = EIM_MEM_BASE + n * ecs->mem_len;
+    atomic_set(&ecs->open_state, 1);
+    ecs->eim_dmode = DOWNLOAD_PARAMETERS;
+    mutex_init(&ecs->eim_mutex_lock);
+
+    ecs->bounce = kmalloc(EIM_BOUNCE_LEN, GFP_KERNEL);
+    if (!ecs->bounce)
     {
-        err = -ENOMEM;
-        goto kfree_cdev;
+        kfree(ecs);
+        return -ENOMEM;
     }
-    cdev_init(mdev->cdev, &eim_fops);
-    mdev->cdev->owner = THIS_MODULE;
 
     // add char devcie
-    ret_cdev_add = cdev_add(mdev->cdev, mdev->devno, 1);
+    cdev_init(&ecs->cdev, &eim_fops);
+    ecs->cdev.owner = THIS_MODULE;
+    ret_cdev_add = cdev_add(&ecs->cdev, ecs->devno, 1);
     if (ret_cdev_add)
     {
-        printk(KERN_ERR "< eim.c > setup_eim : cdev_add failed");
-        goto delete_cdev;
-    }
-
-	// initiate open_state / eim_dmode / eim_mutex_lock
-    atomic_set(&mdev->open_state, 1);
-    mdev->eim_dmode = DOWNLOAD_PARAMETERS;
-    mutex_init(&mdev->eim_mutex_lock);
-
-	// create directory '/sys/class/eim/'
-    mdev->eim_class = class_create(THIS_MODULE, DEVICE_NAME);
-    if (!mdev->eim_class)
-    {
-        printk(KERN_ERR "< eim.c > setup_eim : class_create failed.\n");
-        err = -EFAULT;
-        goto destroy_class;
+        printk(KERN_ERR "< eim.c > eim_cs_setup : cdev_add CS%d failed.\n", n);
+        kfree(ecs->bounce);
+        kfree(ecs);
+        return -EFAULT;
     }
 
-    // create file node '/dev/eim' and '/sys/class/eim/eim'
-    mdev->eim_device = device_create(mdev->eim_class, NULL, mdev->devno, NULL, "%s", DEVICE_NAME);
-    if (!mdev->eim_device)
+    // create file node '/dev/eimN' and '/sys/class/eim/eimN'
+    ecs->eim_device = device_create(mdev->eim_class, NULL, ecs->devno, ecs, "%s%d", DEVICE_NAME, n);
+    if (!ecs->eim_device)
     {
-        printk(KERN_ERR "< eim.c > setup_eim : device_create failed.\n");
-        err = -EFAULT;
-        goto destroy_device;
+        printk(KERN_ERR "< eim.c > eim_cs_setup : device_create CS%d failed.\n", n);
+        cdev_del(&ecs->cdev);
+        kfree(ecs->bounce);
+        kfree(ecs);
+        return -EFAULT;
     }
-
-    // create device attribute 'sys/class/eim/eim/dmode'
-	// create device attribute 'sys/class/eim/eim/MUM'
-    // create device attribute 'sys/class/eim/eim/BCD'
-    // create device attribute 'sys/class/eim/eim/WWSC'
-    ret_device_create_file_dmode = device_create_file(mdev->eim_device, &dev_attr_dmode);
+    mdev->cs[n] = ecs;
+
+    // create device attribute 'sys/class/eim/eimN/dmode'
+	// create device attribute 'sys/class/eim/eimN/MUM'
+    // create device attribute 'sys/class/eim/eimN/BCD'
+    // create device attribute 'sys/class/eim/eimN/WWSC'
+    // create device attribute 'sys/class/eim/eimN/RWSC'
+    // create device attribute 'sys/class/eim/eimN/BL'
+    // create device attribute 'sys/class/eim/eimN/profile'
+    ret_device_create_file_dmode = device_create_file(ecs->eim_device, &dev_attr_dmode);
     if (ret_device_create_file_dmode)
     {
-        printk(KERN_ERR "< eim.c > setup_eim : device_create_file dmode failed.\n");
-        err = -EFAULT;
-        goto destroy_device;
+        printk(KERN_ERR "< eim.c > eim_cs_setup : device_create_file dmode failed.\n");
+        return -EFAULT;
     }
-	ret_device_create_file_mum = device_create_file(mdev->eim_device, &dev_attr_MUM);
+	ret_device_create_file_mum = device_create_file(ecs->eim_device, &dev_attr_MUM);
 	if (ret_device_create_file_mum)
 	{
-		printk(KERN_ERR "< eim.c > setup_eim : device_create_file MUM failed.\n");
-		err = -EFAULT;
-		goto destroy_device;
+		printk(KERN_ERR "< eim.c > eim_cs_setup : device_create_file MUM failed.\n");
+		return -EFAULT;
 	}
-    ret_device_create_file_bcd = device_create_file(mdev->eim_device, &dev_attr_BCD);
+    ret_device_create_file_bcd = device_create_file(ecs->eim_device, &dev_attr_BCD);
     if (ret_device_create_file_bcd)
     {
-        printk(KERN_ERR "< eim.c > setup_eim : device_create_file BCD failed.\n");
-        err = -EFAULT;
-        goto destroy_device;
+        printk(KERN_ERR "< eim.c > eim_cs_setup : device_create_file BCD failed.\n");
+        return -EFAULT;
     }
-    ret_device_create_file_wwsc = device_create_file(mdev->eim_device, &dev_attr_WWSC);
+    ret_device_create_file_wwsc = device_create_file(ecs->eim_device, &dev_attr_WWSC);
     if (ret_device_create_file_wwsc)
     {
-        printk(KERN_ERR "< eim.c > setup_eim : device_create_file WWSC failed.\n");
+        printk(KERN_ERR "< eim.c > eim_cs_setup : device_create_file WWSC failed.\n");
+        return -EFAULT;
+    }
+    ret_device_create_file_rwsc = device_create_file(ecs->eim_device, &dev_attr_RWSC);
+    if (ret_device_create_file_rwsc)
+    {
+        printk(KERN_ERR "< eim.c > eim_cs_setup : device_create_file RWSC failed.\n");
+        return -EFAULT;
+    }
+    ret_device_create_file_bl = device_create_file(ecs->eim_device, &dev_attr_BL);
+    if (ret_device_create_file_bl)
+    {
+        printk(KERN_ERR "< eim.c > eim_cs_setup : device_create_file BL failed.\n");
+        return -EFAULT;
+    }
+    ret_device_create_file_profile = device_create_file(ecs->eim_device, &dev_attr_profile);
+    if (ret_device_create_file_profile)
+    {
+        printk(KERN_ERR "< eim.c > eim_cs_setup : device_create_file profile failed.\n");
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function removes the device of one chip select.
+// Parameters :
+//	   n - chip select number
+// Return Value :
+//	   None.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+static void eim_cs_destroy(int n)
+{
+    eim_cs *ecs = mdev->cs[n];
+
+    if (!ecs)
+    {
+        return;
+    }
+
+    device_destroy(mdev->eim_class, ecs->devno);
+    cdev_del(&ecs->cdev);
+    kfree(ecs->bounce);
+    kfree(ecs);
+    mdev->cs[n] = NULL;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   EIM initialization.
+// Parameters :
+//	   None.
+// Return Value :
+//	   0 - eim_init success.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+static int __init eim_init(void)
+{
+	int err = 0;
+    int ret_alloc_chrdev_region = 0;
+    int ret_eim_map = 0;
+    int ret_eim_config_1 = 0;
+	int ret_eim_config_2 = 0;
+    int n = 0;
+
+    if ((0 == (cs_mask & 0xF)) || (cs_mask & ~0xF))
+    {
+        printk(KERN_ERR "< eim.c > setup_eim : cs_mask 0x%x is invalid, it should be 0x1 - 0xF.\n", cs_mask);
+        return -EINVAL;
+    }
+#ifdef EIM_HOST_BUILD
+    // a host build has no i.MX6 registers to map
+    if (!loopback)
+    {
+        printk(KERN_ERR "< eim.c > setup_eim : host build needs loopback=1.\n");
+        return -EINVAL;
+    }
+#endif
+
+	// allocate memory for eim device
+	// kzalloc() is equivalent to kmalloc() and memset()
+    mdev = kzalloc(sizeof(eim_dev), GFP_KERNEL);
+    if (!mdev)
+    {
+        return -ENOMEM;
+    }
+    mutex_init(&mdev->eim_iomux_lock);
+    mutex_init(&mdev->eim_fpp_lock);
+
+	// register device major and minor number dynamically (minor n is CSn)
+    ret_alloc_chrdev_region = alloc_chrdev_region(&mdev->devno, 0, EIM_CS_MAX, DEVICE_NAME);
+    if (ret_alloc_chrdev_region < 0)
+    {
+        printk(KERN_ERR "< eim.c > setup_eim : alloc_chrdev region failed.\n");
+        err = ret_alloc_chrdev_region;
+        goto kfree_mdev;
+    }
+
+	// create directory '/sys/class/eim/'
+    mdev->eim_class = EIM_CLASS_CREATE(DEVICE_NAME);
+    if (!mdev->eim_class)
+    {
+        printk(KERN_ERR "< eim.c > setup_eim : class_create failed.\n");
         err = -EFAULT;
-        goto destroy_device;
+        goto unregister_mdev;
+    }
+
+    // one device per enabled chip select
+    for (n = 0; n < EIM_CS_MAX; n++)
+    {
+        if (cs_mask & (1 << n))
+        {
+            err = eim_cs_setup(n);
+            if (err)
+            {
+                goto destroy_cs;
+            }
+        }
     }
 
 	// eim address map
     ret_eim_map = eim_map();
     if (ret_eim_map)
     {
+        err = ret_eim_map;
         goto unmap_eim;
     }
 
@@ -1084,6 +2927,18 @@ static int __init eim_init(void)
         goto unmap_eim;
     }
 
+#ifndef EIM_HOST_BUILD
+    // SDMA write path (CPU copy only in loopback mode)
+    eim_dma_init();
+#endif
+
+    // no FPP GPIO and pad control in loopback mode
+    if (loopback)
+    {
+        printk(KERN_INFO "< eim.c > setup_eim : loopback mode, EIM window is RAM.\n");
+        return 0;
+    }
+
     // GPIO init
     gpio_request(GPIO_FPP_UNUSE, "UNUSE");
     gpio_request(GPIO_FPP_nCONFIG, "nCONFIG");
@@ -1105,23 +2960,19 @@ static int __init eim_init(void)
 unmap_eim :
 	eim_unmap();
 
-destroy_device :
-	device_destroy(mdev->eim_class, mdev->devno);
-
-destroy_class :
+destroy_cs :
+    for (n = 0; n < EIM_CS_MAX; n++)
+    {
+        eim_cs_destroy(n);
+    }
 	class_destroy(mdev->eim_class);
 
-delete_cdev :
-	cdev_del(mdev->cdev);
-
-kfree_cdev :
-	kfree(mdev->cdev);
-
 unregister_mdev :
-	unregister_chrdev_region(mdev->devno, 1);
+	unregister_chrdev_region(mdev->devno, EIM_CS_MAX);
 
 kfree_mdev :
 	kfree(mdev);
+    mdev = NULL;
 
     return err;
 }
@@ -1138,39 +2989,41 @@ kfree_mdev :
 // ------------------------------------------------------------
 static void __exit eim_exit(void)
 {
+    int n = 0;
+
    	if (mdev)
     {
+#ifndef EIM_HOST_BUILD
+        eim_dma_exit();
+#endif
         eim_unmap();
 
-		if (mdev->eim_device)
-		{
-			device_destroy(mdev->eim_class, mdev->devno);
-		}
+        for (n = 0; n < EIM_CS_MAX; n++)
+        {
+            eim_cs_destroy(n);
+        }
 
 		if (mdev->eim_class)
 		{
 			class_destroy(mdev->eim_class);
 		}
 
-        if (mdev->cdev)
-        {
-            cdev_del(mdev->cdev);
-            kfree(mdev->cdev);
-        }
-
         if (mdev->devno)
         {
-            unregister_chrdev_region(mdev->devno, 1);
+            unregister_chrdev_region(mdev->devno, EIM_CS_MAX);
         }
 
         kfree(mdev);
     }
 
     // release GPIO
-    gpio_free(GPIO_FPP_UNUSE);
-    gpio_free(GPIO_FPP_nCONFIG);
-    gpio_free(GPIO_FPP_nSTATUS);
-    gpio_free(GPIO_FPP_CONF_DONE);
+    if (!loopback)
+    {
+        gpio_free(GPIO_FPP_UNUSE);
+        gpio_free(GPIO_FPP_nCONFIG);
+        gpio_free(GPIO_FPP_nSTATUS);
+        gpio_free(GPIO_FPP_CONF_DONE);
+    }
 
 #if DEBUG == 1
     printk(KERN_INFO "< eim.c > eim exit.\n");
@@ -1182,5 +3035,5 @@ module_exit(eim_exit);
 
 MODULE_AUTHOR("Young");
 MODULE_LICENSE("GPL");
-MODULE_VERSION("1.2");
+MODULE_VERSION("2.3");
 MODULE_DESCRIPTION("Freescale i.MX6 EIM port Module");
@@ -0,0 +1,203 @@
+// NAME : eim copy routines
+// FUNC : halfword granular, burst aligned copies to and from the EIM window
+// DATE : 2026.10.19
+// DESP : header only, usable from eim.c and user space (libeim mmap path)
+//        the window is only accessed with 16-bit or 32-bit loads / stores,
+//        never with bytes : the FPGA has no byte enables, so writes are
+//        whole halfwords (callers refuse odd lengths) and nothing is read
+//        back from the window on the way in
+//        head : halfwords up to the first burst / page boundary of the window
+//        body : 32-byte LDM / STM blocks on ARM when both sides are word
+//               aligned, 32-bit or 16-bit C loop otherwise
+//        tail : halfwords
+// HIST : V1.0 2026.10.19 - eim copy routines
+//        V1.1 2026.10.19 - page size only with APR
+//        V1.2 2026.10.19 - even write lengths only, no read-modify-write of the window
+
+#ifndef _EIM_COPY_H_
+#define _EIM_COPY_H_
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+typedef u16 eim_copy_u16;
+typedef u32 eim_copy_u32;
+#else
+#include <stddef.h>
+#include <stdint.h>
+typedef uint16_t eim_copy_u16;
+typedef uint32_t eim_copy_u32;
+#endif
+
+// bytes per LDM / STM block
+#define EIM_COPY_BLOCK              (32)
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the window alignment of a copy from the CS setting.
+// Parameters :
+//     bl - burst length field (0 - 3 : 4 / 8 / 16 / 32 words, 4 : continuous)
+//     psz - page size field (0 - 8 : 8 - 2048 words)
+//     apr - asynchronous page read field (psz is ignored unless it is 1)
+//     port_bytes - bytes per bus word (1 / 2 / 4)
+// Return Value :
+//     alignment in bytes (power of 2, EIM_COPY_BLOCK - 4096)
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline size_t eim_copy_align(int bl, int psz, int apr, int port_bytes)
+{
+    size_t burst = (size_t)((bl < 4) ? (4 << bl) : 32) * port_bytes;
+    size_t page = (apr && (psz <= 8)) ? (size_t)(8 << psz) * port_bytes : 0;
+    size_t align = (page > burst) ? page : burst;
+
+    if (align < EIM_COPY_BLOCK)
+    {
+        align = EIM_COPY_BLOCK;
+    }
+    if (align > 4096)
+    {
+        align = 4096;
+    }
+
+    return align;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function copies whole blocks between word aligned buffers,
+//     32 bytes per iteration.
+// Parameters :
+//     dst - destination (word aligned)
+//     src - source (word aligned)
+//     blocks - the number of EIM_COPY_BLOCK blocks (not 0)
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline void eim_copy_blocks(volatile void *dst, const volatile void *src, size_t blocks)
+{
+#if defined(__arm__)
+    // r3 - r6 only, r7 / r9 / r10 may be reserved by the ABI or the kernel
+    __asm__ __volatile__(
+        "1: ldmia   %1!, {r3 - r6}      \n"
+        "   stmia   %0!, {r3 - r6}      \n"
+        "   ldmia   %1!, {r3 - r6}      \n"
+        "   stmia   %0!, {r3 - r6}      \n"
+        "   subs    %2, %2, #1          \n"
+        "   bne     1b                  \n"
+        : "+r" (dst), "+r" (src), "+r" (blocks)
+        :
+        : "r3", "r4", "r5", "r6", "cc", "memory");
+#else
+    volatile eim_copy_u32 *d = (volatile eim_copy_u32 *)dst;
+    const volatile eim_copy_u32 *s = (const volatile eim_copy_u32 *)src;
+    size_t i = 0;
+
+    for (i = 0; i < blocks * (EIM_COPY_BLOCK / 4); i++)
+    {
+        d[i] = s[i];
+    }
+#endif
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function copies memory into the EIM window.
+// Parameters :
+//     dst - window address (halfword aligned)
+//     src - source in cached memory
+//     len - bytes (even, an odd last byte is not written)
+//     align - window alignment (eim_copy_align)
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline void eim_copy_toio16(volatile void *dst, const void *src, size_t len, size_t align)
+{
+    volatile eim_copy_u16 *d = (volatile eim_copy_u16 *)dst;
+    const unsigned char *s = (const unsigned char *)src;
+
+    // head : halfwords up to the first burst boundary
+    while ((len >= 2) && ((unsigned long)d & (align - 1)))
+    {
+        *d++ = (eim_copy_u16)(s[0] | (s[1] << 8));
+        s += 2;
+        len -= 2;
+    }
+
+    // body : whole blocks
+    if ((len >= EIM_COPY_BLOCK) && (0 == ((unsigned long)s & 3)))
+    {
+        size_t blocks = len / EIM_COPY_BLOCK;
+        eim_copy_blocks(d, s, blocks);
+        d += blocks * EIM_COPY_BLOCK / 2;
+        s += blocks * EIM_COPY_BLOCK;
+        len -= blocks * EIM_COPY_BLOCK;
+    }
+
+    // tail
+    while (len >= 2)
+    {
+        *d++ = (eim_copy_u16)(s[0] | (s[1] << 8));
+        s += 2;
+        len -= 2;
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function copies the EIM window into memory.
+// Parameters :
+//     dst - destination in cached memory
+//     src - window address (halfword aligned)
+//     len - bytes
+//     align - window alignment (eim_copy_align)
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline void eim_copy_fromio16(void *dst, const volatile void *src, size_t len, size_t align)
+{
+    unsigned char *d = (unsigned char *)dst;
+    const volatile eim_copy_u16 *s = (const volatile eim_copy_u16 *)src;
+    eim_copy_u16 v = 0;
+
+    // head : halfwords up to the first burst boundary
+    while ((len >= 2) && ((unsigned long)s & (align - 1)))
+    {
+        v = *s++;
+        d[0] = (unsigned char)v;
+        d[1] = (unsigned char)(v >> 8);
+        d += 2;
+        len -= 2;
+    }
+
+    // body : whole blocks
+    if ((len >= EIM_COPY_BLOCK) && (0 == ((unsigned long)d & 3)))
+    {
+        size_t blocks = len / EIM_COPY_BLOCK;
+        eim_copy_blocks(d, s, blocks);
+        s += blocks * EIM_COPY_BLOCK / 2;
+        d += blocks * EIM_COPY_BLOCK;
+        len -= blocks * EIM_COPY_BLOCK;
+    }
+
+    // tail
+    while (len >= 2)
+    {
+        v = *s++;
+        d[0] = (unsigned char)v;
+        d[1] = (unsigned char)(v >> 8);
+        d += 2;
+        len -= 2;
+    }
+    if (len)
+    {
+        d[0] = (unsigned char)*s;
+    }
+}
+
+#endif
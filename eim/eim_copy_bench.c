@@ -0,0 +1,263 @@
+// eim_copy_bench.c
+// EIM window copy microbenchmark
+// read / write : driver copy_from_user / copy_to_user (copy16 = 0)
+//                against the halfword bounce copy (copy16 = 1), SDMA off
+//                and then with the driver's CPU / SDMA choice per request
+// mmap         : memcpy on the mapped window against eim_copy_toio16 / fromio16,
+//                once per mmap cache attribute (EIM_MMAP_OFFSET)
+// ./eim_copy_bench              - 64 KB blocks, 256 loops
+// ./eim_copy_bench 16 1000      - 16 KB blocks, 1000 loops
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+
+#include "eim_ioctl.h"
+#include "eim_timing.h"
+#include "eim_copy.h"
+
+// write an integer to a sysfs / module parameter file
+static void write_param(const char *path, int val)
+{
+    char wbuf[10] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return;
+    }
+    sprintf(wbuf, "%d", val);
+    write(fd, (void *)wbuf, 10);
+    close(fd);
+}
+
+// read an integer from a sysfs / module parameter file
+static int read_param(const char *path)
+{
+    char rbuf[10] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    read(fd, (void *)rbuf, 10);
+    close(fd);
+
+    return atoi(rbuf);
+}
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+// MB/s of loops blocks of len bytes
+static float mbps(long us, int len, int loops)
+{
+    return us ? (float)len * loops / us * 1000000 / 1024 / 1024 : 0;
+}
+
+// time write() and read() of the driver
+static void bench_rw(int fd, unsigned char *wbuf, unsigned char *rbuf, int len, int loops, const char *name)
+{
+    struct timeval tstart, tend;
+    long wus = 0;
+    long rus = 0;
+
+    gettimeofday(&tstart, NULL);
+    for (int i = 0; i < loops; i++)
+    {
+        write(fd, (void *)wbuf, len);
+    }
+    gettimeofday(&tend, NULL);
+    wus = elapsed_us(&tstart, &tend);
+
+    gettimeofday(&tstart, NULL);
+    for (int i = 0; i < loops; i++)
+    {
+        read(fd, (void *)rbuf, len);
+    }
+    gettimeofday(&tend, NULL);
+    rus = elapsed_us(&tstart, &tend);
+
+    printf("%-30s write %8.2f MB/s  read %8.2f MB/s  %s\n", name,
+            mbps(wus, len, loops), mbps(rus, len, loops), memcmp(wbuf, rbuf, len) ? "mismatch" : "ok");
+}
+
+static const char *mode_names[EIM_MMAP_MODE_CNT] = {
+    "legacy",
+    "write-combine",
+    "strongly ordered",
+    "cached",
+};
+
+// time memcpy or eim_copy on the mapped window
+static void bench_mmap(unsigned char *window, unsigned char *wbuf, unsigned char *rbuf, int len, int loops,
+        size_t align, int use_copy16, int mode)
+{
+    char name[40] = {0};
+    struct timeval tstart, tend;
+    long wus = 0;
+    long rus = 0;
+
+    gettimeofday(&tstart, NULL);
+    for (int i = 0; i < loops; i++)
+    {
+        if (use_copy16)
+            eim_copy_toio16(window, wbuf, len, align);
+        else
+            memcpy(window, wbuf, len);
+    }
+    gettimeofday(&tend, NULL);
+    wus = elapsed_us(&tstart, &tend);
+
+    gettimeofday(&tstart, NULL);
+    for (int i = 0; i < loops; i++)
+    {
+        if (use_copy16)
+            eim_copy_fromio16(rbuf, window, len, align);
+        else
+            memcpy(rbuf, window, len);
+    }
+    gettimeofday(&tend, NULL);
+    rus = elapsed_us(&tstart, &tend);
+
+    sprintf(name, "%s %s", mode_names[mode], use_copy16 ? "eim_copy" : "memcpy");
+    printf("%-30s write %8.2f MB/s  read %8.2f MB/s  %s\n", name,
+            mbps(wus, len, loops), mbps(rus, len, loops), memcmp(wbuf, rbuf, len) ? "mismatch" : "ok");
+}
+
+int main(int argc, char **argv)
+{
+    int len = 64 * 1024;
+    int loops = 256;
+    struct eim_cs_config cfg;
+    unsigned char *wbuf = NULL;
+    unsigned char *rbuf = NULL;
+    unsigned char *window = NULL;
+    size_t align = EIM_COPY_BLOCK;
+    int copy16 = 0;
+    int dma_write = 0;
+    int dma_read = 0;
+    struct eim_engine_stats stats;
+    int fd = 0;
+
+    if (argc >= 2)
+    {
+        len = atoi(argv[1]) * 1024;
+    }
+    if (argc >= 3)
+    {
+        loops = atoi(argv[2]);
+    }
+    if ((len <= 0) || (loops <= 0))
+    {
+        printf("Wrong arguments.\n");
+        return -1;
+    }
+
+    wbuf = (unsigned char *)malloc(len);
+    rbuf = (unsigned char *)malloc(len);
+    if ((NULL == wbuf) || (NULL == rbuf))
+    {
+        printf("malloc failed.\n");
+        return -1;
+    }
+    for (int i = 0; i < len; i++)
+    {
+        wbuf[i] = i % 251;
+    }
+
+    // parameter download profile, CPU copies only
+    fd = open("/dev/eim1", O_RDWR);
+    if (fd < 0)
+    {
+        printf("open /dev/eim1 failed.\n");
+        return -1;
+    }
+    ioctl(fd, EIM_IOC_SET_PROFILE, EIM_PROFILE_PARAMETERS);
+    memset(&cfg, 0, sizeof(cfg));
+    if (0 == ioctl(fd, EIM_IOC_GET_CONFIG, &cfg))
+    {
+        align = eim_copy_align(cfg.BL, cfg.PSZ, cfg.APR, eim_timing_port_bytes(cfg.DSZ));
+    }
+    copy16 = read_param("/sys/module/eim/parameters/copy16");
+    dma_write = read_param("/sys/module/eim/parameters/dma_write");
+    dma_read = read_param("/sys/module/eim/parameters/dma_read");
+    write_param("/sys/module/eim/parameters/dma_write", 0);
+    write_param("/sys/module/eim/parameters/dma_read", 0);
+
+    printf("------------------------------------\n");
+    printf("EIM copy : %d bytes x %d loops, alignment %d bytes.\n", len, loops, (int)align);
+    printf("SDMA cutoffs : read %d bytes, write %d bytes.\n", cfg.dma_read_cutoff, cfg.dma_write_cutoff);
+    printf("------------------------------------\n");
+
+    write_param("/sys/module/eim/parameters/copy16", 0);
+    memset(rbuf, 0, len);
+    bench_rw(fd, wbuf, rbuf, len, loops, "read/write copy_user");
+
+    write_param("/sys/module/eim/parameters/copy16", 1);
+    memset(rbuf, 0, len);
+    bench_rw(fd, wbuf, rbuf, len, loops, "read/write copy16");
+
+    // driver choice, the engine counters show which path carried the requests
+    write_param("/sys/module/eim/parameters/dma_write", dma_write < 0 ? 1 : dma_write);
+    write_param("/sys/module/eim/parameters/dma_read", dma_read < 0 ? 1 : dma_read);
+    memset(rbuf, 0, len);
+    bench_rw(fd, wbuf, rbuf, len, loops, "read/write auto");
+    memset(&stats, 0, sizeof(stats));
+    if (0 == ioctl(fd, EIM_IOC_GET_ENGINE_STATS, &stats))
+    {
+        printf("engine counters : CPU %u reads %llu bytes, %u writes %llu bytes\n",
+                stats.cpu_reads, stats.cpu_read_bytes, stats.cpu_writes, stats.cpu_write_bytes);
+        printf("                  SDMA %u reads %llu bytes, %u writes %llu bytes\n",
+                stats.dma_reads, stats.dma_read_bytes, stats.dma_writes, stats.dma_write_bytes);
+    }
+    write_param("/sys/module/eim/parameters/dma_write", 0);
+    write_param("/sys/module/eim/parameters/dma_read", 0);
+
+    for (int mode = 0; mode < EIM_MMAP_MODE_CNT; mode++)
+    {
+        window = (unsigned char *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, EIM_MMAP_OFFSET(mode));
+        if (MAP_FAILED == window)
+        {
+            // cached mappings are only allowed in loopback mode
+            printf("%-30s mmap refused.\n", mode_names[mode]);
+            continue;
+        }
+        memset(rbuf, 0, len);
+        bench_mmap(window, wbuf, rbuf, len, loops, align, 0, mode);
+        memset(rbuf, 0, len);
+        bench_mmap(window, wbuf, rbuf, len, loops, align, 1, mode);
+        munmap(window, len);
+    }
+    printf("------------------------------------\n");
+
+    // restore driver settings
+    if (copy16 >= 0)
+    {
+        write_param("/sys/module/eim/parameters/copy16", copy16);
+    }
+    if (dma_write >= 0)
+    {
+        write_param("/sys/module/eim/parameters/dma_write", dma_write);
+    }
+    if (dma_read >= 0)
+    {
+        write_param("/sys/module/eim/parameters/dma_read", dma_read);
+    }
+
+    close(fd);
+    free(wbuf);
+    free(rbuf);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+// NAME : eim ioctl interface
+// FUNC : ioctl commands and structures shared by eim.c and libeim
+// DATE : 2026.10.19
+// HIST : V1.0 2026.10.19 - CS timing configuration
+//        V1.1 2026.10.19 - mode profiles
+//        V1.2 2026.10.19 - mmap cache attributes
+//        V1.3 2026.10.19 - CPU / SDMA cutoffs and per-engine counters
+
+#ifndef _EIM_IOCTL_H_
+#define _EIM_IOCTL_H_
+
+#ifdef __KERNEL__
+#include <linux/ioctl.h>
+#else
+#include <sys/ioctl.h>
+#endif
+
+// CS timing configuration --- ref : IMX6DQRM p1038-1050
+// every field of CSxGCR1 / CSxGCR2 / CSxRCR1 / CSxRCR2 / CSxWCR1 / CSxWCR2
+struct eim_cs_config
+{
+    // CSxGCR1
+    int PSZ;        // Page Size (0 - 15)
+    int WP;         // Write Protect
+    int GBC;        // Gap Between CS (0 - 7)
+    int AUS;        // Address Unshifted
+    int CSREC;      // CS Recovery (0 - 7)
+    int SP;         // Supervisor Protect
+    int DSZ;        // Port Size (1 - 7)
+    int BCS;        // Wait Cycle Before Burst Clock Start (0 - 3)
+    int BCD;        // Burst Clock Divisor (0 - 3)
+    int WC;         // Write Continuous
+    int BL;         // Burst Length (0 - 4)
+    int CREP;       // Configuration Register Enable Polarity
+    int CRE;        // Configuration Register Enable
+    int RFL;        // Read Fix Latency
+    int WFL;        // Write Fix Latency
+    int MUM;        // Multiplexed Mode
+    int SRD;        // Synchronous Read Data
+    int SWR;        // Synchronous Write Data
+    int CSEN;       // CS Enable
+
+    // CSxGCR2
+    int M16BG;      // Muxed 16 bypass grant
+    int DAP;        // Data Acknowledge Polarity
+    int DAE;        // Data Acknowledge Enable
+    int DAPS;       // Data Acknowledge Poling Start (0 - 15)
+    int ADH;        // Address Hold Time (0 - 3)
+
+    // CSxRCR1
+    int RWSC;       // Read Wait State Control (0 - 63)
+    int RADVA;      // ADV Assertion (0 - 7)
+    int RAL;        // Read ADV Low
+    int RADVN;      // ADV Negation (0 - 7)
+    int OEA;        // OE Assertion (0 - 7)
+    int OEN;        // OE Negation (0 - 7)
+    int RCSA;       // Read CS Assertion (0 - 7)
+    int RCSN;       // Read CS Negation (0 - 7)
+
+    // CSxRCR2
+    int APR;        // Asynchronous Page Read
+    int PAT;        // Page Access Time (0 - 7)
+    int RL;         // Read Latency (0 - 3)
+    int RBEA;       // Read BE Assertion (0 - 7)
+    int RBE;        // Read BE enable
+    int RBEN;       // Read BE Negation (0 - 7)
+
+    // CSxWCR1
+    int WAL;        // Write ADV Low
+    int WBED;       // Write Byte Enable Disable
+    int WWSC;       // Write Wait State Control (0 - 63)
+    int WADVA;      // ADV Assertion (0 - 7)
+    int WADVN;      // ADV Negation (0 - 7)
+    int WBEA;       // BE Assertion (0 - 7)
+    int WBEN;       // BE[3:0] Negation (0 - 7)
+    int WEA;        // WE Assertion (0 - 7)
+    int WEN;        // WE Negation (0 - 7)
+    int WCSA;       // Write CS Assertion (0 - 7)
+    int WCSN;       // Write CS Negation (0 - 7)
+
+    // CSxWCR2
+    int WBCDD;      // Write Burst Clock Divisor Decrement
+
+    // copy engine (driver settings shared by all chip selects, not CS registers)
+    // smallest transfer in bytes carried by SDMA, smaller ones are CPU copies
+    // EIM_IOC_GET_CONFIG : the current cutoff (EIM_CUTOFF_CPU_ONLY : SDMA never used)
+    // EIM_IOC_SET_CONFIG : 0 keeps the current cutoff, < 0 selects CPU copies only
+    int dma_read_cutoff;
+    int dma_write_cutoff;
+};
+
+#define EIM_CUTOFF_CPU_ONLY     (0x7FFFFFFF)
+
+// mode profiles (EIM_IOC_SET_PROFILE argument), a switch sets dmode, MUM and
+// WWSC only, the other CS fields keep their current value
+#define EIM_PROFILE_PARAMETERS  (0)     // dmode 2, EIM_MUX, WWSC 5 clocks
+#define EIM_PROFILE_PROGRAM     (1)     // dmode 1, EIM_NOMUX, WWSC 4 clocks
+#define EIM_PROFILE_CNT         (2)
+
+// the last profile switch
+struct eim_profile_stats
+{
+    int profile;                // the last profile applied
+    unsigned int switches;      // the number of switches
+    unsigned int last_ns;       // time of the last switch in the driver
+    unsigned int last_regs;     // CSx registers written by the last switch
+    unsigned int last_pads;     // pads set up by the last switch
+};
+
+// mmap cache attributes, selected by the mmap offset :
+// mmap(NULL, len, prot, MAP_SHARED, fd, EIM_MMAP_OFFSET(mode) + window offset)
+#define EIM_MMAP_LEGACY         (0)     // PAGE_SHARED, as before
+#define EIM_MMAP_WC             (1)     // write-combine (normal non-cacheable, bufferable)
+#define EIM_MMAP_SO             (2)     // strongly ordered (device, every access on the bus)
+#define EIM_MMAP_CACHED         (3)     // cacheable (RAM only : loopback window)
+#define EIM_MMAP_MODE_CNT       (4)
+#define EIM_MMAP_MODE_SHIFT     (28)
+#define EIM_MMAP_OFFSET(mode)   ((long)(mode) << EIM_MMAP_MODE_SHIFT)
+
+// bytes and requests carried by each copy engine (one chip select)
+struct eim_engine_stats
+{
+    unsigned int cpu_reads;
+    unsigned int dma_reads;
+    unsigned int cpu_writes;
+    unsigned int dma_writes;
+    unsigned long long cpu_read_bytes;
+    unsigned long long dma_read_bytes;
+    unsigned long long cpu_write_bytes;
+    unsigned long long dma_write_bytes;
+};
+
+// ioctl commands
+#define EIM_IOC_MAGIC           'E'
+#define EIM_IOC_GET_CONFIG      _IOR(EIM_IOC_MAGIC, 1, struct eim_cs_config)
+#define EIM_IOC_SET_CONFIG      _IOW(EIM_IOC_MAGIC, 2, struct eim_cs_config)
+#define EIM_IOC_SET_PROFILE     _IO(EIM_IOC_MAGIC, 3)
+#define EIM_IOC_GET_PROFILE_STATS _IOR(EIM_IOC_MAGIC, 4, struct eim_profile_stats)
+#define EIM_IOC_GET_ENGINE_STATS _IOR(EIM_IOC_MAGIC, 5, struct eim_engine_stats)
+
+#endif
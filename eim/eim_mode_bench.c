@@ -0,0 +1,157 @@
+// eim_mode_bench.c
+// EIM mode switch cost : parameter download <-> program download
+// compares the sysfs path (dmode + MUM + WWSC writes) with one EIM_IOC_SET_PROFILE
+// the sysfs baseline runs with iomux_lazy = 0, so every MUM write sets up all
+// pads again as the driver did before the profiles
+// ./eim_mode_bench              - 1000 switches each
+// ./eim_mode_bench 5000         - 5000 switches each
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "eim_ioctl.h"
+
+// download modes
+#define DOWNLOAD_PROGRAM    (1)
+#define DOWNLOAD_PARAMETERS (2)
+
+// write an integer to '/sys/class/eim/eim1/<name>'
+static void write_attr(const char *name, int val)
+{
+    char path[40] = {0};
+    char wbuf[10] = {0};
+    int fd = 0;
+
+    sprintf(path, "/sys/class/eim/eim1/%s", name);
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return;
+    }
+    sprintf(wbuf, "%d", val);
+    write(fd, (void *)wbuf, 10);
+    close(fd);
+}
+
+#define IOMUX_LAZY_PARAM    "/sys/module/eim/parameters/iomux_lazy"
+
+// write an integer to a module parameter file
+static void write_param(const char *path, int val)
+{
+    char wbuf[12] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return;
+    }
+    snprintf(wbuf, sizeof(wbuf), "%d", val);
+    write(fd, (void *)wbuf, sizeof(wbuf));
+    close(fd);
+}
+
+// read an integer from a module parameter file
+static int read_param(const char *path)
+{
+    char rbuf[12] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    read(fd, (void *)rbuf, sizeof(rbuf) - 1);
+    close(fd);
+
+    return atoi(rbuf);
+}
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+int main(int argc, char **argv)
+{
+    int loops = 1000;
+    struct timeval tstart, tend;
+    struct eim_profile_stats stats;
+    long sysfs_us = 0;
+    long ioctl_us = 0;
+    int iomux_lazy = 0;
+    int fd = 0;
+
+    if (argc == 2)
+    {
+        loops = atoi(argv[1]);
+    }
+    loops = loops < 1 ? 1 : loops;
+
+    fd = open("/dev/eim1", O_RDWR);
+    if (fd < 0)
+    {
+        printf("open /dev/eim1 failed.\n");
+        return -1;
+    }
+
+    // sysfs : three attribute writes per switch, all pads set up on every MUM write
+    iomux_lazy = read_param(IOMUX_LAZY_PARAM);
+    write_param(IOMUX_LAZY_PARAM, 0);
+    gettimeofday(&tstart, NULL);
+    for (int i = 0; i < loops; i++)
+    {
+        if (i & 1)
+        {
+            write_attr("dmode", DOWNLOAD_PARAMETERS);
+            write_attr("MUM", 1);
+            write_attr("WWSC", 1);
+        }
+        else
+        {
+            write_attr("dmode", DOWNLOAD_PROGRAM);
+            write_attr("MUM", 0);
+            write_attr("WWSC", 0);
+        }
+    }
+    gettimeofday(&tend, NULL);
+    sysfs_us = elapsed_us(&tstart, &tend);
+    write_param(IOMUX_LAZY_PARAM, iomux_lazy < 0 ? 1 : iomux_lazy);
+
+    // profile : one ioctl per switch, only differing registers and pads are touched
+    gettimeofday(&tstart, NULL);
+    for (int i = 0; i < loops; i++)
+    {
+        if (ioctl(fd, EIM_IOC_SET_PROFILE, (i & 1) ? EIM_PROFILE_PARAMETERS : EIM_PROFILE_PROGRAM) < 0)
+        {
+            printf("EIM_IOC_SET_PROFILE failed.\n");
+            close(fd);
+            return -1;
+        }
+    }
+    gettimeofday(&tend, NULL);
+    ioctl_us = elapsed_us(&tstart, &tend);
+
+    memset(&stats, 0, sizeof(stats));
+    ioctl(fd, EIM_IOC_GET_PROFILE_STATS, &stats);
+
+    // leave the driver in the parameter download profile
+    ioctl(fd, EIM_IOC_SET_PROFILE, EIM_PROFILE_PARAMETERS);
+    close(fd);
+
+    printf("------------------------------------\n");
+    printf("EIM mode switch : %d switches each.\n", loops);
+    printf("sysfs   : %.2f us per switch.\n", (float)sysfs_us / loops);
+    printf("profile : %.2f us per switch.\n", (float)ioctl_us / loops);
+    printf("last profile switch in the driver : %u ns, %u registers, %u pads.\n",
+            stats.last_ns, stats.last_regs, stats.last_pads);
+    printf("------------------------------------\n");
+
+    return 0;
+}
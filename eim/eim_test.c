@@ -43,10 +43,10 @@ int main(int argc, char **argv)
     
     // open file
     int fd;  
-    fd = open("/dev/eim", O_RDWR);  
+    fd = open("/dev/eim1", O_RDWR);  
     if (fd < 0) 
     {  
-        printf("open /dev/eim failed.\n");  
+        printf("open /dev/eim1 failed.\n");  
         return -1;  
     }    
    
@@ -58,7 +58,7 @@ int main(int argc, char **argv)
 	{
         // write and check download mode
         int dmode_wfd;
-        dmode_wfd = open("/sys/class/eim/eim/dmode", O_RDWR);
+        dmode_wfd = open("/sys/class/eim/eim1/dmode", O_RDWR);
         int wdmode = 0;
         wdmode = (int)DOWNLOAD_MODE;
         char dmode_wbuf[10];
@@ -68,7 +68,7 @@ int main(int argc, char **argv)
         close(dmode_wfd);        
 
         int dmode_rfd;
-        dmode_rfd = open("/sys/class/eim/eim/dmode", O_RDWR);
+        dmode_rfd = open("/sys/class/eim/eim1/dmode", O_RDWR);
         int rdmode = 0;
         char dmode_rbuf[10];
         memset(dmode_rbuf, 0, sizeof(char) * 10);
@@ -0,0 +1,257 @@
+// eim_timing.c
+// EIM bus timing what-if tool (see eim_timing.h for the cycle model)
+// ./eim_timing                              - predict the driver default profiles
+// ./eim_timing -r GCR1 GCR2 RCR1 RCR2 WCR1 WCR2
+//                                           - predict one CS register set (hex)
+// ./eim_timing -k N                         - rank the N fastest legal settings
+// FPGA limits : -s setup_ps -h hold_ps -l read_latency -w write_latency
+// port size   : -p 8 / 16 / 32 (default 16, applies to the profiles and -k)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "eim_timing.h"
+
+// the number of candidates searched by -k
+#define MAX_CANDIDATES      (2 * 2 * 4 * 4 * 8 * 8)
+
+// ranked candidate
+typedef struct _candidate
+{
+    struct eim_timing_fields f;
+    struct eim_timing_burst b;
+    double rd_mbps;
+    double wr_mbps;
+}candidate;
+
+// print violated constraints
+static void print_violations(int tv)
+{
+    if (0 == tv)
+    {
+        printf("ok");
+        return;
+    }
+    if (tv & EIM_TV_PORT_SIZE)
+        printf("PORT_SIZE ");
+    if (tv & EIM_TV_MUX_ADDR)
+        printf("MUX_ADDR ");
+    if (tv & EIM_TV_SETUP)
+        printf("SETUP ");
+    if (tv & EIM_TV_HOLD)
+        printf("HOLD ");
+    if (tv & EIM_TV_RD_LATENCY)
+        printf("RD_LATENCY ");
+    if (tv & EIM_TV_WR_LATENCY)
+        printf("WR_LATENCY ");
+}
+
+// print the prediction of one register set
+static void print_prediction(const char *name, const struct eim_timing_fields *f, const struct eim_fpga_limits *lim)
+{
+    struct eim_timing_burst b;
+    eim_timing_predict(f, &b);
+
+    printf("------------------------------------\n");
+    printf("%s\n", name);
+    printf("MUM %d DSZ %d BCD %d BL %d BCS %d CSREC %d RWSC %d RL %d WWSC %d APR %d PAT %d\n",
+            f->MUM, f->DSZ, f->BCD, f->BL, f->BCS, f->CSREC, f->RWSC, f->RL, f->WWSC, f->APR, f->PAT);
+    printf("BCLK %.2f MHz, %d bytes per burst.\n", 1e6 / b.bclk_ps, b.bytes);
+    printf("Read  burst : %.1f ns, %.2f MB/s.\n", b.rd_ps / 1000.0, eim_timing_mbps(b.bytes, b.rd_ps));
+    printf("Write burst : %.1f ns, %.2f MB/s.\n", b.wr_ps / 1000.0, eim_timing_mbps(b.bytes, b.wr_ps));
+    printf("Constraints : ");
+    print_violations(eim_timing_check(f, lim));
+    printf("\n");
+}
+
+// the register set eim_config() programs (parameter download profile)
+static void default_fields(struct eim_timing_fields *f)
+{
+    memset(f, 0, sizeof(*f));
+    f->PSZ = 0;
+    f->GBC = 1;
+    f->CSREC = 1;
+    f->DSZ = 1;
+    f->BCS = 1;
+    f->BCD = 3;
+    f->BL = 3;
+    f->MUM = 1;
+    f->SRD = 1;
+    f->SWR = 1;
+    f->RWSC = 3;
+    f->APR = 0;
+    f->PAT = 7;
+    f->RL = 0;
+    f->WWSC = 1;
+}
+
+// sort candidates by the slower of read and write throughput
+static int compare_candidate(const void *a, const void *b)
+{
+    const candidate *ca = (const candidate *)a;
+    const candidate *cb = (const candidate *)b;
+    double ma = ca->rd_mbps < ca->wr_mbps ? ca->rd_mbps : ca->wr_mbps;
+    double mb = cb->rd_mbps < cb->wr_mbps ? cb->rd_mbps : cb->wr_mbps;
+
+    if (ma != mb)
+        return ma < mb ? 1 : -1;
+    return 0;
+}
+
+// DSZ of a port width in bits (0 - invalid)
+static int port_dsz(int width)
+{
+    if (8 == width)
+        return 4;
+    if (16 == width)
+        return 1;
+    if (32 == width)
+        return 3;
+    return 0;
+}
+
+// rank all legal combinations of MUM / BCS / BCD / BL / RWSC / WWSC
+static int rank(int num, int dsz, const struct eim_fpga_limits *lim)
+{
+    candidate *cand = NULL;
+    int cnt = 0;
+    int rejected = 0;
+
+    cand = (candidate *)malloc(sizeof(candidate) * MAX_CANDIDATES);
+    if (NULL == cand)
+    {
+        printf("malloc failed.\n");
+        return -1;
+    }
+
+    for (int mum = 0; mum < 2; mum++)
+    for (int bcs = 0; bcs < 2; bcs++)
+    for (int bcd = 0; bcd < 4; bcd++)
+    for (int bl = 0; bl < 4; bl++)
+    for (int rwsc = 0; rwsc < 8; rwsc++)
+    for (int wwsc = 0; wwsc < 8; wwsc++)
+    {
+        candidate *c = &cand[cnt];
+        default_fields(&c->f);
+        c->f.DSZ = dsz;
+        c->f.MUM = mum;
+        c->f.BCS = bcs;
+        c->f.BCD = bcd;
+        c->f.BL = bl;
+        c->f.RWSC = rwsc;
+        c->f.WWSC = wwsc;
+        if (eim_timing_check(&c->f, lim))
+        {
+            rejected++;
+            continue;
+        }
+        eim_timing_predict(&c->f, &c->b);
+        c->rd_mbps = eim_timing_mbps(c->b.bytes, c->b.rd_ps);
+        c->wr_mbps = eim_timing_mbps(c->b.bytes, c->b.wr_ps);
+        cnt++;
+    }
+
+    qsort(cand, cnt, sizeof(candidate), compare_candidate);
+
+    printf("------------------------------------\n");
+    printf("%d legal settings, %d rejected by FPGA limits.\n", cnt, rejected);
+    printf("rank  MUM BCS BCD BL RWSC WWSC  read MB/s  write MB/s\n");
+    for (int i = 0; i < num && i < cnt; i++)
+    {
+        candidate *c = &cand[i];
+        printf("%4d  %3d %3d %3d %2d %4d %4d  %9.2f  %10.2f\n", i + 1,
+                c->f.MUM, c->f.BCS, c->f.BCD, c->f.BL, c->f.RWSC, c->f.WWSC,
+                c->rd_mbps, c->wr_mbps);
+    }
+    printf("------------------------------------\n");
+
+    free(cand);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    struct eim_fpga_limits lim;
+    struct eim_timing_fields f;
+    int opt = 0;
+    int num = 0;
+    int regs_given = 0;
+    int dsz = 1;
+
+    lim.tsu_ps = EIM_FPGA_TSU_PS;
+    lim.th_ps = EIM_FPGA_TH_PS;
+    lim.rd_latency = EIM_FPGA_RD_LATENCY;
+    lim.wr_latency = EIM_FPGA_WR_LATENCY;
+
+    while ((opt = getopt(argc, argv, "rk:s:h:l:w:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            regs_given = 1;
+            break;
+        case 'k':
+            num = atoi(optarg);
+            break;
+        case 's':
+            lim.tsu_ps = atoi(optarg);
+            break;
+        case 'h':
+            lim.th_ps = atoi(optarg);
+            break;
+        case 'l':
+            lim.rd_latency = atoi(optarg);
+            break;
+        case 'w':
+            lim.wr_latency = atoi(optarg);
+            break;
+        case 'p':
+            dsz = port_dsz(atoi(optarg));
+            if (0 == dsz)
+            {
+                printf("input error : -p needs 8, 16 or 32.\n");
+                return -1;
+            }
+            break;
+        default:
+            printf("Wrong arguments.\n");
+            return -1;
+        }
+    }
+
+    if (regs_given)
+    {
+        struct eim_timing_regs regs;
+        if (argc - optind != 6)
+        {
+            printf("input error : -r needs GCR1 GCR2 RCR1 RCR2 WCR1 WCR2.\n");
+            return -1;
+        }
+        regs.gcr1 = strtoul(argv[optind + 0], NULL, 16);
+        regs.gcr2 = strtoul(argv[optind + 1], NULL, 16);
+        regs.rcr1 = strtoul(argv[optind + 2], NULL, 16);
+        regs.rcr2 = strtoul(argv[optind + 3], NULL, 16);
+        regs.wcr1 = strtoul(argv[optind + 4], NULL, 16);
+        regs.wcr2 = strtoul(argv[optind + 5], NULL, 16);
+        eim_timing_decode(&regs, &f);
+        print_prediction("CS register set", &f, &lim);
+        return 0;
+    }
+
+    if (num > 0)
+    {
+        return rank(num, dsz, &lim);
+    }
+
+    // driver defaults : parameter download and program download profiles
+    default_fields(&f);
+    f.DSZ = dsz;
+    print_prediction("download parameters (EIM_MUX, WWSC 5 clocks)", &f, &lim);
+    f.MUM = 0;
+    f.WWSC = 0;
+    print_prediction("download program (EIM_NOMUX, WWSC 4 clocks)", &f, &lim);
+
+    return 0;
+}
@@ -0,0 +1,289 @@
+// NAME : eim timing model
+// FUNC : predict EIM bus cycles and throughput from a CS register set
+// DATE : 2026.10.19
+// DESP : header only, integer arithmetic, usable from eim.c and user space
+//        cycle model (ref : IMX6DQRM p1016-1050)
+//          BCLK period = (BCD + 1) EIM clocks (132 MHz)
+//          sync burst  = BCS + CSREC EIM clocks
+//                        + wait states + burst words BCLKs
+//          read wait   = RWSC + RL BCLKs, write wait = WWSC BCLKs
+//          multiplexed mode drives the address in the first wait state BCLK,
+//          so MUM = 1 needs at least one wait state
+//          async access = (WSC + 1) EIM clocks per word, page mode reads
+//          (APR = 1) cost RWSC for the first word and PAT + 2 for the others
+//        GBC only applies when switching chip select and is not counted
+// HIST : V1.0 2026.10.19 - eim timing model
+
+#ifndef _EIM_TIMING_H_
+#define _EIM_TIMING_H_
+
+// EIM clock (132 MHz) period in ps
+#define EIM_TIMING_ACLK_PS          (7576)
+
+// words of a continuous burst (BL = 4) counted per burst
+#define EIM_TIMING_CONT_WORDS       (32)
+
+// default front-end FPGA limits
+#define EIM_FPGA_TSU_PS             (5000)      // data setup before BCLK edge
+#define EIM_FPGA_TH_PS              (1500)      // data hold after BCLK edge
+#define EIM_FPGA_RD_LATENCY         (3)         // BCLKs from address to read data
+#define EIM_FPGA_WR_LATENCY         (0)         // BCLKs from address to write data
+
+// constraint violations (bit mask)
+#define EIM_TV_PORT_SIZE            (1 << 0)    // reserved DSZ value
+#define EIM_TV_MUX_ADDR             (1 << 1)    // no BCLK left for the mux address phase
+#define EIM_TV_SETUP                (1 << 2)    // half BCLK period shorter than FPGA setup
+#define EIM_TV_HOLD                 (1 << 3)    // half BCLK period shorter than FPGA hold
+#define EIM_TV_RD_LATENCY           (1 << 4)    // read data sampled before FPGA drives it
+#define EIM_TV_WR_LATENCY           (1 << 5)    // write data driven before FPGA accepts it
+
+// CSxGCR1 / CSxGCR2 / CSxRCR1 / CSxRCR2 / CSxWCR1 / CSxWCR2 register set
+struct eim_timing_regs
+{
+    unsigned int gcr1;
+    unsigned int gcr2;
+    unsigned int rcr1;
+    unsigned int rcr2;
+    unsigned int wcr1;
+    unsigned int wcr2;
+};
+
+// timing-related register fields
+struct eim_timing_fields
+{
+    int PSZ;
+    int GBC;
+    int CSREC;
+    int DSZ;
+    int BCS;
+    int BCD;
+    int BL;
+    int MUM;
+    int SRD;
+    int SWR;
+    int RWSC;
+    int APR;
+    int PAT;
+    int RL;
+    int WWSC;
+};
+
+// FPGA timing limits
+struct eim_fpga_limits
+{
+    unsigned int tsu_ps;
+    unsigned int th_ps;
+    int rd_latency;
+    int wr_latency;
+};
+
+// predicted cost of one burst
+struct eim_timing_burst
+{
+    int bytes;                  // bytes per burst
+    unsigned int bclk_ps;       // BCLK period
+    unsigned int rd_ps;         // time of one read burst
+    unsigned int wr_ps;         // time of one write burst
+};
+
+// get bits [shift + bits - 1 : shift] of reg
+static inline int eim_timing_field(unsigned int reg, int shift, int bits)
+{
+    return (int)((reg >> shift) & ((1U << bits) - 1));
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function decodes the timing fields of a CS register set.
+// Parameters :
+//     regs - CS register set
+//     f - decoded fields
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline void eim_timing_decode(const struct eim_timing_regs *regs, struct eim_timing_fields *f)
+{
+    f->PSZ   = eim_timing_field(regs->gcr1, 28, 4);
+    f->GBC   = eim_timing_field(regs->gcr1, 24, 3);
+    f->CSREC = eim_timing_field(regs->gcr1, 20, 3);
+    f->DSZ   = eim_timing_field(regs->gcr1, 16, 3);
+    f->BCS   = eim_timing_field(regs->gcr1, 14, 2);
+    f->BCD   = eim_timing_field(regs->gcr1, 12, 2);
+    f->BL    = eim_timing_field(regs->gcr1, 8, 3);
+    f->MUM   = eim_timing_field(regs->gcr1, 3, 1);
+    f->SRD   = eim_timing_field(regs->gcr1, 2, 1);
+    f->SWR   = eim_timing_field(regs->gcr1, 1, 1);
+    f->RWSC  = eim_timing_field(regs->rcr1, 24, 6);
+    f->APR   = eim_timing_field(regs->rcr2, 15, 1);
+    f->PAT   = eim_timing_field(regs->rcr2, 12, 3);
+    f->RL    = eim_timing_field(regs->rcr2, 8, 2);
+    f->WWSC  = eim_timing_field(regs->wcr1, 24, 6);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the port width in bytes from DSZ.
+// Parameters :
+//     dsz - port size field
+// Return Value :
+//     1 / 2 / 4 - bytes per bus word
+//     0 - reserved DSZ value
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline int eim_timing_port_bytes(int dsz)
+{
+    if ((1 == dsz) || (2 == dsz))
+    {
+        return 2;
+    }
+    if (3 == dsz)
+    {
+        return 4;
+    }
+    if (dsz >= 4)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the number of words in one burst from BL.
+// Parameters :
+//     bl - burst length field
+// Return Value :
+//     4 / 8 / 16 / 32 words, EIM_TIMING_CONT_WORDS for continuous burst
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline int eim_timing_burst_words(int bl)
+{
+    return (bl < 4) ? (4 << bl) : EIM_TIMING_CONT_WORDS;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function predicts the bus time of one read and one write burst.
+// Parameters :
+//     f - decoded register fields
+//     b - predicted burst cost
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline void eim_timing_predict(const struct eim_timing_fields *f, struct eim_timing_burst *b)
+{
+    int words = eim_timing_burst_words(f->BL);
+    unsigned int aclk = EIM_TIMING_ACLK_PS;
+    unsigned int overhead = (f->BCS + f->CSREC) * aclk;
+    int rd_wait = f->RWSC + f->RL;
+    int wr_wait = f->WWSC;
+
+    b->bytes = words * eim_timing_port_bytes(f->DSZ);
+    b->bclk_ps = (f->BCD + 1) * aclk;
+
+    // address phase takes the first wait state BCLK in multiplexed mode
+    if (f->MUM)
+    {
+        rd_wait = rd_wait < 1 ? 1 : rd_wait;
+        wr_wait = wr_wait < 1 ? 1 : wr_wait;
+    }
+
+    // read
+    if (f->SRD)
+    {
+        b->rd_ps = overhead + (rd_wait + words) * b->bclk_ps;
+    }
+    else if (f->APR)
+    {
+        b->rd_ps = overhead + (f->RWSC + 1 + (words - 1) * (f->PAT + 2)) * aclk;
+    }
+    else
+    {
+        b->rd_ps = overhead + words * (f->RWSC + 1) * aclk;
+    }
+
+    // write
+    if (f->SWR)
+    {
+        b->wr_ps = overhead + (wr_wait + words) * b->bclk_ps;
+    }
+    else
+    {
+        b->wr_ps = overhead + words * (f->WWSC + 1) * aclk;
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function checks a register set against the FPGA limits.
+// Parameters :
+//     f - decoded register fields
+//     lim - FPGA timing limits
+// Return Value :
+//     0 - no violation
+//     EIM_TV_* bit mask - violated constraints
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline int eim_timing_check(const struct eim_timing_fields *f, const struct eim_fpga_limits *lim)
+{
+    int ret = 0;
+    unsigned int half_bclk_ps = (f->BCD + 1) * EIM_TIMING_ACLK_PS / 2;
+
+    if (0 == eim_timing_port_bytes(f->DSZ))
+    {
+        ret |= EIM_TV_PORT_SIZE;
+    }
+    if (f->MUM && ((f->RWSC + f->RL) < 1 || f->WWSC < 1))
+    {
+        ret |= EIM_TV_MUX_ADDR;
+    }
+    if ((f->SRD || f->SWR) && half_bclk_ps < lim->tsu_ps)
+    {
+        ret |= EIM_TV_SETUP;
+    }
+    if ((f->SRD || f->SWR) && half_bclk_ps < lim->th_ps)
+    {
+        ret |= EIM_TV_HOLD;
+    }
+    if ((f->RWSC + f->RL) < lim->rd_latency)
+    {
+        ret |= EIM_TV_RD_LATENCY;
+    }
+    if ((f->WWSC - f->MUM) < lim->wr_latency)
+    {
+        ret |= EIM_TV_WR_LATENCY;
+    }
+
+    return ret;
+}
+
+#ifndef __KERNEL__
+// ------------------------------------------------------------
+// Description :
+// 	   This function converts a burst time to throughput.
+// Parameters :
+//     bytes - bytes per burst
+//     ps - time of one burst
+// Return Value :
+//     throughput in MB/s (1 MB = 1024 * 1024 bytes)
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static inline double eim_timing_mbps(int bytes, unsigned int ps)
+{
+    if (0 == ps)
+    {
+        return 0;
+    }
+    return (double)bytes * 1e12 / ps / 1024 / 1024;
+}
+#endif
+
+#endif
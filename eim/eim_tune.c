@@ -0,0 +1,317 @@
+// eim_tune.c
+// EIM bus timing auto-tuner
+// walks BCD / BL / RWSC / WWSC from the fastest predicted setting (eim_timing.h)
+// to the slowest, runs a PRBS write / read-back loopback at each setting and
+// keeps the first one with zero errors over the whole soak
+// settings that break the FPGA limits (eim_timing_check) are never soaked,
+// the driver gets its original dmode / MUM / BCD / BL / RWSC / WWSC back at exit
+// ./eim_tune                  - soak 4 MB per setting, write ./eim_tune.conf
+// ./eim_tune -s 16 -o file    - soak 16 MB per setting, write file
+// the driver applies the result at load : insmod eim.ko $(cat eim_tune.conf)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "eim_timing.h"
+
+#define LEN                 (512)
+
+// download modes
+#define DOWNLOAD_PARAMETERS (2)
+
+// MUM - mux mode (loopback runs in the parameter download profile)
+#define EIM_MUX             (1)
+
+// the number of BCD / BL / RWSC / WWSC combinations
+#define MAX_CANDIDATES      (4 * 4 * 8 * 8)
+
+// tuning candidate
+typedef struct _candidate
+{
+    struct eim_timing_fields f;
+    unsigned int ps;        // predicted time of the slower burst direction
+}candidate;
+
+// write an integer to '/sys/class/eim/eim1/<name>'
+static int write_attr(const char *name, int val)
+{
+    char path[40] = {0};
+    char wbuf[10] = {0};
+    int fd = 0;
+
+    sprintf(path, "/sys/class/eim/eim1/%s", name);
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        printf("open %s failed.\n", path);
+        return -1;
+    }
+    sprintf(wbuf, "%d", val);
+    write(fd, (void *)wbuf, 10);
+    close(fd);
+
+    return 0;
+}
+
+// read an integer from '/sys/class/eim/eim1/<name>'
+static int read_attr(const char *name)
+{
+    char path[40] = {0};
+    char rbuf[10] = {0};
+    int fd = 0;
+
+    sprintf(path, "/sys/class/eim/eim1/%s", name);
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    read(fd, (void *)rbuf, 10);
+    close(fd);
+
+    return atoi(rbuf);
+}
+
+// PRBS-15 (x^15 + x^14 + 1), one byte per call
+static unsigned char prbs15(unsigned int *state)
+{
+    unsigned char byte = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        unsigned int bit = ((*state >> 14) ^ (*state >> 13)) & 1;
+        *state = ((*state << 1) | bit) & 0x7FFF;
+        byte = (byte << 1) | bit;
+    }
+    return byte;
+}
+
+// the tuned attributes, restored at exit
+static const char *saved_names[] = {"dmode", "MUM", "BCD", "BL", "RWSC", "WWSC"};
+#define SAVED_CNT           (int)(sizeof(saved_names) / sizeof(saved_names[0]))
+
+static void save_attrs(int *saved)
+{
+    for (int i = 0; i < SAVED_CNT; i++)
+    {
+        saved[i] = read_attr(saved_names[i]);
+    }
+}
+
+static void restore_attrs(const int *saved)
+{
+    for (int i = 0; i < SAVED_CNT; i++)
+    {
+        if (saved[i] >= 0)
+        {
+            write_attr(saved_names[i], saved[i]);
+        }
+    }
+}
+
+// sort candidates from the fastest to the slowest predicted burst
+static int compare_candidate(const void *a, const void *b)
+{
+    const candidate *ca = (const candidate *)a;
+    const candidate *cb = (const candidate *)b;
+
+    if (ca->ps != cb->ps)
+        return ca->ps > cb->ps ? 1 : -1;
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function runs the PRBS loopback at the current setting.
+// Parameters :
+//     fd - /dev/eim1 file descriptor
+//     blocks - the number of LEN-byte blocks to soak
+//     seed - PRBS seed
+// Return Value :
+//     the number of wrong bytes (the loop stops at the first wrong block)
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static long loopback(int fd, long blocks, unsigned int seed)
+{
+    unsigned char wbuf[LEN];
+    unsigned char rbuf[LEN];
+    unsigned int state = seed & 0x7FFF ? seed & 0x7FFF : 1;
+    long ecnt = 0;
+
+    for (long i = 0; i < blocks && 0 == ecnt; i++)
+    {
+        for (int j = 0; j < LEN; j++)
+        {
+            wbuf[j] = prbs15(&state);
+        }
+        memset(rbuf, 0, LEN);
+
+        if (write(fd, (void *)wbuf, LEN) != LEN || read(fd, (void *)rbuf, LEN) != LEN)
+        {
+            return LEN;
+        }
+        for (int j = 0; j < LEN; j++)
+        {
+            if (wbuf[j] != rbuf[j])
+            {
+                ecnt++;
+            }
+        }
+    }
+
+    return ecnt;
+}
+
+int main(int argc, char **argv)
+{
+    float soak = 4;
+    const char *conf = "./eim_tune.conf";
+    candidate *cand = NULL;
+    int cnt = 0;
+    int opt = 0;
+    int fd = -1;
+    int ret = -1;
+    int rejected = 0;
+    long blocks = 0;
+    candidate *best = NULL;
+    int saved[SAVED_CNT];
+    struct eim_fpga_limits lim;
+
+    lim.tsu_ps = EIM_FPGA_TSU_PS;
+    lim.th_ps = EIM_FPGA_TH_PS;
+    lim.rd_latency = EIM_FPGA_RD_LATENCY;
+    lim.wr_latency = EIM_FPGA_WR_LATENCY;
+
+    while ((opt = getopt(argc, argv, "s:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            soak = atof(optarg);
+            break;
+        case 'o':
+            conf = optarg;
+            break;
+        default:
+            printf("Wrong arguments.\n");
+            return -1;
+        }
+    }
+    blocks = (long)(soak * 1024 * 1024 / LEN);
+    blocks = blocks < 1 ? 1 : blocks;
+
+    // candidates ordered by the timing model
+    cand = (candidate *)malloc(sizeof(candidate) * MAX_CANDIDATES);
+    if (NULL == cand)
+    {
+        printf("malloc failed.\n");
+        return -1;
+    }
+    for (int bcd = 0; bcd < 4; bcd++)
+    for (int bl = 0; bl < 4; bl++)
+    for (int rwsc = 1; rwsc < 8; rwsc++)
+    for (int wwsc = 1; wwsc < 8; wwsc++)
+    {
+        struct eim_timing_burst b;
+        candidate *c = &cand[cnt];
+        memset(&c->f, 0, sizeof(c->f));
+        c->f.DSZ = 1;
+        c->f.BCS = 1;
+        c->f.CSREC = 1;
+        c->f.MUM = EIM_MUX;
+        c->f.SRD = 1;
+        c->f.SWR = 1;
+        c->f.BCD = bcd;
+        c->f.BL = bl;
+        c->f.RWSC = rwsc;
+        c->f.WWSC = wwsc;
+        if (eim_timing_check(&c->f, &lim))
+        {
+            rejected++;
+            continue;
+        }
+        eim_timing_predict(&c->f, &b);
+        // normalise to the time of one byte so burst lengths compare
+        c->ps = (b.rd_ps > b.wr_ps ? b.rd_ps : b.wr_ps) / b.bytes;
+        cnt++;
+    }
+    qsort(cand, cnt, sizeof(candidate), compare_candidate);
+
+    // loopback runs with the parameter download profile
+    save_attrs(saved);
+    if (write_attr("dmode", DOWNLOAD_PARAMETERS) || write_attr("MUM", EIM_MUX))
+    {
+        goto restore;
+    }
+
+    fd = open("/dev/eim1", O_RDWR);
+    if (fd < 0)
+    {
+        printf("open /dev/eim1 failed.\n");
+        goto restore;
+    }
+
+    printf("------------------------------------\n");
+    printf("EIM auto-tune : %d settings (%d rejected by FPGA limits), %.2f MB soak each.\n", cnt, rejected, soak);
+    printf("------------------------------------\n");
+    for (int i = 0; i < cnt; i++)
+    {
+        candidate *c = &cand[i];
+        long ecnt = 0;
+
+        write_attr("BCD", c->f.BCD);
+        write_attr("BL", c->f.BL);
+        write_attr("RWSC", c->f.RWSC);
+        write_attr("WWSC", c->f.WWSC);
+        if (read_attr("BCD") != c->f.BCD || read_attr("BL") != c->f.BL ||
+            read_attr("RWSC") != c->f.RWSC || read_attr("WWSC") != c->f.WWSC)
+        {
+            printf("setting BCD %d BL %d RWSC %d WWSC %d was not applied.\n",
+                    c->f.BCD, c->f.BL, c->f.RWSC, c->f.WWSC);
+            continue;
+        }
+
+        ecnt = loopback(fd, blocks, i + 1);
+        printf("BCD %d BL %d RWSC %d WWSC %d : %s\n", c->f.BCD, c->f.BL, c->f.RWSC, c->f.WWSC,
+                ecnt ? "errors" : "passed");
+        if (0 == ecnt)
+        {
+            best = c;
+            break;
+        }
+    }
+
+    if (NULL == best)
+    {
+        printf("EIM auto-tune failed : no setting passed.\n");
+        goto restore;
+    }
+
+    // persist for the next module load
+    FILE *fp = fopen(conf, "w");
+    if (NULL == fp)
+    {
+        printf("fopen %s failed.\n", conf);
+        goto restore;
+    }
+    fprintf(fp, "bcd=%d bl=%d rwsc=%d wwsc=%d\n", best->f.BCD, best->f.BL, best->f.RWSC, best->f.WWSC);
+    fclose(fp);
+
+    printf("------------------------------------\n");
+    printf("Best : BCD %d BL %d RWSC %d WWSC %d, saved to %s.\n",
+            best->f.BCD, best->f.BL, best->f.RWSC, best->f.WWSC, conf);
+    printf("------------------------------------\n");
+    ret = 0;
+
+restore:
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    restore_attrs(saved);
+    free(cand);
+    return ret;
+}
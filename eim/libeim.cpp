@@ -25,6 +25,11 @@ eim::eim()
     m_para_wbuf = NULL;
     m_data_rbuf = NULL;
     m_data_rbuf16 = NULL;
+    m_queue_cnt = 0;
+    memset(&m_queue_stats, 0, sizeof(m_queue_stats));
+    m_window = NULL;
+    m_window_len = 0;
+    m_copy_align = EIM_COPY_BLOCK;
 }
 
 // ------------------------------------------------------------
@@ -44,29 +49,77 @@ eim::~eim()
     free(m_data_rbuf);
     free(m_data_rbuf16);
 
+    // unmap window
+    if (NULL != m_window)
+    {
+        munmap(m_window, m_window_len);
+    }
+
     // close file
     close(m_eim_fd);
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This functions completes private members initilization.
+// 	   This functions completes private members initilization
+//     on the default chip select ('/dev/eim1').
 // Parameters :
 //     paralength - the number of parameters to be downloaded.
 //     datalength - the number of data to be uploaded.
 // Return Value :
 //     0 - eim_init success.
 // Errors :
-//     None.
+//     -1 - open device failed.
 // ------------------------------------------------------------
 int eim::eim_init(int paralength, int datalength)
 {
-    sprintf(m_device_addr, "%s", "/dev/eim");
+    return eim_init(paralength, datalength, EIM_DEFAULT_CS);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This functions completes private members initilization
+//     on one chip select ('/dev/eim<cs>').
+// Parameters :
+//     paralength - the number of parameters to be downloaded.
+//     datalength - the number of data to be uploaded.
+//     cs - chip select (0 - 3)
+// Return Value :
+//     0 - eim_init success.
+// Errors :
+//     -1 - open device failed.
+// ------------------------------------------------------------
+int eim::eim_init(int paralength, int datalength, int cs)
+{
+    char device[20] = {0};
+    sprintf(device, "/dev/eim%d", cs);
+
+    return eim_init(paralength, datalength, device);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This functions completes private members initilization.
+// Parameters :
+//     paralength - the number of parameters to be downloaded.
+//     datalength - the number of data to be uploaded.
+//     device - device path, its attributes are in '/sys/class/eim/<name>'
+// Return Value :
+//     0 - eim_init success.
+// Errors :
+//     -1 - open device failed.
+// ------------------------------------------------------------
+int eim::eim_init(int paralength, int datalength, const char *device)
+{
+    const char *name = strrchr(device, '/');
+    name = (NULL == name) ? device : name + 1;
+
+    snprintf(m_device_addr, sizeof(m_device_addr), "%s", device);
     sprintf(m_fpgafile_addr, "%s", "./fpga_ram.rbf");
-    sprintf(m_devattr_dmode_addr, "%s", "/sys/class/eim/eim/dmode");
-    sprintf(m_devattr_MUM_addr, "%s", "/sys/class/eim/eim/MUM");
-    sprintf(m_devattr_BCD_addr, "%s", "/sys/class/eim/eim/BCD");
-    sprintf(m_devattr_WWSC_addr, "%s", "/sys/class/eim/eim/WWSC");
+    snprintf(m_devattr_dmode_addr, sizeof(m_devattr_dmode_addr), "/sys/class/eim/%s/dmode", name);
+    snprintf(m_devattr_MUM_addr, sizeof(m_devattr_MUM_addr), "/sys/class/eim/%s/MUM", name);
+    snprintf(m_devattr_BCD_addr, sizeof(m_devattr_BCD_addr), "/sys/class/eim/%s/BCD", name);
+    snprintf(m_devattr_WWSC_addr, sizeof(m_devattr_WWSC_addr), "/sys/class/eim/%s/WWSC", name);
 
     // open file 
     m_eim_fd = open(m_device_addr, O_RDWR);  
@@ -86,6 +139,8 @@ int eim::eim_init(int paralength, int datalength)
     m_MUM = eim_get_mum();
     m_BCD = eim_get_bcd();
     m_WWSC = eim_get_wwsc();
+
+    return 0;
 }
 
 // ------------------------------------------------------------
@@ -101,20 +156,12 @@ int eim::eim_init(int paralength, int datalength)
 int eim::eim_write(void)
 { 
     // check dmode / MUM / WWSC
-    if (EIM_DOWNLOAD_PARAMETERS != m_dmode)
+    if ((EIM_DOWNLOAD_PARAMETERS != m_dmode) || (EIM_MUX != m_MUM) || (EIM_WWSC_5CLKs != m_WWSC))
     {
-        eim_set_dmode(EIM_DOWNLOAD_PARAMETERS);
-		m_dmode = EIM_DOWNLOAD_PARAMETERS;
-    }
-    if (EIM_MUX != m_MUM)
-    {
-        eim_set_mum(EIM_MUX);
-		m_MUM = EIM_MUX;
-    }
-    if (EIM_WWSC_5CLKs != m_WWSC)
-    {
-        eim_set_wwsc(EIM_WWSC_5CLKs);
-		m_WWSC = EIM_WWSC_5CLKs;
+        if (eim_set_profile(EIM_PROFILE_PARAMETERS))
+        {
+            return -1;
+        }
     }
 
     // download front-end parameters
@@ -153,20 +200,12 @@ int eim::eim_write16(void)
     fclose(fp);
     
     // check dmode / MUM / WWSC
-    if (EIM_DOWNLOAD_PROGRAM != m_dmode)
-    {
-        eim_set_dmode(EIM_DOWNLOAD_PROGRAM);
-		m_dmode = EIM_DOWNLOAD_PROGRAM;
-    }
-    if (EIM_NOMUX != m_MUM)
+    if ((EIM_DOWNLOAD_PROGRAM != m_dmode) || (EIM_NOMUX != m_MUM) || (EIM_WWSC_4CLKs != m_WWSC))
     {
-        eim_set_mum(EIM_NOMUX);
-		m_MUM = EIM_NOMUX;
-    }
-    if (EIM_WWSC_4CLKs != m_WWSC)
-    {
-        eim_set_wwsc(EIM_WWSC_4CLKs);
-		m_WWSC = EIM_WWSC_4CLKs;
+        if (eim_set_profile(EIM_PROFILE_PROGRAM))
+        {
+            return -1;
+        }
     }
 
     // convert 8-bit to 16-bit
@@ -237,6 +276,121 @@ int eim::eim_read16(unsigned char *buf)
     return 0;
 }
 
+// ------------------------------------------------------------
+// Description :
+// 	   This function switches the CS to a 32-bit multiplexed port with one
+//     ioctl and keeps the configuration it had.
+// Parameters :
+//     saved - the configuration before the switch
+// Return Value :
+//     0 - eim_port32_enter success.
+// Errors :
+//     -1 - ioctl failed.
+// ------------------------------------------------------------
+int eim::eim_port32_enter(struct eim_cs_config *saved)
+{
+    struct eim_cs_config cfg;
+
+    if (eim_get_config(saved))
+    {
+        return -1;
+    }
+    cfg = *saved;
+    cfg.MUM = EIM_MUX;
+    cfg.DSZ = 3;
+
+    return eim_set_config(&cfg);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function restores the port width and MUM saved by
+//     eim_port32_enter.
+// Parameters :
+//     saved - the configuration before the switch
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+void eim::eim_port32_leave(const struct eim_cs_config *saved)
+{
+    eim_set_config(saved);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes 32-bit words to FPGA through a 32-bit port,
+//     the port width and MUM are restored afterwards.
+// Parameters :
+//     buf - the words to be downloaded
+//     words - the number of words
+// Return Value :
+//     0 - eim_write32 success.
+// Errors :
+//     -1 - port width can not be set or write failed.
+// ------------------------------------------------------------
+int eim::eim_write32(const unsigned int *buf, int words)
+{
+    struct eim_cs_config saved;
+
+    // check dmode, MUM / port width follow for this write only
+    if (EIM_DOWNLOAD_PARAMETERS != m_dmode)
+    {
+        eim_set_dmode(EIM_DOWNLOAD_PARAMETERS);
+		m_dmode = EIM_DOWNLOAD_PARAMETERS;
+    }
+    if (eim_port32_enter(&saved))
+    {
+        return -1;
+    }
+
+    // download words
+    int wcnt = 0;
+    wcnt = write(m_eim_fd, (const void *)buf, words * 4);
+    eim_port32_leave(&saved);
+    if (wcnt != (words * 4))
+    {
+        cout<<"< libeim.cpp > eim_write32 : write failed."<<endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function reads 32-bit words from FPGA through a 32-bit port,
+//     the port width and MUM are restored afterwards.
+// Parameters :
+//     buf - the address storing the read-back words
+//     words - the number of words
+// Return Value :
+//     0 - eim_read32 success.
+// Errors :
+//     -1 - port width can not be set or read failed.
+// ------------------------------------------------------------
+int eim::eim_read32(unsigned int *buf, int words)
+{
+    struct eim_cs_config saved;
+
+    if (eim_port32_enter(&saved))
+    {
+        return -1;
+    }
+
+    int rcnt = 0;
+    rcnt = read(m_eim_fd, (void *)buf, words * 4);
+    eim_port32_leave(&saved);
+    if (rcnt != (words * 4))
+    {
+        cout<<"< libeim.cpp > eim_read32 : read failed."<<endl;
+        return -1;
+    }
+
+    return 0;
+}
+
 // ------------------------------------------------------------
 // Description :
 // 	   This function sets fpga length and initiates fpga write buffer.
@@ -592,3 +746,555 @@ int eim::eim_get_wwsc(void)
 
     return rwwsc;
 }
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function sets every CS timing field by ioctl.
+// Parameters :
+//     cfg - CS timing configuration (see eim_ioctl.h for ranges)
+// Return Value :
+//     0 - eim_set_config success.
+// Errors :
+//     -1 - a field is out of range or ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_set_config(const struct eim_cs_config *cfg)
+{
+    if (ioctl(m_eim_fd, EIM_IOC_SET_CONFIG, cfg) < 0)
+    {
+        cout<<"< libeim.cpp > eim_set_config : ioctl failed."<<endl;
+        return -1;
+    }
+
+    // keep cached device attributes in step
+    m_MUM = cfg->MUM;
+    m_BCD = cfg->BCD;
+    m_WWSC = cfg->WWSC;
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets every CS timing field by ioctl.
+// Parameters :
+//     cfg - CS timing configuration
+// Return Value :
+//     0 - eim_get_config success.
+// Errors :
+//     -1 - ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_get_config(struct eim_cs_config *cfg)
+{
+    if (ioctl(m_eim_fd, EIM_IOC_GET_CONFIG, cfg) < 0)
+    {
+        cout<<"< libeim.cpp > eim_get_config : ioctl failed."<<endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function sets the port width by ioctl.
+// Parameters :
+//     width - EIM_PORT_8BIT / EIM_PORT_16BIT / EIM_PORT_32BIT
+// Return Value :
+//     0 - eim_set_port_width success.
+// Errors :
+//     -1 - invalid width or ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_set_port_width(int width)
+{
+    struct eim_cs_config cfg;
+
+    if (eim_get_config(&cfg))
+    {
+        return -1;
+    }
+
+    if (EIM_PORT_8BIT == width)
+    {
+        cfg.DSZ = 4;
+    }
+    else if (EIM_PORT_16BIT == width)
+    {
+        cfg.DSZ = 1;
+    }
+    else if (EIM_PORT_32BIT == width)
+    {
+        cfg.DSZ = 3;
+    }
+    else
+    {
+        cout<<"< libeim.cpp > eim_set_port_width : invalid width "<<width<<"."<<endl;
+        return -1;
+    }
+
+    return eim_set_config(&cfg);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the port width by ioctl.
+// Parameters :
+//     None.
+// Return Value :
+//     8 / 16 / 32 - bits per bus word
+// Errors :
+//     -1 - ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_get_port_width(void)
+{
+    struct eim_cs_config cfg;
+
+    if (eim_get_config(&cfg))
+    {
+        return -1;
+    }
+
+    if (3 == cfg.DSZ)
+    {
+        return EIM_PORT_32BIT;
+    }
+    if (cfg.DSZ >= 4)
+    {
+        return EIM_PORT_8BIT;
+    }
+    return EIM_PORT_16BIT;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function switches dmode / MUM / WWSC with one ioctl.
+// Parameters :
+//     profile - EIM_PROFILE_PARAMETERS or EIM_PROFILE_PROGRAM
+// Return Value :
+//     0 - eim_set_profile success.
+// Errors :
+//     -1 - ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_set_profile(int profile)
+{
+    if (ioctl(m_eim_fd, EIM_IOC_SET_PROFILE, profile) < 0)
+    {
+        cout<<"< libeim.cpp > eim_set_profile : ioctl failed."<<endl;
+        return -1;
+    }
+
+    // keep cached device attributes in step
+    if (EIM_PROFILE_PARAMETERS == profile)
+    {
+        m_dmode = EIM_DOWNLOAD_PARAMETERS;
+        m_MUM = EIM_MUX;
+        m_WWSC = EIM_WWSC_5CLKs;
+    }
+    else
+    {
+        m_dmode = EIM_DOWNLOAD_PROGRAM;
+        m_MUM = EIM_NOMUX;
+        m_WWSC = EIM_WWSC_4CLKs;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the cost of the last profile switch.
+// Parameters :
+//     stats - profile switch statistics
+// Return Value :
+//     0 - eim_get_profile_stats success.
+// Errors :
+//     -1 - ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_get_profile_stats(struct eim_profile_stats *stats)
+{
+    if (ioctl(m_eim_fd, EIM_IOC_GET_PROFILE_STATS, stats) < 0)
+    {
+        cout<<"< libeim.cpp > eim_get_profile_stats : ioctl failed."<<endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function overrides the CPU / SDMA cutoffs measured at load.
+// Parameters :
+//     read_cutoff - smallest read carried by SDMA (0 keeps it, < 0 : CPU only)
+//     write_cutoff - smallest write carried by SDMA (0 keeps it, < 0 : CPU only)
+// Return Value :
+//     0 - eim_set_dma_cutoff success.
+// Errors :
+//     -1 - ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_set_dma_cutoff(int read_cutoff, int write_cutoff)
+{
+    struct eim_cs_config cfg;
+
+    if (eim_get_config(&cfg))
+    {
+        return -1;
+    }
+    cfg.dma_read_cutoff = read_cutoff;
+    cfg.dma_write_cutoff = write_cutoff;
+
+    return eim_set_config(&cfg);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the requests and bytes carried by each copy engine.
+// Parameters :
+//     stats - engine counters
+// Return Value :
+//     0 - eim_get_engine_stats success.
+// Errors :
+//     -1 - ioctl failed.
+// -------------------------------------------------------------
+int eim::eim_get_engine_stats(struct eim_engine_stats *stats)
+{
+    if (ioctl(m_eim_fd, EIM_IOC_GET_ENGINE_STATS, stats) < 0)
+    {
+        cout<<"< libeim.cpp > eim_get_engine_stats : ioctl failed."<<endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the profile the cached device attributes match.
+// Parameters :
+//     None.
+// Return Value :
+//     EIM_PROFILE_PARAMETERS / EIM_PROFILE_PROGRAM
+// Errors :
+//     -1 - the attributes match no profile.
+// -------------------------------------------------------------
+int eim::eim_cur_profile(void)
+{
+    if ((EIM_DOWNLOAD_PARAMETERS == m_dmode) && (EIM_MUX == m_MUM) && (EIM_WWSC_5CLKs == m_WWSC))
+    {
+        return EIM_PROFILE_PARAMETERS;
+    }
+    if ((EIM_DOWNLOAD_PROGRAM == m_dmode) && (EIM_NOMUX == m_MUM) && (EIM_WWSC_4CLKs == m_WWSC))
+    {
+        return EIM_PROFILE_PROGRAM;
+    }
+
+    return -1;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function appends one operation, a full queue is flushed first.
+// Parameters :
+//     type - EIM_OP_WRITE / EIM_OP_READ / EIM_OP_FENCE
+//     profile - the profile the operation needs
+//     wbuf - data to be downloaded
+//     rbuf - the address storing the read-back data
+//     len - bytes
+// Return Value :
+//     0 - eim_queue_add success.
+// Errors :
+//     -1 - invalid operation or flush failed.
+// -------------------------------------------------------------
+int eim::eim_queue_add(int type, int profile, const void *wbuf, void *rbuf, int len)
+{
+    if ((EIM_OP_FENCE != type) && ((profile < 0) || (profile >= EIM_PROFILE_CNT) || (len <= 0)))
+    {
+        cout<<"< libeim.cpp > eim_queue_add : invalid operation."<<endl;
+        return -1;
+    }
+
+    if (EIM_QUEUE_LEN == m_queue_cnt)
+    {
+        if (eim_queue_flush())
+        {
+            return -1;
+        }
+    }
+
+    struct eim_op *op = &m_queue[m_queue_cnt++];
+    op->type = type;
+    op->profile = profile;
+    op->wbuf = (const unsigned char *)wbuf;
+    op->rbuf = (unsigned char *)rbuf;
+    op->len = len;
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function queues a write in one profile.
+// Parameters :
+//     profile - EIM_PROFILE_PARAMETERS or EIM_PROFILE_PROGRAM
+//     buf - data to be downloaded (kept until the flush)
+//     len - bytes
+// Return Value :
+//     0 - eim_queue_write success.
+// Errors :
+//     -1 - invalid operation or flush failed.
+// -------------------------------------------------------------
+int eim::eim_queue_write(int profile, const void *buf, int len)
+{
+    return eim_queue_add(EIM_OP_WRITE, profile, buf, NULL, len);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function queues a read in one profile.
+// Parameters :
+//     profile - EIM_PROFILE_PARAMETERS or EIM_PROFILE_PROGRAM
+//     buf - the address storing the read-back data (filled by the flush)
+//     len - bytes
+// Return Value :
+//     0 - eim_queue_read success.
+// Errors :
+//     -1 - invalid operation or flush failed.
+// -------------------------------------------------------------
+int eim::eim_queue_read(int profile, void *buf, int len)
+{
+    return eim_queue_add(EIM_OP_READ, profile, NULL, buf, len);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function queues a fence, operations queued before it run
+//     before any operation queued after it.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_queue_fence success.
+// Errors :
+//     -1 - flush failed.
+// -------------------------------------------------------------
+int eim::eim_queue_fence(void)
+{
+    return eim_queue_add(EIM_OP_FENCE, 0, NULL, NULL, 0);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function runs the operations between two fences. The current
+//     profile goes first, then the others, operations of one profile keep
+//     their submission order.
+// Parameters :
+//     start - the first operation
+//     end - one past the last operation
+// Return Value :
+//     0 - eim_queue_segment success.
+// Errors :
+//     -1 - profile switch, write or read failed.
+// -------------------------------------------------------------
+int eim::eim_queue_segment(int start, int end)
+{
+    int first = eim_cur_profile();
+
+    if (start == end)
+    {
+        return 0;
+    }
+    if (first < 0)
+    {
+        first = m_queue[start].profile;
+    }
+
+    for (int k = 0; k < EIM_PROFILE_CNT; k++)
+    {
+        int profile = (first + k) % EIM_PROFILE_CNT;
+        for (int i = start; i < end; i++)
+        {
+            struct eim_op *op = &m_queue[i];
+            int cnt = 0;
+
+            if (profile != op->profile)
+            {
+                continue;
+            }
+            if (profile != eim_cur_profile())
+            {
+                if (eim_set_profile(profile))
+                {
+                    return -1;
+                }
+                m_queue_stats.transitions++;
+            }
+
+            if (EIM_OP_WRITE == op->type)
+            {
+                cnt = write(m_eim_fd, (const void *)op->wbuf, op->len);
+            }
+            else
+            {
+                cnt = read(m_eim_fd, (void *)op->rbuf, op->len);
+            }
+            if (cnt != op->len)
+            {
+                cout<<"< libeim.cpp > eim_queue_segment : "<<(EIM_OP_WRITE == op->type ? "write" : "read")<<" failed."<<endl;
+                return -1;
+            }
+            m_queue_stats.ops++;
+        }
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function runs every queued operation, one fence segment
+//     after the other.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_queue_flush success.
+// Errors :
+//     -1 - an operation failed, the rest of the queue is dropped.
+// -------------------------------------------------------------
+int eim::eim_queue_flush(void)
+{
+    int cnt = m_queue_cnt;
+    int start = 0;
+    int ret = 0;
+
+    if (0 == cnt)
+    {
+        return 0;
+    }
+    m_queue_cnt = 0;
+    m_queue_stats.flushes++;
+
+    // switches the submission order would have needed
+    int profile = eim_cur_profile();
+    for (int i = 0; i < cnt; i++)
+    {
+        if ((EIM_OP_FENCE != m_queue[i].type) && (profile != m_queue[i].profile))
+        {
+            profile = m_queue[i].profile;
+            m_queue_stats.unsorted++;
+        }
+    }
+
+    for (int i = 0; i <= cnt && 0 == ret; i++)
+    {
+        if ((i == cnt) || (EIM_OP_FENCE == m_queue[i].type))
+        {
+            ret = eim_queue_segment(start, i);
+            start = i + 1;
+        }
+    }
+
+    return ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the queue statistics.
+// Parameters :
+//     stats - queue statistics
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+void eim::eim_get_queue_stats(struct eim_queue_stats *stats)
+{
+    *stats = m_queue_stats;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function maps the CS window and gets the alignment of its copies
+//     from the current BL / PSZ / DSZ fields.
+// Parameters :
+//     len - bytes to be mapped (no more than the CS window)
+// Return Value :
+//     0 - eim_map_window success.
+// Errors :
+//     -1 - ioctl or mmap failed.
+// -------------------------------------------------------------
+int eim::eim_map_window(int len)
+{
+    struct eim_cs_config cfg;
+    void *window = NULL;
+
+    if (eim_get_config(&cfg))
+    {
+        return -1;
+    }
+
+    if (NULL != m_window)
+    {
+        munmap(m_window, m_window_len);
+        m_window = NULL;
+    }
+
+    window = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, m_eim_fd, 0);
+    if (MAP_FAILED == window)
+    {
+        cout<<"< libeim.cpp > eim_map_window : mmap failed."<<endl;
+        return -1;
+    }
+    m_window = (unsigned char *)window;
+    m_window_len = len;
+    m_copy_align = eim_copy_align(cfg.BL, cfg.PSZ, cfg.APR, eim_timing_port_bytes(cfg.DSZ));
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes data through the mapped CS window.
+// Parameters :
+//     buf - data to be downloaded
+//     len - bytes (even, the window takes halfwords only)
+//     offset - byte offset in the window (even)
+// Return Value :
+//     0 - eim_write_mmap success.
+// Errors :
+//     -1 - the window is not mapped or too small, odd offset or length.
+// -------------------------------------------------------------
+int eim::eim_write_mmap(const void *buf, int len, int offset)
+{
+    if ((NULL == m_window) || ((offset | len) & 1) || (offset + len > m_window_len))
+    {
+        cout<<"< libeim.cpp > eim_write_mmap : invalid window range."<<endl;
+        return -1;
+    }
+
+    eim_copy_toio16(m_window + offset, buf, len, m_copy_align);
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function reads data through the mapped CS window.
+// Parameters :
+//     buf - the address storing the read-back data
+//     len - bytes
+//     offset - byte offset in the window (even)
+// Return Value :
+//     0 - eim_read_mmap success.
+// Errors :
+//     -1 - the window is not mapped or too small.
+// -------------------------------------------------------------
+int eim::eim_read_mmap(void *buf, int len, int offset)
+{
+    if ((NULL == m_window) || (offset & 1) || (offset + len > m_window_len))
+    {
+        cout<<"< libeim.cpp > eim_read_mmap : invalid window range."<<endl;
+        return -1;
+    }
+
+    eim_copy_fromio16(buf, m_window + offset, len, m_copy_align);
+
+    return 0;
+}
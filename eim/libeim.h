@@ -7,9 +7,17 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/mman.h>
+
+#include "eim_ioctl.h"
+#include "eim_timing.h"
+#include "eim_copy.h"
 
 using namespace std;
 
+// default chip select ('/dev/eim1')
+#define EIM_DEFAULT_CS          (1)
+
 // FPGA file length
 #define FPGA_FILE_LENGTH        (4928127)
 
@@ -31,6 +39,11 @@ using namespace std;
 #define EIM_WWSC_4CLKs          (0)
 #define EIM_WWSC_5CLKs          (1)          
 
+// port width - bits per bus word
+#define EIM_PORT_8BIT           (8)
+#define EIM_PORT_16BIT          (16)
+#define EIM_PORT_32BIT          (32)
+
 // conversion type
 #define EIM_W_TYPE              (0)
 #define EIM_R_TYPE              (1)
@@ -39,14 +52,41 @@ using namespace std;
 #define EIM_BIG_ENDIAN          (0)
 #define EIM_LITTLE_ENDIAN       (1)
 
+// queued operations (eim_queue_*)
+#define EIM_QUEUE_LEN           (64)
+#define EIM_OP_WRITE            (0)
+#define EIM_OP_READ             (1)
+#define EIM_OP_FENCE            (2)
+
+// queued operation, buffers must stay valid until eim_queue_flush returns
+struct eim_op
+{
+    int type;                   // EIM_OP_WRITE / EIM_OP_READ / EIM_OP_FENCE
+    int profile;                // EIM_PROFILE_PARAMETERS / EIM_PROFILE_PROGRAM
+    const unsigned char *wbuf;  // data to be downloaded
+    unsigned char *rbuf;        // the address storing the read-back data
+    int len;                    // bytes
+};
+
+// queue statistics
+struct eim_queue_stats
+{
+    unsigned int ops;           // operations run
+    unsigned int flushes;       // eim_queue_flush calls with work queued
+    unsigned int transitions;   // profile switches issued
+    unsigned int unsorted;      // profile switches in submission order
+};
+
 class eim
 {
 public:
     eim();
     ~eim();
 
-    // eim initialization
+    // eim initialization ('/dev/eim1', '/dev/eim<cs>' or a device path)
     int eim_init(int paralength, int datalength);
+    int eim_init(int paralength, int datalength, int cs);
+    int eim_init(int paralength, int datalength, const char *device);
 
     // download 8-bit data (front-end parameters)
     int eim_write(void);
@@ -60,6 +100,10 @@ public:
     // upload 16-bit data
     int eim_read16(unsigned char *buf);
 
+    // download & upload 32-bit words (32-bit multiplexed port, restored afterwards)
+    int eim_write32(const unsigned int *buf, int words);
+    int eim_read32(unsigned int *buf, int words);
+
     // set & get fpgalength
     void eim_set_fpgalength(int length);
     int eim_get_fpgalength(void);
@@ -88,6 +132,35 @@ public:
     void eim_set_wwsc(int wwsc);
     int eim_get_wwsc(void);
 
+    // set & get the whole CS timing configuration
+    int eim_set_config(const struct eim_cs_config *cfg);
+    int eim_get_config(struct eim_cs_config *cfg);
+
+    // switch to a mode profile (EIM_PROFILE_PARAMETERS / EIM_PROFILE_PROGRAM)
+    int eim_set_profile(int profile);
+    int eim_get_profile_stats(struct eim_profile_stats *stats);
+
+    // CPU / SDMA cutoffs in bytes (0 keeps one, < 0 : CPU copies only) and engine counters
+    int eim_set_dma_cutoff(int read_cutoff, int write_cutoff);
+    int eim_get_engine_stats(struct eim_engine_stats *stats);
+
+    // set & get port width (EIM_PORT_8BIT / 16BIT / 32BIT)
+    int eim_set_port_width(int width);
+    int eim_get_port_width(void);
+
+    // map the CS window and copy through it with halfword, burst aligned accesses
+    int eim_map_window(int len);
+    int eim_write_mmap(const void *buf, int len, int offset);
+    int eim_read_mmap(void *buf, int len, int offset);
+
+    // queue operations tagged with the profile they need, flush them
+    // grouped by profile, operations never move across a fence
+    int eim_queue_write(int profile, const void *buf, int len);
+    int eim_queue_read(int profile, void *buf, int len);
+    int eim_queue_fence(void);
+    int eim_queue_flush(void);
+    void eim_get_queue_stats(struct eim_queue_stats *stats);
+
 private:
     // eim device file descriptor
     int m_eim_fd;
@@ -122,20 +195,39 @@ private:
     // 16-bit data to be uploaded
     unsigned char *m_data_rbuf16;
 
+    // mapped CS window and the alignment of its copies
+    unsigned char *m_window;
+    int m_window_len;
+    size_t m_copy_align;
+
     // device address
-    char m_device_addr[20];
+    char m_device_addr[64];
 
     // FPGA program file address
     char m_fpgafile_addr[20];
 
     // device attributes addresses dmode / MUM / BCD / WWSC
-    char m_devattr_dmode_addr[30];
-    char m_devattr_MUM_addr[30];
-    char m_devattr_BCD_addr[30];
-    char m_devattr_WWSC_addr[30];
+    char m_devattr_dmode_addr[96];
+    char m_devattr_MUM_addr[96];
+    char m_devattr_BCD_addr[96];
+    char m_devattr_WWSC_addr[96];
+
+    // queued operations
+    struct eim_op m_queue[EIM_QUEUE_LEN];
+    int m_queue_cnt;
+    struct eim_queue_stats m_queue_stats;
 
     // convert 8-bit data to 16-bit data
     void char2short(int convtype, int endian);
+
+    // queue helpers
+    int eim_queue_add(int type, int profile, const void *wbuf, void *rbuf, int len);
+    int eim_queue_segment(int start, int end);
+    int eim_cur_profile(void);
+
+    // 32-bit multiplexed port of eim_write32 / eim_read32 and back
+    int eim_port32_enter(struct eim_cs_config *saved);
+    void eim_port32_leave(const struct eim_cs_config *saved);
 };
 
 #endif
@@ -2,7 +2,17 @@
 // FUNC : configure FPGA by FPP using GPIO
 // DATE : 2013.08.31 by Young
 // DESP : misc device architecture
+//        DCLK and DATA driven through the GPIO data registers (fast_dclk)
+//        idle -> configuring -> done / error, by FPP_IOC_START / FINISH or open / close
+//        SDMA engine (use_sdma) : register words expanded from the bitstream are
+//        copied to GPIO5_DR / GPIO6_DR in the background
 // HIST : V1.0 fpp driver program @ 2013.08.31 by Young
+//        V1.1 2026.10.19 - register fast path, DATA keeps the other GPIO5 bits
+//        V1.2 2026.10.19 - streaming writes through a bounce buffer, configuration state machine
+//        V1.3 2026.10.19 - SDMA configuration engine (use_sdma)
+//        V1.4 2026.10.19 - read-modify-write of the FPP bits under fpp_reg_lock
+//        V1.5 2026.10.19 - FPP_IOC_GET_ENGINE, a new configuration waits for the SDMA engine
+//        V1.6 2026.10.19 - SDMA read backs order DATA and DCLK, descriptors chained by the callback
     
 #include <linux/fs.h>
 #include <linux/ioport.h>
@@ -10,17 +20,31 @@
 #include <linux/delay.h>
 #include <linux/gpio.h>
 #include <linux/slab.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/sched.h>
+#include <linux/wait.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
 #include <asm/io.h>
+#include <asm/system.h>
 #include <asm/uaccess.h>
+#include <mach/dma.h>
 
 #include <mach/iomux-mx6q.h>
 
+#include "fpp_ioctl.h"
+
 // print debug information
 #define DEBUG 			        (0)
 
 // registers address
 #define GPIO5_BASE              (0x020AC000)
 #define GPIO5_LEN               (0x1C + 0x04)
+#define GPIO6_BASE              (0x020B0000)
+#define GPIO6_LEN               (0x1C + 0x04)
 #define CSI0_DAT8_BASE          (0x020E0648)        
 #define CSI0_DAT8_LEN           (0x04)              
 #define CSI0_DAT9_BASE          (0x020E064C)        
@@ -28,6 +52,22 @@
 
 #define DEVICE_NAME 	        "fpp"
 
+// write() copies the bitstream in pieces of this size
+#define FPP_BOUNCE_LEN          (4096)
+// DCLK edges after CONF_DONE for the FPGA initialization
+#define FPP_INIT_CLOCKS         (2)
+
+// SDMA engine : every byte is five buffer descriptors, DATA to GPIO5_DR, GPIO5_DR
+// read back, DCLK high to GPIO6_DR, GPIO6_DR read back, DCLK low. A read of a
+// register returns after the write before it has reached it, so the read backs
+// order the two banks as the dsb of FPP_FAST_CLOCK does. A descriptor holds at
+// most 341 buffer descriptors
+#define FPP_DMA_BD_PER_BYTE     (5)
+#define FPP_DMA_BYTES           (68)
+#define FPP_DMA_WORDS           (FPP_DMA_BYTES * FPP_DMA_BD_PER_BYTE)
+// write() returns once its piece is staged, the next one waits for it
+#define FPP_DMA_STAGE_LEN       (64 * 1024)
+
 // GPIO defination 
 #define GPIO_FPP_DCLK           IMX_GPIO_NR(6, 31)      
 #define GPIO_FPP_UNUSE          IMX_GPIO_NR(4, 14)      
@@ -45,10 +85,37 @@
 #define READ_nSTATUS()          gpio_get_value(GPIO_FPP_nSTATUS)
 #define READ_CONF_DONE()        gpio_get_value(GPIO_FPP_CONF_DONE)
 
+// DATA[0..7] is GPIO5[20..27], DCLK is GPIO6[31], the other bits belong to other drivers
+#define GPIO_FPP_DATA(n)        IMX_GPIO_NR(5, 20 + (n))
+#define FPP_DATA_SHIFT          (20)
+#define FPP_DATA_MASK           (0xFF << FPP_DATA_SHIFT)
+#define FPP_DCLK_BIT            (1 << 31)
+
 #define GPIO5_DR                (gpio5_base)
-#define GPIO5_GDIR              (gpio5_base + 0x04)
-#define DRIVE_DATA(data)        iowrite32( ((data) << 20), GPIO5_DR)
-#define SET_DATA_OUTPUT()       iowrite32( ((0xFF) << 20), GPIO5_GDIR)
+#define GPIO6_DR                (gpio6_base)
+#define DRIVE_DATA(data)        iowrite32((ioread32(GPIO5_DR) & ~FPP_DATA_MASK) | ((data) << FPP_DATA_SHIFT), GPIO5_DR)
+
+// the data register writes (DRIVE_DATA, fast path) change only the DATA and
+// DCLK bits, each one reads the register back right before it is written
+// (read-modify-write under fpp_reg_lock), the other lines of GPIO5 / GPIO6
+// stay with their drivers
+#define FPP_LINES               (12)
+
+// fast path : interrupts are off for one block of FPP_FAST_BLOCK bytes
+#define FPP_FAST_BLOCK          (64)
+
+// one byte on the rising edge of DCLK, GPIO5 and GPIO6 are separate peripherals
+// so their writes are only ordered by a barrier : DATA before DCLK high, DCLK
+// high before the next DATA (DCLK low may overlap the next DATA, tDH is 0 ns)
+// every register write takes longer than the FPGA's tDSU / tCH / tCL minimums
+#define FPP_FAST_CLOCK(byte)    \
+    do { \
+        __raw_writel((__raw_readl(dr5) & ~FPP_DATA_MASK) | ((u32)(byte) << FPP_DATA_SHIFT), dr5); \
+        dsb(); \
+        __raw_writel(__raw_readl(dr6) | FPP_DCLK_BIT, dr6); \
+        dsb(); \
+        __raw_writel(__raw_readl(dr6) & ~FPP_DCLK_BIT, dr6); \
+    } while (0)
 
 // set CSI0_DAT8 (I2C1_SDA) & CSI_DAT9 (I2C1_SCL) as push-pull mode (not open-drain mode)
 #define CSI0_DAT8_PCR           (csi0_dat8_base)
@@ -80,12 +147,70 @@ static iomux_v3_cfg_t fpp_pads[] = {
 
 // virtual address
 static void __iomem *gpio5_base;
+static void __iomem *gpio6_base;
 static void __iomem *csi0_dat8_base;
 static void __iomem *csi0_dat9_base;
 
 // device open state
 static atomic_t open_state;
 
+// configuration state, fpp_lock covers it and the bounce buffer
+static DEFINE_MUTEX(fpp_lock);
+static int fpp_state = FPP_STATE_IDLE;
+static unsigned int fpp_bytes;
+static unsigned char *fpp_bounce;
+
+// every FPP line (DATA, DCLK, nCONFIG, nSTATUS, CONF_DONE) is held by this
+// driver, fpp_reg_lock serializes the register read-modify-writes
+static int fpp_lines_owned;
+static DEFINE_SPINLOCK(fpp_reg_lock);
+
+// engine of the current / last configuration (FPP_ENGINE_*), latched by fpp_start
+static int fpp_engine = FPP_ENGINE_SLOW;
+
+// DCLK / DATA through the data registers (1) or gpiolib (0), needs fpp_lines_owned
+static int fast_dclk = 1;
+module_param(fast_dclk, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(fast_dclk, "drive DCLK through the GPIO6 data register (0 : gpiolib)");
+
+// configuration engine, latched by the start of a configuration
+// SDMA writes whole register words built from a snapshot of GPIO5_DR / GPIO6_DR
+// (it cannot read-modify-write), so it is only for boards where no other
+// GPIO5 / GPIO6 output changes during a configuration
+static int use_sdma = 0;
+module_param(use_sdma, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(use_sdma, "clock the bitstream by SDMA (0 : CPU), no other GPIO5 / GPIO6 output may change meanwhile");
+
+// SDMA engine, fpp_dma_busy is set while a stage is being clocked and
+// fpp_dma_next runs either in write() or in the completion callback, never both
+// the read backs land in the word after the FPP_DMA_WORDS register words
+static int fpp_dma_active;
+static struct dma_chan *fpp_dma_chan;
+static struct dma_slave_config fpp_dma_config;
+static struct scatterlist fpp_dma_src[FPP_DMA_WORDS];
+static struct scatterlist fpp_dma_dst[FPP_DMA_WORDS];
+static u32 *fpp_dma_words;
+static dma_addr_t fpp_dma_words_phys;
+static unsigned char *fpp_stage;
+static size_t fpp_stage_len;
+static size_t fpp_stage_pos;
+static int fpp_dma_busy;
+static int fpp_dma_err;
+static DECLARE_WAIT_QUEUE_HEAD(fpp_dma_wait);
+
+static void fpp_dma_callback(void *data);
+
+static bool fpp_dma_filter(struct dma_chan *chan, void *param)
+{
+	if (!imx_dma_is_general_purpose(chan))
+	{
+		return false;
+	}
+
+	chan->private = param;
+	return true;
+}
+
 // ------------------------------------------------------------
 // Description :
 // 	   This function completes fpp-related address mapping.
@@ -99,6 +224,7 @@ static atomic_t open_state;
 static int fpp_map(void)
 {
 	int req_gpio5_base = 0;
+	int req_gpio6_base = 0;
     int req_csi0_dat8_base = 0;
     int req_csi0_dat9_base = 0;
 
@@ -115,6 +241,20 @@ static int fpp_map(void)
         printk(KERN_ERR "fpp_map : ioremap GPIO5_BASE failed.\n");
         return -EBUSY;
     }    
+
+    // gpio6_base
+	req_gpio6_base = (int)request_mem_region(GPIO6_BASE, GPIO6_LEN, "GPIO6");
+    if (0 == req_gpio6_base) 
+    {
+        printk(KERN_ERR "fpp_map : request_mem_region GPIO6_BASE failed.\n");
+        return -EBUSY;
+    }  
+	gpio6_base = ioremap(GPIO6_BASE, GPIO6_LEN);
+    if (!gpio6_base) 
+    {
+        printk(KERN_ERR "fpp_map : ioremap GPIO6_BASE failed.\n");
+        return -EBUSY;
+    }    
     
     // csi0_dat8_base
     req_csi0_dat8_base = (int)request_mem_region(CSI0_DAT8_BASE, CSI0_DAT8_LEN, "CSI0_DAT8");
@@ -166,6 +306,13 @@ static void fpp_unmap(void)
         release_mem_region(GPIO5_BASE, GPIO5_LEN);
     }
 
+    // gpio6_base
+    if (gpio6_base)
+    {
+        iounmap(gpio6_base);
+        release_mem_region(GPIO6_BASE, GPIO6_LEN);
+    }
+
     // csi0_dat8_base
     if (csi0_dat8_base)
     {
@@ -181,6 +328,446 @@ static void fpp_unmap(void)
     }
 }
     
+// ------------------------------------------------------------
+// Description :
+// 	   This function drives configuration data through gpiolib, one
+//     DCLK edge per call.
+// Parameters :
+//	   data - configuration data
+//	   count - the number of bytes
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void fpp_send_slow(const unsigned char *data, size_t count)
+{
+    unsigned long flags = 0;
+    size_t i = 0;
+    int n = 0;
+
+    // config_data should be driven on the bus on the rising edge of DCLK
+    for (i = 0; i < count; i++) 
+    {
+        if (fpp_lines_owned)
+        {
+            spin_lock_irqsave(&fpp_reg_lock, flags);
+            DRIVE_DATA(data[i]);
+            spin_unlock_irqrestore(&fpp_reg_lock, flags);
+        }
+        else
+        {
+            for (n = 0; n < 8; n++)
+            {
+                gpio_set_value(GPIO_FPP_DATA(n), (data[i] >> n) & 1);
+            }
+        }
+        DRIVE_DCLK_HIGH(); 
+        DRIVE_DCLK_LOW();
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function drives configuration data by writing the GPIO5 and
+//     GPIO6 data registers directly, read-modify-write of the DATA and
+//     DCLK bits with interrupts off for one block at a time.
+// Parameters :
+//	   data - configuration data
+//	   count - the number of bytes
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void fpp_send_fast(const unsigned char *data, size_t count)
+{
+    void __iomem *dr5 = GPIO5_DR;
+    void __iomem *dr6 = GPIO6_DR;
+    unsigned long flags = 0;
+    size_t i = 0;
+    size_t n = 0;
+
+    while (i < count)
+    {
+        n = min_t(size_t, count - i, FPP_FAST_BLOCK);
+
+        spin_lock_irqsave(&fpp_reg_lock, flags);
+        for (; n >= 4; n -= 4, i += 4)
+        {
+            FPP_FAST_CLOCK(data[i]);
+            FPP_FAST_CLOCK(data[i + 1]);
+            FPP_FAST_CLOCK(data[i + 2]);
+            FPP_FAST_CLOCK(data[i + 3]);
+        }
+        for (; n > 0; n--, i++)
+        {
+            FPP_FAST_CLOCK(data[i]);
+        }
+        spin_unlock_irqrestore(&fpp_reg_lock, flags);
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function clocks one chunk of configuration data.
+// Parameters :
+//	   data - configuration data
+//	   count - the number of bytes
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void fpp_send(const unsigned char *data, size_t count)
+{
+    if (FPP_ENGINE_SLOW != fpp_engine)
+    {
+        fpp_send_fast(data, count);
+    }
+    else
+    {
+        fpp_send_slow(data, count);
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function expands the next part of the staged bitstream into
+//     register words and starts one SDMA descriptor on them, or ends
+//     the stage when it is empty or an error occurred.
+// Parameters :
+//     None.
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void fpp_dma_next(void)
+{
+    struct dma_async_tx_descriptor *desc = NULL;
+    u32 data_base = 0;
+    u32 dclk_low = 0;
+    u32 dclk_high = 0;
+    size_t n = 0;
+    size_t i = 0;
+
+    n = min_t(size_t, fpp_stage_len - fpp_stage_pos, FPP_DMA_BYTES);
+    if ((0 == n) || fpp_dma_err)
+    {
+        fpp_dma_busy = 0;
+        wake_up(&fpp_dma_wait);
+        return;
+    }
+
+    // snapshot of the other bits, see use_sdma
+    data_base = __raw_readl(GPIO5_DR) & ~FPP_DATA_MASK;
+    dclk_low = __raw_readl(GPIO6_DR) & ~FPP_DCLK_BIT;
+    dclk_high = dclk_low | FPP_DCLK_BIT;
+    for (i = 0; i < n; i++)
+    {
+        fpp_dma_words[FPP_DMA_BD_PER_BYTE * i] = data_base | ((u32)fpp_stage[fpp_stage_pos + i] << FPP_DATA_SHIFT);
+        fpp_dma_words[FPP_DMA_BD_PER_BYTE * i + 2] = dclk_high;
+        fpp_dma_words[FPP_DMA_BD_PER_BYTE * i + 4] = dclk_low;
+    }
+    wmb();
+
+    // M2M takes the source list first and then the destination list
+    desc = fpp_dma_chan->device->device_prep_slave_sg(fpp_dma_chan, fpp_dma_src,
+            FPP_DMA_BD_PER_BYTE * n, DMA_MEM_TO_MEM, 1);
+    if (desc)
+    {
+        desc = fpp_dma_chan->device->device_prep_slave_sg(fpp_dma_chan, fpp_dma_dst,
+                FPP_DMA_BD_PER_BYTE * n, DMA_MEM_TO_MEM, 0);
+    }
+    if (!desc)
+    {
+        printk(KERN_ERR "fpp_dma_next : device_prep_slave_sg failed.\n");
+        fpp_dma_err = -EIO;
+        fpp_dma_busy = 0;
+        wake_up(&fpp_dma_wait);
+        return;
+    }
+    desc->callback = fpp_dma_callback;
+    fpp_stage_pos += n;
+
+    dmaengine_submit(desc);
+    fpp_dma_chan->device->device_issue_pending(fpp_dma_chan);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function is the SDMA completion callback, it chains the
+//     next descriptor of the stage from the SDMA tasklet (expanding
+//     and preparing a descriptor does not sleep), so a stage costs no
+//     work item or context switch per descriptor.
+// Parameters :
+//	   data - unused
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void fpp_dma_callback(void *data)
+{
+    fpp_dma_next();
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function requests the SDMA channel and builds the fixed
+//     source (word buffer, GPIO5_DR, word buffer, GPIO6_DR, word buffer, ...)
+//     and destination (GPIO5_DR, read back word, GPIO6_DR, read back word,
+//     GPIO6_DR, ...) lists, the SDMA engine stays off if it fails.
+// Parameters :
+//     None.
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void fpp_dma_init(void)
+{
+    dma_cap_mask_t dma_m2m_mask;
+    struct imx_dma_data m2m_dma_data = {0};
+    int i = 0;
+
+    fpp_stage = kmalloc(FPP_DMA_STAGE_LEN, GFP_KERNEL);
+    fpp_dma_words = dma_alloc_coherent(NULL, (FPP_DMA_WORDS + 1) * sizeof(u32), &fpp_dma_words_phys, GFP_KERNEL);
+    if (!fpp_stage || !fpp_dma_words)
+    {
+        printk(KERN_ERR "fpp_dma_init : buffer allocation failed, SDMA engine off.\n");
+        return;
+    }
+
+    // configuration runs in the background, leave the high priority to latency sensitive users
+    dma_cap_zero(dma_m2m_mask);
+    dma_cap_set(DMA_SLAVE, dma_m2m_mask);
+    m2m_dma_data.peripheral_type = IMX_DMATYPE_MEMORY;
+    m2m_dma_data.priority = DMA_PRIO_MEDIUM;
+    fpp_dma_chan = dma_request_channel(dma_m2m_mask, fpp_dma_filter, &m2m_dma_data);
+    if (!fpp_dma_chan)
+    {
+        printk(KERN_ERR "fpp_dma_init : dma_request_channel failed, SDMA engine off.\n");
+        return;
+    }
+    fpp_dma_config.direction = DMA_MEM_TO_MEM;
+    fpp_dma_config.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+    dmaengine_slave_config(fpp_dma_chan, &fpp_dma_config);
+
+    // one buffer descriptor per register write
+    sg_init_table(fpp_dma_src, FPP_DMA_WORDS);
+    sg_init_table(fpp_dma_dst, FPP_DMA_WORDS);
+    for (i = 0; i < FPP_DMA_WORDS; i++)
+    {
+        switch (i % FPP_DMA_BD_PER_BYTE)
+        {
+            case 0 :
+                sg_dma_address(&fpp_dma_src[i]) = fpp_dma_words_phys + i * sizeof(u32);
+                sg_dma_address(&fpp_dma_dst[i]) = GPIO5_BASE;
+                break;
+            case 1 :
+                sg_dma_address(&fpp_dma_src[i]) = GPIO5_BASE;
+                sg_dma_address(&fpp_dma_dst[i]) = fpp_dma_words_phys + FPP_DMA_WORDS * sizeof(u32);
+                break;
+            case 3 :
+                sg_dma_address(&fpp_dma_src[i]) = GPIO6_BASE;
+                sg_dma_address(&fpp_dma_dst[i]) = fpp_dma_words_phys + FPP_DMA_WORDS * sizeof(u32);
+                break;
+            default :
+                sg_dma_address(&fpp_dma_src[i]) = fpp_dma_words_phys + i * sizeof(u32);
+                sg_dma_address(&fpp_dma_dst[i]) = GPIO6_BASE;
+                break;
+        }
+        sg_dma_len(&fpp_dma_src[i]) = sizeof(u32);
+        sg_dma_len(&fpp_dma_dst[i]) = sizeof(u32);
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function releases the SDMA channel and buffers.
+// Parameters :
+//     None.
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void fpp_dma_exit(void)
+{
+    if (fpp_dma_chan)
+    {
+        dmaengine_terminate_all(fpp_dma_chan);
+        dma_release_channel(fpp_dma_chan);
+        fpp_dma_chan = NULL;
+    }
+    if (fpp_dma_words)
+    {
+        dma_free_coherent(NULL, (FPP_DMA_WORDS + 1) * sizeof(u32), fpp_dma_words, fpp_dma_words_phys);
+    }
+    kfree(fpp_stage);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function stages one piece of the bitstream for the SDMA
+//     engine and returns while it is clocked, called with fpp_lock held.
+// Parameters :
+//	   buf - buffer pointer in user space
+//	   count - the number of bytes, at most FPP_DMA_STAGE_LEN
+//	   nonblock - return -EAGAIN instead of waiting for the previous stage
+// Return Value :
+//     0 - fpp_dma_write success.
+// Errors :
+//     -EAGAIN - the previous stage is still running (nonblock)
+//     -ERESTARTSYS - interrupted while waiting for the previous stage
+//     -EIO - the previous stage failed
+//     -EFAULT - copy_from_user failed
+// -------------------------------------------------------------
+static int fpp_dma_write(const char __user *buf, size_t count, int nonblock)
+{
+    if (nonblock && fpp_dma_busy)
+    {
+        return -EAGAIN;
+    }
+    if (wait_event_interruptible(fpp_dma_wait, !fpp_dma_busy))
+    {
+        return -ERESTARTSYS;
+    }
+    if (fpp_dma_err)
+    {
+        return fpp_dma_err;
+    }
+
+    if (copy_from_user(fpp_stage, buf, count))
+    {
+        printk(KERN_ERR "fpp_dma_write : copy_from_user failed.\n");
+        return -EFAULT;
+    }
+    fpp_stage_len = count;
+    fpp_stage_pos = 0;
+    fpp_dma_busy = 1;
+    fpp_dma_next();
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function pulses nCONFIG and waits for the FPGA to accept
+//     data (idle -> configuring), called with fpp_lock held. A stage
+//     left in flight by a failed configuration is stopped first.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - fpp_start success.
+// Errors :
+//     -EBUSY - a configuration is in progress
+//     -EIO - nSTATUS did not follow nCONFIG
+// -------------------------------------------------------------
+static int fpp_start(void)
+{
+    if (FPP_STATE_CONFIGURING == fpp_state)
+    {
+        return -EBUSY;
+    }
+    // the running descriptor completes and fpp_dma_next stops on the error
+    if (fpp_dma_busy)
+    {
+        fpp_dma_err = -EIO;
+        wait_event(fpp_dma_wait, !fpp_dma_busy);
+    }
+
+    fpp_bytes = 0;
+    fpp_dma_active = use_sdma && fpp_dma_chan && fpp_lines_owned;
+    fpp_dma_err = 0;
+    if (fpp_dma_active)
+    {
+        fpp_engine = FPP_ENGINE_SDMA;
+    }
+    else
+    {
+        fpp_engine = (fast_dclk && fpp_lines_owned) ? FPP_ENGINE_FAST : FPP_ENGINE_SLOW;
+    }
+
+    // put nCONFIG low and then pull it up
+    DRIVE_nCONFIG_LOW();
+    ndelay(500);
+    DRIVE_nCONFIG_HIGH();
+
+    // check nSTATUS if it is desserted or not 
+    if (READ_nSTATUS())
+    {
+        printk(KERN_ERR "fpp_start : nSTATUS is still high.\n");
+        fpp_state = FPP_STATE_ERROR;
+        return -EIO;
+    }    
+    
+    // check nSTATUS if it is asserted or not 
+    udelay(230);
+    if (!READ_nSTATUS())
+    {
+        printk(KERN_ERR "fpp_start : nSTATUS is still low.\n");
+        fpp_state = FPP_STATE_ERROR;
+        return -EIO;
+    }
+    
+    // delay more than 2 us and then configure FPGA
+    udelay(2);
+
+    fpp_state = FPP_STATE_CONFIGURING;
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function checks CONF_DONE at the end of the bitstream
+//     (configuring -> done / error), called with fpp_lock held.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - fpp_finish success.
+// Errors :
+//     -EINVAL - no configuration is in progress
+//     -EIO - CONF_DONE is still low
+// -------------------------------------------------------------
+static int fpp_finish(void)
+{
+    static const unsigned char init_clocks[FPP_INIT_CLOCKS] = {0};
+
+    if (FPP_STATE_CONFIGURING != fpp_state)
+    {
+        return (FPP_STATE_DONE == fpp_state) ? 0 : -EINVAL;
+    }
+
+    // the SDMA engine clocks the last stage in the background
+    if (fpp_dma_active)
+    {
+        wait_event(fpp_dma_wait, !fpp_dma_busy);
+        if (fpp_dma_err)
+        {
+            fpp_state = FPP_STATE_ERROR;
+            return fpp_dma_err;
+        }
+    }
+
+    // check CONF_DONE if it is asserted or not
+    if (!READ_CONF_DONE())
+    {
+        printk(KERN_ERR "fpp_finish : CONF_DONE is still low after %u bytes.\n", fpp_bytes);
+        fpp_state = FPP_STATE_ERROR;
+        return -EIO;
+    }     
+
+    // the FPGA initializes on the DCLK edges following CONF_DONE
+    fpp_send(init_clocks, FPP_INIT_CLOCKS);
+    fpp_state = FPP_STATE_DONE;
+
+    return 0;
+}
+
 // ------------------------------------------------------------
 // Description :
 // 	   This function ensures that fpp device can be only opened once .
@@ -202,6 +789,12 @@ static int fpp_open(struct inode *inode, struct file *filp)
         return -EBUSY;
     }
 
+    // every open starts a new configuration
+    mutex_lock(&fpp_lock);
+    fpp_state = FPP_STATE_IDLE;
+    fpp_bytes = 0;
+    mutex_unlock(&fpp_lock);
+
 #if DEBUG == 1
     printk(KERN_INFO "fpp open.\n");  
 #endif
@@ -211,7 +804,9 @@ static int fpp_open(struct inode *inode, struct file *filp)
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function completes atomic inc of open state.
+// 	   This function finishes a configuration started by FPP_IOC_START
+//     and left in progress (its result is in FPP_IOC_GET_STATE only) and
+//     completes atomic inc of open state.
 // Parameters :
 //     None.
 // Return Value :
@@ -221,6 +816,10 @@ static int fpp_open(struct inode *inode, struct file *filp)
 // -------------------------------------------------------------
 static int fpp_release(struct inode *inode, struct file *filp)  
 {  
+    mutex_lock(&fpp_lock);
+    fpp_finish();
+    mutex_unlock(&fpp_lock);
+
     atomic_inc(&open_state);
 
 #if DEBUG == 1
@@ -232,7 +831,10 @@ static int fpp_release(struct inode *inode, struct file *filp)
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function implements write file operation.
+// 	   This function implements write file operation, it clocks the
+//     next part of the bitstream through the bounce buffer. Without
+//     FPP_IOC_START, write() takes the whole bitstream as before : it
+//     starts the configuration, clocks the data and checks CONF_DONE.
 // Parameters :
 //	   filp - object file
 //	   buf - buffer pointer in user space
@@ -242,72 +844,101 @@ static int fpp_release(struct inode *inode, struct file *filp)
 //     positive value - the actual number of data copied
 //	   negative value - fpp_write error
 // Errors :
-//     None.
+//     -EINVAL - the configuration is done already, or O_NONBLOCK without
+//               FPP_IOC_START
+//     -EIO - the FPGA did not start or reported an error (nSTATUS low, SDMA,
+//            CONF_DONE low at the end of a write without FPP_IOC_START)
+//     -EAGAIN - the SDMA engine is still busy (O_NONBLOCK)
+//     -ERESTARTSYS - interrupted while waiting for the SDMA engine
+//     -EFAULT - copy_from_user failed
 // -------------------------------------------------------------
 static ssize_t fpp_write(struct file *filp, const char __user *buf, size_t count, loff_t *fpos)  
 {  
-    unsigned char *config_data = NULL;
+    size_t done = 0;
+    size_t n = 0;
+    int implicit = 0;
     int ret = 0;
-    int i = 0;
 
-    config_data = (unsigned char*)kmalloc(sizeof(unsigned char) * count, GFP_KERNEL);
-    if (!config_data)
+    mutex_lock(&fpp_lock);
+    if ((FPP_STATE_IDLE == fpp_state) && (filp->f_flags & O_NONBLOCK))
     {
-        printk(KERN_ERR "fpp_write : kmalloc failed.\n");
-        return -EFAULT;
+        // a write without FPP_IOC_START cannot stop half way and be retried
+        printk(KERN_ERR "fpp_write : O_NONBLOCK needs FPP_IOC_START.\n");
+        ret = -EINVAL;
     }
-
-    ret = copy_from_user(config_data, buf, count);
-    if (ret) 
+    else if (FPP_STATE_IDLE == fpp_state)
     {
-        printk(KERN_ERR "fpp_write : copy_from_user failed.\n");
-        return -EFAULT;
+        ret = fpp_start();
+        implicit = 1;
+    }
+    else if (FPP_STATE_CONFIGURING != fpp_state)
+    {
+        ret = (FPP_STATE_DONE == fpp_state) ? -EINVAL : -EIO;
+    }
+    if (ret)
+    {
+        mutex_unlock(&fpp_lock);
+        return ret;
     }
 
-    // put nCONFIG low and then pull it up
-    DRIVE_nCONFIG_LOW();
-    ndelay(500);
-    DRIVE_nCONFIG_HIGH();
-
-    // check nSTATUS if it is desserted or not 
-    if (READ_nSTATUS())
+    // drive config_data on data bus, one bounce buffer or SDMA stage at a time
+    while (fpp_dma_active && (done < count))
     {
-        printk("fpp_write : nSTATUS is still high.\n");
-        return -EFAULT;
-    }    
-    
-    // check nSTATUS if it is asserted or not 
-    udelay(230);
-    if (!READ_nSTATUS())
+        n = min_t(size_t, count - done, FPP_DMA_STAGE_LEN);
+        ret = fpp_dma_write(buf + done, n, filp->f_flags & O_NONBLOCK);
+        if (-EIO == ret)
+        {
+            fpp_state = FPP_STATE_ERROR;
+        }
+        if (ret)
+        {
+            break;
+        }
+        done += n;
+        fpp_bytes += n;
+    }
+    while (!fpp_dma_active && (done < count))
     {
-        printk("fpp_write : nSTATUS is still low.\n");
-        return -EFAULT;
+        n = min_t(size_t, count - done, FPP_BOUNCE_LEN);
+        if (copy_from_user(fpp_bounce, buf + done, n)) 
+        {
+            printk(KERN_ERR "fpp_write : copy_from_user failed.\n");
+            ret = -EFAULT;
+            break;
+        }
+        fpp_send(fpp_bounce, n);
+        done += n;
+        fpp_bytes += n;
     }
-    
-    // delay more than 2 us and then configure FPGA
-    udelay(2);
-    
-    // drive config_data on data bus
-    // config_data should be driven on the bus on the rising edge of DCLK
-    for (i = 0; i < count; i++) 
+
+    // nSTATUS low during configuration reports a bitstream error
+    if (!READ_nSTATUS())
     {
-        DRIVE_DATA(config_data[i]);
-        DRIVE_DCLK_HIGH(); 
-        DRIVE_DCLK_LOW();
+        printk(KERN_ERR "fpp_write : nSTATUS went low after %u bytes.\n", fpp_bytes);
+        fpp_state = FPP_STATE_ERROR;
+        // stops the SDMA chain after its current descriptor
+        fpp_dma_err = -EIO;
+        ret = -EIO;
     }
 
-    // check CONF_DONE if it is asserted or not
-    if (!READ_CONF_DONE())
+    // a write without FPP_IOC_START is the whole bitstream, CONF_DONE is
+    // its result (the SDMA engine is waited for)
+    if (implicit && (done == count) && !ret)
     {
-        printk("fpp_write : CONF_DONE is still low.\n");
-        return -EFAULT;
-    }     
+        ret = fpp_finish();
+    }
+    mutex_unlock(&fpp_lock);
 
 #if DEBUG == 1
     printk(KERN_INFO "fpp write.\n");  
 #endif
     
-    return count;
+    // a partial write reports what was taken, the error comes with the next call
+    if (implicit && ret)
+    {
+        return ret;
+    }
+    return (done && (-EIO != ret)) ? done : (ret ? ret : count);
 }
 
 // ------------------------------------------------------------
@@ -336,26 +967,50 @@ static ssize_t fpp_read(struct file *filp, char __user *buf, size_t count, loff_
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function implements IO control file operation.
+// 	   This function implements IO control file operation, it starts
+//     and finishes a configuration or returns its state or engine.
 // Parameters :
 //	   filp - object file
-//	   cmd - command 
-//	   arg - arguments of command above
+//	   cmd - FPP_IOC_START / FPP_IOC_FINISH / FPP_IOC_GET_STATE / FPP_IOC_GET_ENGINE
+//	   arg - int in user space (FPP_IOC_GET_STATE / FPP_IOC_GET_ENGINE)
 // Return Value :
 //	   0 - fpp_ioctl success
 // Errors :
-//     None.
+//     -EBUSY / -EINVAL / -EIO - see fpp_start and fpp_finish
+//     -EFAULT - put_user failed
+//     -ENOTTY - unknown command
 // ------------------------------------------------------------
 static long fpp_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)  
 {  
-	// Nothing to do 
-	
+    long ret = 0;
+
 #if DEBUG == 1
     printk(KERN_INFO "fpp IO control.\n");  
     printk(KERN_INFO "cmd:%d, arg:%ld.\n", cmd, arg);  
 #endif
 
-    return 0;  
+    mutex_lock(&fpp_lock);
+    switch (cmd)
+    {
+        case FPP_IOC_START :
+            ret = fpp_start();
+            break;
+        case FPP_IOC_FINISH :
+            ret = fpp_finish();
+            break;
+        case FPP_IOC_GET_STATE :
+            ret = put_user(fpp_state, (int __user *)arg) ? -EFAULT : 0;
+            break;
+        case FPP_IOC_GET_ENGINE :
+            ret = put_user(fpp_engine, (int __user *)arg) ? -EFAULT : 0;
+            break;
+        default :
+            ret = -ENOTTY;
+            break;
+    }
+    mutex_unlock(&fpp_lock);
+
+    return ret;  
 }  
 
 static struct file_operations fpp_fops =   
@@ -378,6 +1033,22 @@ struct miscdevice fpp_dev =
     .nodename   = DEVICE_NAME,
 };
 
+// FPP lines, requested at load
+static const struct gpio fpp_lines[FPP_LINES] = {
+    { GPIO_FPP_DCLK,        GPIOF_OUT_INIT_LOW,     "DCLK" },
+    { GPIO_FPP_nCONFIG,     GPIOF_OUT_INIT_HIGH,    "nCONFIG" },
+    { GPIO_FPP_nSTATUS,     GPIOF_IN,               "nSTATUS" },
+    { GPIO_FPP_CONF_DONE,   GPIOF_IN,               "CONF_DONE" },
+    { GPIO_FPP_DATA(0),     GPIOF_OUT_INIT_LOW,     "DATA0" },
+    { GPIO_FPP_DATA(1),     GPIOF_OUT_INIT_LOW,     "DATA1" },
+    { GPIO_FPP_DATA(2),     GPIOF_OUT_INIT_LOW,     "DATA2" },
+    { GPIO_FPP_DATA(3),     GPIOF_OUT_INIT_LOW,     "DATA3" },
+    { GPIO_FPP_DATA(4),     GPIOF_OUT_INIT_LOW,     "DATA4" },
+    { GPIO_FPP_DATA(5),     GPIOF_OUT_INIT_LOW,     "DATA5" },
+    { GPIO_FPP_DATA(6),     GPIOF_OUT_INIT_LOW,     "DATA6" },
+    { GPIO_FPP_DATA(7),     GPIOF_OUT_INIT_LOW,     "DATA7" },
+};
+
 // ------------------------------------------------------------
 // Description :
 // 	   FPP initialization.
@@ -390,12 +1061,27 @@ struct miscdevice fpp_dev =
 // ------------------------------------------------------------
 static int __init fpp_init(void)  
 {
-    // register misc device
     int ret = 0;
+    int i = 0;
+
+    // bounce buffer of write()
+    fpp_bounce = kmalloc(FPP_BOUNCE_LEN, GFP_KERNEL);
+    if (!fpp_bounce)
+    {
+        printk(KERN_ERR "fpp_init : kmalloc failed.\n");
+        return -ENOMEM;
+    }
+
+    // SDMA engine, the CPU engine is used without it
+    fpp_dma_init();
+
+    // register misc device
     ret = misc_register(&fpp_dev);
     if (ret)
     {
-        goto unregister_fpp;
+        fpp_dma_exit();
+        kfree(fpp_bounce);
+        return ret;
     }
     
     // fpp iomux 
@@ -408,21 +1094,31 @@ static int __init fpp_init(void)
         goto unmap_fpp;
     }
     
-    // gpio init
-    gpio_request(GPIO_FPP_DCLK, "DCLK");
+    // gpio init, the register paths need every FPP line
     gpio_request(GPIO_FPP_UNUSE, "UNUSE");
-    gpio_request(GPIO_FPP_nCONFIG, "nCONFIG");
-    gpio_request(GPIO_FPP_nSTATUS, "nSTATUS");
-    gpio_request(GPIO_FPP_CONF_DONE, "CONF_DONE");
-    gpio_direction_output(GPIO_FPP_DCLK, 0);
     gpio_direction_input(GPIO_FPP_UNUSE);
-    gpio_direction_output(GPIO_FPP_nCONFIG, 1);
-    gpio_direction_input(GPIO_FPP_nSTATUS);
-    gpio_direction_input(GPIO_FPP_CONF_DONE);
+    if (gpio_request_array(fpp_lines, FPP_LINES))
+    {
+        // as before the lines are driven anyway, through gpiolib only
+        printk(KERN_ERR "fpp_init : FPP lines are in use, gpiolib DCLK only.\n");
+        for (i = 0; i < FPP_LINES; i++)
+        {
+            if (fpp_lines[i].flags & GPIOF_DIR_IN)
+            {
+                gpio_direction_input(fpp_lines[i].gpio);
+            }
+            else
+            {
+                gpio_direction_output(fpp_lines[i].gpio, (fpp_lines[i].flags & GPIOF_INIT_HIGH) ? 1 : 0);
+            }
+        }
+    }
+    else
+    {
+        fpp_lines_owned = 1;
+    }
     SET_DAT6_PUSHPULL();
     SET_DAT7_PUSHPULL();
-    SET_DATA_OUTPUT();
-    DRIVE_DATA(0x00);
 
 	// initiate open_state
     atomic_set(&open_state, 1);
@@ -435,9 +1131,9 @@ static int __init fpp_init(void)
 
 unmap_fpp : 
 	fpp_unmap();
-
-unregister_fpp :
     misc_deregister(&fpp_dev);
+    fpp_dma_exit();
+    kfree(fpp_bounce);
     
     return ret;
 }
@@ -455,17 +1151,19 @@ unregister_fpp :
 static void __exit fpp_exit(void)  
 {  
     // gpio release
-    gpio_free(GPIO_FPP_DCLK);
+    if (fpp_lines_owned)
+    {
+        gpio_free_array(fpp_lines, FPP_LINES);
+    }
     gpio_free(GPIO_FPP_UNUSE);
-    gpio_free(GPIO_FPP_nCONFIG);
-    gpio_free(GPIO_FPP_nSTATUS);
-    gpio_free(GPIO_FPP_CONF_DONE);
 
     // fpp address map
     fpp_unmap();
 
     // deregister misc device
     misc_deregister(&fpp_dev);
+    fpp_dma_exit();
+    kfree(fpp_bounce);
     
 #if DEBUG == 1
     printk(KERN_INFO "fpp exit.\n");  
@@ -477,5 +1175,5 @@ module_exit(fpp_exit);
 
 MODULE_AUTHOR("Young");
 MODULE_LICENSE("GPL");  
-MODULE_VERSION("1.0");
+MODULE_VERSION("1.6");
 MODULE_DESCRIPTION("Configure FPGA by FPP using GPIO"); 
@@ -0,0 +1,41 @@
+// NAME : fpp ioctl interface
+// FUNC : ioctl commands shared by fpp.c and fpp_test.c
+// DATE : 2026.10.19
+// HIST : V1.0 2026.10.19 - configuration state machine
+//        V1.1 2026.10.19 - FPP_IOC_GET_ENGINE
+
+#ifndef _FPP_IOCTL_H_
+#define _FPP_IOCTL_H_
+
+#ifdef __KERNEL__
+#include <linux/ioctl.h>
+#else
+#include <sys/ioctl.h>
+#endif
+
+// configuration : FPP_IOC_START pulses nCONFIG (idle -> configuring),
+// write() streams the bitstream in pieces of any size, FPP_IOC_FINISH
+// checks CONF_DONE (configuring -> done / error)
+// without the ioctls one write() is the whole bitstream : it starts, clocks
+// and checks CONF_DONE, and returns -EIO when the configuration failed
+// (O_NONBLOCK needs FPP_IOC_START, such a write() fails with -EINVAL)
+#define FPP_IOC_MAGIC           'F'
+
+#define FPP_IOC_START           _IO(FPP_IOC_MAGIC, 1)
+#define FPP_IOC_FINISH          _IO(FPP_IOC_MAGIC, 2)
+#define FPP_IOC_GET_STATE       _IOR(FPP_IOC_MAGIC, 3, int)
+// engine the current / last configuration was clocked by, chosen by
+// FPP_IOC_START (or the first write()) from fast_dclk, use_sdma and the
+// ownership of the FPP lines
+#define FPP_IOC_GET_ENGINE      _IOR(FPP_IOC_MAGIC, 4, int)
+
+#define FPP_STATE_IDLE          (0)
+#define FPP_STATE_CONFIGURING   (1)
+#define FPP_STATE_DONE          (2)
+#define FPP_STATE_ERROR         (3)
+
+#define FPP_ENGINE_SLOW         (0)     // gpiolib
+#define FPP_ENGINE_FAST         (1)     // GPIO data registers
+#define FPP_ENGINE_SDMA         (2)
+
+#endif
@@ -1,33 +1,205 @@
 // NAME : fpp test program
 // FUNC : FPGA J1-1 40M clock & J1-3 1M clock
 // DATE : 2013.08.31 by Young
+// DESP : configures three times, DCLK through gpiolib, through the GPIO registers
+//        (fast_dclk module parameter) and by SDMA (use_sdma module parameter),
+//        and reports the configuration time, the system-wide CPU time (all
+//        processes, interrupts and the SDMA work items) and the engine the
+//        driver actually used (FPP_IOC_GET_ENGINE) of each
+//        the rbf file is streamed from disk in CHUNK_LEN pieces between
+//        FPP_IOC_START and FPP_IOC_FINISH, an RBZ1 file (full_eim/rbzpack) is
+//        decompressed by a decode thread while the previous block is clocked
+// ./fpp_test                  - FPP_test.rbf
+// ./fpp_test FPP_test.rbz     - compressed bitstream
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/time.h>
 
+#include "fpp_ioctl.h"
+#include "rbz.h"
+
+#define FAST_DCLK_PARAM     "/sys/module/fpp/parameters/fast_dclk"
+#define USE_SDMA_PARAM      "/sys/module/fpp/parameters/use_sdma"
+#define MODE_CNT            (3)
+#define CHUNK_LEN           (64 * 1024)
+
+// write an integer to a module parameter file
+static void write_param(const char *path, int val)
+{
+    char wbuf[12] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return;
+    }
+    snprintf(wbuf, sizeof(wbuf), "%d", val);
+    write(fd, (void *)wbuf, strlen(wbuf));
+    close(fd);
+}
+
+// read an integer from a module parameter file
+static int read_param(const char *path)
+{
+    char rbuf[12] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    read(fd, (void *)rbuf, sizeof(rbuf) - 1);
+    close(fd);
+
+    return atoi(rbuf);
+}
+
+// busy time of all CPUs in microseconds (/proc/stat, everything but idle and
+// iowait), the driver's interrupts and work items are not charged to this process
+static long cpu_time_us(void)
+{
+    unsigned long long t[8] = {0};
+    FILE *fp = NULL;
+    int n = 0;
+
+    fp = fopen("/proc/stat", "r");
+    if (NULL == fp)
+    {
+        return 0;
+    }
+    n = fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+            &t[0], &t[1], &t[2], &t[3], &t[4], &t[5], &t[6], &t[7]);
+    fclose(fp);
+    if (n < 4)
+    {
+        return 0;
+    }
+
+    return (long)((t[0] + t[1] + t[2] + t[5] + t[6] + t[7]) * 1000000 / sysconf(_SC_CLK_TCK));
+}
+
+// one configuration streamed from the file, returns the time in microseconds or -1
+// cpu_use - CPU time spent by the system meanwhile
+static long configure(int fpp_dev, FILE *rbf_file, unsigned char *chunk, long *cpu_use)
+{
+    struct timeval conf_start, conf_end;
+    long cpu_start = 0;
+    size_t read_cnt = 0;
+    int state = 0;
+
+    fseek(rbf_file, 0, SEEK_SET);
+    cpu_start = cpu_time_us();
+    gettimeofday(&conf_start, NULL);
+    if (ioctl(fpp_dev, FPP_IOC_START) < 0)
+    {
+        return -1;
+    }
+    while ((read_cnt = fread(chunk, sizeof(unsigned char), CHUNK_LEN, rbf_file)) > 0)
+    {
+        if (write(fpp_dev, (void *)chunk, read_cnt) != (ssize_t)read_cnt)
+        {
+            ioctl(fpp_dev, FPP_IOC_GET_STATE, &state);
+            printf("write fails in state %d.\n", state);
+            return -1;
+        }
+    }
+    if (ioctl(fpp_dev, FPP_IOC_FINISH) < 0)
+    {
+        return -1;
+    }
+    gettimeofday(&conf_end, NULL);
+    *cpu_use = cpu_time_us() - cpu_start;
+
+    return 1000000 * (conf_end.tv_sec - conf_start.tv_sec) + (conf_end.tv_usec - conf_start.tv_usec);
+}
+
+// one configuration decompressed on the fly, returns the time in microseconds or -1
+// cpu_use - CPU time spent by the system meanwhile
+static long configure_rbz(int fpp_dev, FILE *rbz_file, long *cpu_use)
+{
+    struct timeval conf_start, conf_end;
+    struct rbz_pipe pipe;
+    unsigned char *block = NULL;
+    size_t len = 0;
+    long cpu_start = 0;
+    int state = 0;
+    int ret = 0;
+
+    fseek(rbz_file, 0, SEEK_SET);
+    cpu_start = cpu_time_us();
+    gettimeofday(&conf_start, NULL);
+    if (rbz_pipe_open(&pipe, rbz_file) < 0)
+    {
+        return -1;
+    }
+    if (ioctl(fpp_dev, FPP_IOC_START) < 0)
+    {
+        ret = -1;
+    }
+    while ((0 == ret) && (NULL != (block = rbz_pipe_get(&pipe, &len))))
+    {
+        if (write(fpp_dev, (void *)block, len) != (ssize_t)len)
+        {
+            ioctl(fpp_dev, FPP_IOC_GET_STATE, &state);
+            printf("write fails in state %d.\n", state);
+            ret = -1;
+        }
+        rbz_pipe_put(&pipe);
+    }
+    if ((rbz_pipe_close(&pipe) < 0) && (0 == ret))
+    {
+        printf("corrupt rbz file.\n");
+        ret = -1;
+    }
+    if ((ioctl(fpp_dev, FPP_IOC_FINISH) < 0) || ret)
+    {
+        return -1;
+    }
+    gettimeofday(&conf_end, NULL);
+    *cpu_use = cpu_time_us() - cpu_start;
+
+    return 1000000 * (conf_end.tv_sec - conf_start.tv_sec) + (conf_end.tv_usec - conf_start.tv_usec);
+}
+
 int main(int argc, char **argv)
 {
     // open rbf file (raw binary file)
     FILE *rbf_file = NULL;
-	rbf_file = fopen("FPP_test.rbf", "rb");
+	rbf_file = fopen(argc >= 2 ? argv[1] : "FPP_test.rbf", "rb");
     if (NULL == rbf_file)
     {
         return -1;
     }
    
-    // get rbf file size
+    // get rbf file size, an RBZ1 header holds the decompressed size
     int rbf_size = 0;
+    int compressed = 0;
+    unsigned char header[RBZ_HDR_LEN] = {0};
     fseek(rbf_file, 0, SEEK_END);
     rbf_size = ftell(rbf_file);
     fseek(rbf_file, 0, SEEK_SET);
+    if ((RBZ_HDR_LEN == fread(header, 1, RBZ_HDR_LEN, rbf_file)) && rbz_is_rbz(header, RBZ_HDR_LEN))
+    {
+        compressed = 1;
+        printf("rbz file, %d bytes compressed.\n", rbf_size);
+        rbf_size = rbz_get32(header + 4);
+    }
+    fseek(rbf_file, 0, SEEK_SET);
     
-    // allocate rbf buffer and read from rbf file
-    unsigned char *rbf_buf;
-    rbf_buf = (unsigned char*)malloc(sizeof(unsigned char) * rbf_size);
-	fread(rbf_buf, sizeof(unsigned char), rbf_size, rbf_file);
+    // allocate chunk buffer, the rbf file is read while the FPGA is clocked
+    unsigned char *chunk;
+    chunk = (unsigned char*)malloc(sizeof(unsigned char) * CHUNK_LEN);
+    if (NULL == chunk)
+    {
+        fclose(rbf_file);
+        return -1;
+    }
     
     // open fpp device
     int fpp_dev = 0;
@@ -35,36 +207,71 @@ int main(int argc, char **argv)
     if (fpp_dev < 0)
     {
         printf("open /dev/fpp failed.\n");
-        free(rbf_buf);
+        free(chunk);
         fclose(rbf_file);
         return -1;
     }   
 
-    // configure FPGA
-    int write_cnt = 0;
-    struct timeval conf_start, conf_end;
-    long conf_use = 0;
+    // configure FPGA, gpiolib DCLK, the register fast path and then SDMA
+    const char *mode_names[MODE_CNT] = {"gpiolib", "register", "sdma"};
+    const int mode_fast_dclk[MODE_CNT] = {0, 1, 1};
+    const int mode_use_sdma[MODE_CNT] = {0, 0, 1};
+    const char *engine_names[] = {"gpiolib", "register", "sdma"};
+    long conf_use[MODE_CNT] = {0};
+    long cpu_use[MODE_CNT] = {0};
+    int engine[MODE_CNT] = {0};
+    int fast_dclk = read_param(FAST_DCLK_PARAM);
+    int use_sdma = read_param(USE_SDMA_PARAM);
     printf("****************************\n");
-    printf("configuration starts.\n");
-    gettimeofday(&conf_start, NULL);
-    write_cnt = write(fpp_dev, (void *)rbf_buf, rbf_size);
-    gettimeofday(&conf_end, NULL);
-    conf_use = 1000000 * (conf_end.tv_sec - conf_start.tv_sec) + (conf_end.tv_usec - conf_start.tv_usec);
-    if (write_cnt != rbf_size) 
+    printf("configuration starts, %d bytes.\n", rbf_size);
+    for (int mode = 0; mode < MODE_CNT; mode++)
     {
-        printf("configuration fails.\n");
+        write_param(FAST_DCLK_PARAM, mode_fast_dclk[mode]);
+        write_param(USE_SDMA_PARAM, mode_use_sdma[mode]);
+        if (compressed)
+            conf_use[mode] = configure_rbz(fpp_dev, rbf_file, &cpu_use[mode]);
+        else
+            conf_use[mode] = configure(fpp_dev, rbf_file, chunk, &cpu_use[mode]);
+        // the driver falls back when the FPP lines or the SDMA channel are missing
+        if ((ioctl(fpp_dev, FPP_IOC_GET_ENGINE, &engine[mode]) < 0)
+                || (engine[mode] < FPP_ENGINE_SLOW) || (engine[mode] > FPP_ENGINE_SDMA))
+        {
+            engine[mode] = FPP_ENGINE_SLOW;
+        }
+        if (conf_use[mode] < 0) 
+        {
+            printf("configuration fails (%s DCLK, ran %s).\n", mode_names[mode], engine_names[engine[mode]]);
+        }
+        else
+        {
+            printf("configuration succeeds (%s DCLK, ran %s).\n", mode_names[mode], engine_names[engine[mode]]); 
+        }
     }
-    else
+    printf("****************************\n");
+    for (int mode = 0; mode < MODE_CNT; mode++)
     {
-        printf("configuration succeeds.\n"); 
-        printf("****************************\n");
-        printf("configuration time : %.2f s.\n", (float)conf_use / 1000000);
-        printf("****************************\n");
+        if (conf_use[mode] >= 0)
+        {
+            printf("configuration time (%-8s, ran %-8s) : %.2f s, system CPU %.2f s, %.1fx gpiolib.\n",
+                    mode_names[mode], engine_names[engine[mode]],
+                    (float)conf_use[mode] / 1000000, (float)cpu_use[mode] / 1000000,
+                    (conf_use[0] > 0) && (conf_use[mode] > 0) ? (float)conf_use[0] / conf_use[mode] : 0);
+        }
     }
+    printf("****************************\n");
 
+    // restore driver setting
+    if (fast_dclk >= 0)
+    {
+        write_param(FAST_DCLK_PARAM, fast_dclk);
+    }
+    if (use_sdma >= 0)
+    {
+        write_param(USE_SDMA_PARAM, use_sdma);
+    }
     
     close(fpp_dev);
-    free(rbf_buf);
+    free(chunk);
     fclose(rbf_file);
 
     return 0;
@@ -4,10 +4,27 @@
 // DESP : 16-bit data/addr multiplexed mode (default)
 //        synchronous transmission mode
 //        dmode / MUM / BCD / WWSC sysfs
+//        dmode 3 downloads the FPGA program packed, two bytes per bus word
+//        dmode 4 downloads it on an 8-bit port, one byte per bus cycle
+//        ring buffer mmap is cacheable, consumers sync each slot by ioctl
+//        reads below dma_cutoff bytes are CPU copies, larger ones SDMA
+//        (cutoff calibrated at load with dma_calibrate = 1, EIM_IOC_SET_CONFIG,
+//        EIM_IOC_GET_ENGINE_STATS)
+//        opt-in busy-poll of SDMA reads (poll_us module parameter, EIM_IOC_SET_POLL)
+//        strided gather of interleaved channels into one slot (EIM_IOC_DEINTERLEAVE)
 // HIST : V1.0 2013.08.05 - eim driver program
 //        V1.1 2013.09.04 - add FPP function
 //        V1.2 2013.09.20 - add WWSC device attribute
 //		  V1.3 2013.11.21 - add SDMA function
+//		  V1.4 2026.10.19 - cacheable ring mmap with slot sync ioctls
+//		  V1.5 2026.10.19 - CPU / SDMA read engine chosen per request
+//		  V1.6 2026.10.19 - busy-poll completion mode (EIM_IOC_SET_POLL, poll_us)
+//		  V1.7 2026.10.19 - strided deinterleave request, SDMA or CPU (EIM_IOC_DEINTERLEAVE)
+//		  V1.8 2026.10.19 - SDMA channel priority at load (dma_prio)
+//		  V1.9 2026.10.19 - packed x16 program download (dmode 3)
+//		  V2.0 2026.10.19 - 8-bit port program download (dmode 4)
+//		  V2.1 2026.10.19 - program session over several writes (EIM_IOC_PROGRAM_BEGIN / END)
+//		  V2.2 2026.10.19 - program writes in EIM_PROGRAM_WINDOW pieces, packed marker on DA[15]
 
 #include <linux/fs.h>
 #include <linux/ioport.h>
@@ -18,6 +35,8 @@
 #include <linux/mutex.h>
 #include <linux/gpio.h>
 #include <linux/delay.h>
+#include <linux/moduleparam.h>
+#include <linux/ktime.h>
 #include <linux/dma-mapping.h>
 #include <linux/completion.h>
 #include <asm/io.h>
@@ -26,13 +45,21 @@
 
 #include <mach/iomux-mx6q.h>
 
+#include "eim_ioctl.h"
+
 
 // print debug information
 #define DEBUG 			        (0)
 
 // download mode
-#define DOWNLOAD_PROGRAM        (1)
-#define DOWNLOAD_PARAMETERS     (2)
+#define DOWNLOAD_PROGRAM        EIM_DMODE_PROGRAM
+#define DOWNLOAD_PARAMETERS     EIM_DMODE_PARAMETERS
+#define DOWNLOAD_PROGRAM_PACKED EIM_DMODE_PROGRAM_PACKED
+#define DOWNLOAD_PROGRAM_8BIT   EIM_DMODE_PROGRAM_8BIT
+
+// CS1GCR1 port size
+#define EIM_DSZ_16BIT           (1)     // 16 bit port resides on DATA[15:0]
+#define EIM_DSZ_8BIT            (4)     // 8 bit port resides on DATA[7:0]
 
 // registers address
 #define EIM_MEM_BASE  	        (0x0C000000)
@@ -48,11 +75,6 @@
 
 #define DEVICE_NAME 	        "eim"
 
-// DMA resources
-#define SDMA_RBUF_CNT			(16)
-#define SDMA_M2M_UNIT			(1024)
-#define SDMA_M2M_RBUF			(SDMA_RBUF_CNT * SDMA_M2M_UNIT)
-
 // GPIO defination
 #define GPIO_FPP_UNUSE          IMX_GPIO_NR(4,14)   // KEY_COL4
 #define GPIO_FPP_nCONFIG        IMX_GPIO_NR(3,16)   // EIM_D16
@@ -72,6 +94,36 @@
 #define SET_DAT6_PUSHPULL()     iowrite32(0x0001B0B0, CSI0_DAT8_PCR)
 #define SET_DAT7_PUSHPULL()     iowrite32(0x0001B0B0, CSI0_DAT9_PCR)
 
+// read engine calibration (slot sizes, loops per size)
+#define EIM_CAL_MIN             (32)
+#define EIM_CAL_LOOPS           (8)
+#define EIM_CUTOFF_DEFAULT      (SDMA_M2M_UNIT / 2)    // cutoff without dma_calibrate
+
+// entries per descriptor of a strided gather (imx-sdma has one page of buffer descriptors)
+#define EIM_DEINT_SG_MAX        (128)
+
+// reads of dma_cutoff bytes and more go through SDMA, smaller ones are CPU copies
+// dma_cutoff < 0 : EIM_CUTOFF_DEFAULT, or measured at load with dma_calibrate = 1
+//                  (the first size SDMA beats the CPU copy)
+// dma_calibrate = 1 reads the FPGA window at load, so it is off by default
+static int dma_cutoff = -1;
+module_param(dma_cutoff, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(dma_cutoff, "smallest read in bytes carried by SDMA (-1 : default or calibrated)");
+static int dma_calibrate = 0;
+module_param(dma_calibrate, int, S_IRUGO);
+MODULE_PARM_DESC(dma_calibrate, "measure an unset dma_cutoff on the bus at load (0 / 1)");
+
+// busy-poll budget of a newly opened file in microseconds (0 : sleep)
+// small reads finish well before a sleep / wakeup round trip
+static int poll_us = 0;
+module_param(poll_us, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(poll_us, "default busy-poll budget of SDMA reads in microseconds (0 : sleep)");
+
+// priority of the SDMA channel, read at load (DMA_PRIO_HIGH 0 / MEDIUM 1 / LOW 2)
+static int dma_prio = DMA_PRIO_HIGH;
+module_param(dma_prio, int, S_IRUGO);
+MODULE_PARM_DESC(dma_prio, "priority of the SDMA channel (0 high - 2 low)");
+
 
 // IOMUX configuration (eim_mux)
 static iomux_v3_cfg_t eim_mux_pads[] = {
@@ -190,17 +242,27 @@ typedef struct _eim_dev
 	struct dma_slave_config dma_m2m_config;
 	struct scatterlist dma_sg_eim;
 	struct scatterlist dma_sg_buf;
+	struct scatterlist dma_sg_deint_src[EIM_DEINT_SG_MAX];
+	struct scatterlist dma_sg_deint_dst[EIM_DEINT_SG_MAX];
 	struct completion dma_callback_ok;
-	unsigned char *dma_wbuf;			//
 	unsigned char *dma_rbuf;
+	dma_addr_t dma_rbuf_dma;		// bus address of the ring (mapped once, synchronised by ioctl)
 	int dma_rbuf_idx;
 
+	// reads and bytes carried by the CPU copy and by SDMA
+	struct eim_engine_stats engine_stats;
+
 	// device open state
     atomic_t open_state;
 
     // download mode
     int eim_dmode;
 
+    // program session : one nCONFIG pulse for several writes, prog_bytes
+    // counts the bytes downloaded so far
+    int prog_session;
+    int prog_bytes;
+
     // mutex lock
     struct mutex eim_mutex_lock;
 }eim_dev;
@@ -426,7 +488,7 @@ static int eim_config(void)
     int AUS		= 0;	// Address Unshifted - shifted
     int CSREC 	= 1;	// CS Recovery - 1 EIM clock cycle
     int SP 		= 0;	// Supervisor Protect - allowded
-    int DSZ 	= 1;	// Port Size - 16 bit port resides on DATA[15:0]
+    int DSZ 	= EIM_DSZ_16BIT;	// Port Size - 16 bit port resides on DATA[15:0]
     int BCS 	= 1;	// Wait Cycle Brfore Burst Clock Start - 1 EIM clock cycle
     int BCD 	= 3;	// Burst Clock Divisor - 0(132M) 1(66M) 2(44M) 3(33M)
     int WC 		= 0;	// Write Continuous - according to BL value
@@ -602,6 +664,11 @@ static int eim_open(struct inode *inode, struct file *filp)
         return -EBUSY;
     }
 
+	// per file busy-poll budget (EIM_IOC_SET_POLL)
+	filp->private_data = (void *)(long)clamp(poll_us, 0, EIM_POLL_MAX_US);
+	mdev->prog_session = 0;
+	mdev->prog_bytes = 0;
+
     return 0;
 }
 
@@ -628,6 +695,69 @@ static int eim_release(struct inode *inode, struct file *filp)
     return 0;
 }
 
+// ------------------------------------------------------------
+// Description :
+// 	   This function sets the port size of CS1 (CS1GCR1.DSZ), called
+//     with eim_mutex_lock held.
+// Parameters :
+//     dsz - EIM_DSZ_16BIT / EIM_DSZ_8BIT
+// Return Value :
+//     the previous port size
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static int eim_set_dsz(int dsz)
+{
+    int eim_dsz_mask = 7;
+    u32 cs1gpr1_rreg = 0;
+    u32 cs1gpr1_wreg = 0;
+
+    cs1gpr1_rreg = ioread32(mdev->eim_base + 0x18);
+    cs1gpr1_wreg = (cs1gpr1_rreg & ~bitfield(16, 3, eim_dsz_mask)) | bitfield(16, 3, dsz);
+    iowrite32(cs1gpr1_wreg, mdev->eim_base + 0x18);
+
+    return (cs1gpr1_rreg & bitfield(16, 3, eim_dsz_mask)) >> 16;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function pulses nCONFIG and waits for the FPGA to accept
+//     its program.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_program_start success.
+// Errors :
+//     -EFAULT - nSTATUS did not follow nCONFIG
+// -------------------------------------------------------------
+static int eim_program_start(void)
+{
+    // put nCONFIG low and then pull it up
+    DRIVE_nCONFIG_LOW();
+    ndelay(500);
+    DRIVE_nCONFIG_HIGH();
+
+    // check nSTATUS if it is desserted or not
+    if (READ_nSTATUS())
+    {
+        printk("< eim.c > eim_program_start : nSTATUS is still high.\n");
+        return -EFAULT;
+    }
+
+    // check nSTATUS if it is asserted or not
+    udelay(230);
+    if (!READ_nSTATUS())
+    {
+        printk("< eim.c > eim_program_start : nSTATUS is still low.\n");
+        return -EFAULT;
+    }
+
+    // delay more than 2 us and then configure FPGA
+    udelay(2);
+
+    return 0;
+}
+
 // ------------------------------------------------------------
 // Description :
 // 	   This function implements write file operation.
@@ -646,42 +776,66 @@ static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count
 {
     int mode = 0;
     mode = mdev->eim_dmode;
-    if (DOWNLOAD_PROGRAM == mode)
+    if ((DOWNLOAD_PROGRAM == mode) || (DOWNLOAD_PROGRAM_PACKED == mode) || (DOWNLOAD_PROGRAM_8BIT == mode))
     {
         int ret = 0;
-
-        // put nCONFIG low and then pull it up
-        DRIVE_nCONFIG_LOW();
-        ndelay(500);
-        DRIVE_nCONFIG_HIGH();
-
-        // check nSTATUS if it is desserted or not
-        if (READ_nSTATUS())
+        int offset = 0;
+        int len = 0;
+        int pos = 0;
+        int n = 0;
+        int dsz = 0;
+
+        // packed words go to EIM_PACKED_OFFSET (DA[15] high), two RBF bytes each,
+        // the address lines stay below DA[15] inside the program window
+        offset = (DOWNLOAD_PROGRAM_PACKED == mode) ? EIM_PACKED_OFFSET : 0;
+        len = min(EIM_MEM_LEN, (int)count);
+        if ((DOWNLOAD_PROGRAM_PACKED == mode) && (len & 1))
         {
-            printk("< eim.c > fpp_write : nSTATUS is still high.\n");
-            return -EFAULT;
+            printk(KERN_ERR "< eim.c > eim_write : packed program of odd length %d.\n", len);
+            return -EINVAL;
         }
 
-        // check nSTATUS if it is asserted or not
-        udelay(230);
-        if (!READ_nSTATUS())
+        // the session pulsed nCONFIG already
+        if (!mdev->prog_session)
         {
-            printk("< eim.c > eim_write : nSTATUS is still low.\n");
-            return -EFAULT;
+            ret = eim_program_start();
+            if (ret)
+            {
+                return ret;
+            }
         }
 
-        // delay more than 2 us and then configure FPGA
-        udelay(2);
-
         // drive config_data on data bus
         // config_data should be driven on the bus on the rising edge of DCLK
-	    ret = copy_from_user((void *)mdev->eim_mem_base, buf, min(EIM_MEM_LEN, (int)count));
+        // the 8-bit profile narrows the port for the download only
+        if (DOWNLOAD_PROGRAM_8BIT == mode)
+        {
+            mutex_lock(&mdev->eim_mutex_lock);
+            dsz = eim_set_dsz(EIM_DSZ_8BIT);
+        }
+        for (pos = 0; (0 == ret) && (pos < len); pos += n)
+        {
+            n = min(EIM_PROGRAM_WINDOW, len - pos);
+	        ret = copy_from_user((void *)(mdev->eim_mem_base + offset), buf + pos, n);
+        }
+        if (DOWNLOAD_PROGRAM_8BIT == mode)
+        {
+            eim_set_dsz(dsz);
+            mutex_unlock(&mdev->eim_mutex_lock);
+        }
 	    if (ret)
 	    {
 	        printk(KERN_ERR "< eim.c > eim_write : copy_from_user failed.\n");
 	        return -EFAULT;
 	    }
 
+        // EIM_IOC_PROGRAM_END checks CONF_DONE of a session
+        if (mdev->prog_session)
+        {
+            mdev->prog_bytes += len;
+            return len;
+        }
+
         // check CONF_DONE if it is asserted or not
         if (!READ_CONF_DONE())
         {
@@ -693,6 +847,7 @@ static ssize_t eim_write(struct file *filp, const char __user *buf, size_t count
     printk(KERN_INFO "< eim.c > eim write : download FPGA program.\n");
 #endif
 
+        return len;
     }
     else if (DOWNLOAD_PARAMETERS == mode)
     {
@@ -732,61 +887,95 @@ static void dma_m2m_callback(void *data)
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function implements read file operation.
+// 	   This function copies the EIM window into one ring slot by the CPU.
 // Parameters :
-//	   filp - object file
-//	   buf - buffer pointer in user space
-//	   count - the actual number of data to read
-//	   offset - the offset of data
+//	   slot - byte offset of the slot in dma_rbuf
+//	   count - the number of bytes (no more than SDMA_M2M_UNIT)
 // Return Value :
-//     positive value - the actual number of data read
-//	   negative value - copy_to_user error
+//     None.
 // Errors :
 //     None.
 // -------------------------------------------------------------
-static ssize_t eim_read(struct file *filp, char __user *buf, size_t count, loff_t *offset)
+static void eim_read_cpu(unsigned int slot, size_t count)
+{
+	memcpy(mdev->dma_rbuf + slot, mdev->eim_mem_base, count);
+
+	// clean the slot, consumers invalidate it (EIM_IOC_SYNC_FOR_CPU) or map it noncached
+	dma_sync_single_for_device(NULL, mdev->dma_rbuf_dma + slot, count, DMA_BIDIRECTIONAL);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function waits for a submitted copy. It spins on the descriptor
+//     status for up to budget_us and sleeps on the callback after that.
+// Parameters :
+//	   cookie - cookie returned by dmaengine_submit
+//	   budget_us - busy-poll budget in microseconds (0 : sleep at once)
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_dma_wait(dma_cookie_t cookie, int budget_us)
 {
-//	printk("eim_mem_base[0] = %d\n", (unsigned char)*( (char*)mdev->eim_mem_base) + 0 );		//
-//	printk("eim_mem_base[1] = %d\n", (unsigned char)*( (char*)mdev->eim_mem_base) + 1 );		//
-//	printk("eim_mem_base[2] = %d\n", (unsigned char)*( (char*)mdev->eim_mem_base) + 2 );		//
-//	printk("eim_mem_base[3] = %d\n", (unsigned char)*( (char*)mdev->eim_mem_base) + 3 );		//
+	ktime_t end;
 
-	memcpy(mdev->dma_wbuf, mdev->eim_mem_base, count);
+	if (budget_us > 0)
+	{
+		end = ktime_add_us(ktime_get(), budget_us);
+		do
+		{
+			// the callback still runs, consume its completion so the next
+			// read does not see a stale one
+			if ((DMA_SUCCESS == dma_async_is_tx_complete(mdev->dma_m2m_chan, cookie, NULL, NULL)) &&
+				try_wait_for_completion(&mdev->dma_callback_ok))
+			{
+				return;
+			}
+			cpu_relax();
+		} while (ktime_to_ns(ktime_sub(end, ktime_get())) > 0);
+	}
 
-//	printk("dma_wbuf[0] = %d\n", (unsigned char)*( (char*)mdev->dma_wbuf) + 0 );		//
-//	printk("dma_wbuf[1] = %d\n", (unsigned char)*( (char*)mdev->dma_wbuf) + 1 );		//
-//	printk("dma_wbuf[2] = %d\n", (unsigned char)*( (char*)mdev->dma_wbuf) + 2 );		//
-//	printk("dma_wbuf[3] = %d\n", (unsigned char)*( (char*)mdev->dma_wbuf) + 3 );		//
+	wait_for_completion(&mdev->dma_callback_ok);
+}
 
-	// correspond dma_sg_eim and EIM_MEM_BASE
-	sg_init_one(&mdev->dma_sg_eim, mdev->dma_wbuf, count);
-//	printk(KERN_INFO "count = %d\n", count);	//
-	dma_map_sg(NULL, &mdev->dma_sg_eim, 1, mdev->dma_m2m_config.direction);
-	mdev->dma_m2m_desc = mdev->dma_m2m_chan->device->device_prep_slave_sg(mdev->dma_m2m_chan, &mdev->dma_sg_eim, 1, mdev->dma_m2m_config.direction, 1);
+// ------------------------------------------------------------
+// Description :
+// 	   This function runs one M2M copy between two entry lists of equal
+//     lengths and waits for it.
+// Parameters :
+//	   src - source entries (bus addresses)
+//	   dst - destination entries (bus addresses)
+//	   nents - the number of entries in each list
+//	   budget_us - busy-poll budget in microseconds (0 : sleep)
+// Return Value :
+//     0 - eim_dma_run success.
+// Errors :
+//     -EFAULT - descriptor preparation failed
+// -------------------------------------------------------------
+static int eim_dma_run(struct scatterlist *src, struct scatterlist *dst, int nents, int budget_us)
+{
+	dma_cookie_t cookie;
+
+	// M2M takes the source list first and then the destination list
+	mdev->dma_m2m_desc = mdev->dma_m2m_chan->device->device_prep_slave_sg(mdev->dma_m2m_chan, src, nents, mdev->dma_m2m_config.direction, 1);
 	if (!mdev->dma_m2m_desc)
 	{
-		printk(KERN_ERR "< eim.c > eim_read : device_prep_slave_sg eim_mem_base failed.\n");
-		return -1;
+		printk(KERN_ERR "< eim.c > eim_dma_run : device_prep_slave_sg src failed.\n");
+		return -EFAULT;
 	}
-
-	// correspond dma_sg_buf and dma_rbuf
-	sg_init_one(&mdev->dma_sg_buf, mdev->dma_rbuf + mdev->dma_rbuf_idx * SDMA_M2M_UNIT, count);
-	// change the index of Ring Buffer
-	mdev->dma_rbuf_idx = (mdev->dma_rbuf_idx + 1) % SDMA_RBUF_CNT;
-//	printk(KERN_INFO "mdev->dma_rbuf_idx = %d\n", mdev->dma_rbuf_idx);	//
-	dma_map_sg(NULL, &mdev->dma_sg_buf, 1, mdev->dma_m2m_config.direction);
-	mdev->dma_m2m_desc = mdev->dma_m2m_chan->device->device_prep_slave_sg(mdev->dma_m2m_chan, &mdev->dma_sg_buf, 1, mdev->dma_m2m_config.direction, 0);
+	mdev->dma_m2m_desc = mdev->dma_m2m_chan->device->device_prep_slave_sg(mdev->dma_m2m_chan, dst, nents, mdev->dma_m2m_config.direction, 0);
 	if (!mdev->dma_m2m_desc)
 	{
-		printk(KERN_ERR "< eim.c > eim_read : device prep_slave_sg dma_rbuf failed.\n");
-		return -1;
+		printk(KERN_ERR "< eim.c > eim_dma_run : device_prep_slave_sg dst failed.\n");
+		return -EFAULT;
 	}
 
 	// set callback function
 	mdev->dma_m2m_desc->callback = dma_m2m_callback;
 
 	// add to the DMA trasferring queue
-	dmaengine_submit(mdev->dma_m2m_desc);
+	cookie = dmaengine_submit(mdev->dma_m2m_desc);
 
 	// start DMA transferring
 	mdev->dma_m2m_chan->device->device_issue_pending(mdev->dma_m2m_chan);
@@ -796,60 +985,430 @@ static ssize_t eim_read(struct file *filp, char __user *buf, size_t count, loff_
 	ssleep(5);
 #endif
 
-	// wait for DMA callback function completion
+	// wait for DMA callback function completion (busy-poll first if asked for)
 	// ensures that DMA work has been completed before eim_read returns
-	wait_for_completion(&mdev->dma_callback_ok);
+	eim_dma_wait(cookie, budget_us);
 
-	// release resources
-	dma_unmap_sg(NULL, &mdev->dma_sg_eim, 1, mdev->dma_m2m_config.direction);
-	dma_unmap_sg(NULL, &mdev->dma_sg_buf, 1, mdev->dma_m2m_config.direction);
+	return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function copies the EIM window into one ring slot by SDMA.
+// Parameters :
+//	   slot - byte offset of the slot in dma_rbuf
+//	   count - the number of bytes (no more than SDMA_M2M_UNIT)
+//	   budget_us - busy-poll budget in microseconds (0 : sleep)
+// Return Value :
+//     0 - eim_read_dma success.
+// Errors :
+//     -EFAULT - descriptor preparation failed
+// -------------------------------------------------------------
+static int eim_read_dma(unsigned int slot, size_t count, int budget_us)
+{
+	// correspond dma_sg_eim and EIM_MEM_BASE
+	sg_init_table(&mdev->dma_sg_eim, 1);
+	sg_dma_address(&mdev->dma_sg_eim) = EIM_MEM_BASE;
+	sg_dma_len(&mdev->dma_sg_eim) = count;
+
+	// correspond dma_sg_buf and dma_rbuf (the ring stays mapped, see eim_ioctl)
+	sg_init_table(&mdev->dma_sg_buf, 1);
+	sg_dma_address(&mdev->dma_sg_buf) = mdev->dma_rbuf_dma + slot;
+	sg_dma_len(&mdev->dma_sg_buf) = count;
+
+	return eim_dma_run(&mdev->dma_sg_eim, &mdev->dma_sg_buf, 1, budget_us);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function checks a strided gather request.
+// Parameters :
+//	   req - the request
+// Return Value :
+//     0 - the request is valid
+// Errors :
+//     -EINVAL - bad element size, misaligned stride, empty request,
+//               output larger than a slot or pattern outside the window
+// -------------------------------------------------------------
+static int eim_deint_check(const struct eim_deinterleave *req)
+{
+	u64 last = 0;
+
+	if (((1 != req->elem_size) && (2 != req->elem_size) && (4 != req->elem_size)) ||
+		(req->stride % req->elem_size) || (0 == req->channels) || (0 == req->count) ||
+		(req->channels > SDMA_M2M_UNIT) || (req->count > SDMA_M2M_UNIT) ||
+		(req->channels * req->count * req->elem_size > SDMA_M2M_UNIT))
+	{
+		return -EINVAL;
+	}
+
+	// end of the last element of the last channel
+	last = (u64)(req->count - 1) * req->stride + (u64)req->channels * req->elem_size;
+	if (last > EIM_MEM_LEN)
+	{
+		return -EINVAL;
+	}
 
 	return 0;
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function implements IO control file operation.
+// 	   This function gathers a strided pattern of the EIM window into one
+//     ring slot by the CPU, channel after channel.
+// Parameters :
+//	   req - the request (checked by eim_deint_check)
+//	   slot - byte offset of the slot in dma_rbuf
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void eim_deint_cpu(const struct eim_deinterleave *req, unsigned int slot)
+{
+	unsigned char *dst = mdev->dma_rbuf + slot;
+	void __iomem *src = NULL;
+	unsigned int c = 0;
+	unsigned int j = 0;
+
+	for (c = 0; c < req->channels; c++)
+	{
+		for (j = 0; j < req->count; j++)
+		{
+			src = mdev->eim_mem_base + c * req->elem_size + j * req->stride;
+			switch (req->elem_size)
+			{
+			case 1:
+				*dst = __raw_readb(src);
+				break;
+			case 2:
+				*(u16 *)dst = __raw_readw(src);
+				break;
+			default:
+				*(u32 *)dst = __raw_readl(src);
+				break;
+			}
+			dst += req->elem_size;
+		}
+	}
+
+	// clean the slot, consumers invalidate it (EIM_IOC_SYNC_FOR_CPU) or map it noncached
+	dma_sync_single_for_device(NULL, mdev->dma_rbuf_dma + slot, req->channels * req->count * req->elem_size, DMA_BIDIRECTIONAL);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gathers a strided pattern of the EIM window into one
+//     ring slot by SDMA : one entry per element (runs contiguous on both
+//     sides are merged), EIM_DEINT_SG_MAX entries per descriptor.
+// Parameters :
+//	   req - the request (checked by eim_deint_check)
+//	   slot - byte offset of the slot in dma_rbuf
+//	   budget_us - busy-poll budget in microseconds (0 : sleep)
+// Return Value :
+//     0 - eim_deint_dma success.
+// Errors :
+//     -EFAULT - descriptor preparation failed
+// -------------------------------------------------------------
+static int eim_deint_dma(const struct eim_deinterleave *req, unsigned int slot, int budget_us)
+{
+	struct scatterlist *src_sg = mdev->dma_sg_deint_src;
+	struct scatterlist *dst_sg = mdev->dma_sg_deint_dst;
+	dma_addr_t src_end = 0;
+	dma_addr_t dst_end = 0;
+	unsigned int c = 0;
+	unsigned int j = 0;
+	int n = 0;
+	int ret = 0;
+
+	sg_init_table(src_sg, EIM_DEINT_SG_MAX);
+	sg_init_table(dst_sg, EIM_DEINT_SG_MAX);
+	for (c = 0; c < req->channels; c++)
+	{
+		for (j = 0; j < req->count; j++)
+		{
+			dma_addr_t src = EIM_MEM_BASE + c * req->elem_size + j * req->stride;
+			dma_addr_t dst = mdev->dma_rbuf_dma + slot + (c * req->count + j) * req->elem_size;
+
+			if (n && (src == src_end) && (dst == dst_end))
+			{
+				sg_dma_len(&src_sg[n - 1]) += req->elem_size;
+				sg_dma_len(&dst_sg[n - 1]) += req->elem_size;
+			}
+			else
+			{
+				if (EIM_DEINT_SG_MAX == n)
+				{
+					ret = eim_dma_run(src_sg, dst_sg, n, budget_us);
+					if (ret)
+					{
+						return ret;
+					}
+					sg_init_table(src_sg, EIM_DEINT_SG_MAX);
+					sg_init_table(dst_sg, EIM_DEINT_SG_MAX);
+					n = 0;
+				}
+				sg_dma_address(&src_sg[n]) = src;
+				sg_dma_len(&src_sg[n]) = req->elem_size;
+				sg_dma_address(&dst_sg[n]) = dst;
+				sg_dma_len(&dst_sg[n]) = req->elem_size;
+				n++;
+			}
+			src_end = src + req->elem_size;
+			dst_end = dst + req->elem_size;
+		}
+	}
+
+	return eim_dma_run(src_sg, dst_sg, n, budget_us);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function implements read file operation. The EIM window is
+//     copied into the next ring slot, by SDMA from dma_cutoff bytes on
+//     and by the CPU below it.
 // Parameters :
 //	   filp - object file
-//	   cmd - command
-//	   arg - arguments of command above
+//	   buf - not used (the data is read through the mmap'ed ring)
+//	   count - the actual number of data to read
+//	   offset - the offset of data
 // Return Value :
-//	   0 - eim_ioctl success
+//     0 - eim_read success
+//	   negative value - SDMA error
 // Errors :
 //     None.
+// -------------------------------------------------------------
+static ssize_t eim_read(struct file *filp, char __user *buf, size_t count, loff_t *offset)
+{
+	unsigned int slot = 0;
+	int ret = 0;
+
+	count = min(count, (size_t)SDMA_M2M_UNIT);
+
+	mutex_lock(&mdev->eim_mutex_lock);
+	slot = mdev->dma_rbuf_idx * SDMA_M2M_UNIT;
+	// change the index of Ring Buffer
+	mdev->dma_rbuf_idx = (mdev->dma_rbuf_idx + 1) % SDMA_RBUF_CNT;
+
+	if ((dma_cutoff >= 0) && (count >= (size_t)dma_cutoff))
+	{
+		mdev->engine_stats.dma_reads++;
+		mdev->engine_stats.dma_read_bytes += count;
+		ret = eim_read_dma(slot, count, (int)(long)filp->private_data);
+	}
+	else
+	{
+		mdev->engine_stats.cpu_reads++;
+		mdev->engine_stats.cpu_read_bytes += count;
+		eim_read_cpu(slot, count);
+	}
+	mutex_unlock(&mdev->eim_mutex_lock);
+
+	return ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function implements IO control file operation : ring slot
+//     sync (only needed with EIM_RING_CACHED mappings), busy-poll budget,
+//     CPU / SDMA cutoff, engine counters and strided deinterleave.
+// Parameters :
+//	   filp - object file
+//	   cmd - EIM_IOC_SYNC_FOR_CPU / EIM_IOC_SYNC_FOR_DEVICE / EIM_IOC_SET_POLL /
+//	         EIM_IOC_GET_CONFIG / EIM_IOC_SET_CONFIG / EIM_IOC_GET_ENGINE_STATS /
+//	         EIM_IOC_DEINTERLEAVE / EIM_IOC_PROGRAM_BEGIN / EIM_IOC_PROGRAM_END
+//	   arg - struct eim_ring_sync / eim_config / eim_engine_stats / eim_deinterleave
+//	         in user space, or the busy-poll budget in microseconds
+// Return Value :
+//	   0 - eim_ioctl success
+// Errors :
+//     -EFAULT - copy from / to user space failed
+//     -EINVAL - the range is outside the ring, the budget is out of range,
+//               the deinterleave pattern is invalid or no program session is open
+//     -EIO - nSTATUS did not follow nCONFIG, or CONF_DONE is low at the end of
+//            the program session
+//     -ENOTTY - unknown command
 // ------------------------------------------------------------
 static long eim_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
-	// Nothing to do
+	struct eim_ring_sync sync;
+	struct eim_config cfg;
+	struct eim_engine_stats stats;
+	struct eim_deinterleave deint;
+	unsigned int bytes = 0;
+	int ret = 0;
 
 #if DEBUG == 1
     printk(KERN_INFO "< eim.c > eim IO control.\n");
     printk(KERN_INFO "< eim.c > cmd:%d, arg:%ld.\n", cmd, arg);
 #endif
 
+	switch (cmd)
+	{
+	case EIM_IOC_SET_POLL:
+		if (arg > EIM_POLL_MAX_US)
+		{
+			return -EINVAL;
+		}
+		filp->private_data = (void *)arg;
+		break;
+
+	case EIM_IOC_SYNC_FOR_CPU:
+	case EIM_IOC_SYNC_FOR_DEVICE:
+		if (copy_from_user(&sync, (void __user *)arg, sizeof(sync)))
+		{
+			return -EFAULT;
+		}
+		if ((sync.offset >= SDMA_M2M_RBUF) || (sync.len > SDMA_M2M_RBUF - sync.offset))
+		{
+			return -EINVAL;
+		}
+
+		// only the slot range is invalidated / cleaned
+		if (EIM_IOC_SYNC_FOR_CPU == cmd)
+		{
+			dma_sync_single_for_cpu(NULL, mdev->dma_rbuf_dma + sync.offset, sync.len, DMA_BIDIRECTIONAL);
+		}
+		else
+		{
+			dma_sync_single_for_device(NULL, mdev->dma_rbuf_dma + sync.offset, sync.len, DMA_BIDIRECTIONAL);
+		}
+		break;
+
+	case EIM_IOC_GET_CONFIG:
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.dma_cutoff = (dma_cutoff < 0) ? EIM_CUTOFF_CPU_ONLY : dma_cutoff;
+		if (copy_to_user((void __user *)arg, &cfg, sizeof(cfg)))
+		{
+			return -EFAULT;
+		}
+		break;
+
+	case EIM_IOC_SET_CONFIG:
+		if (copy_from_user(&cfg, (void __user *)arg, sizeof(cfg)))
+		{
+			return -EFAULT;
+		}
+		if (cfg.dma_cutoff)
+		{
+			mutex_lock(&mdev->eim_mutex_lock);
+			dma_cutoff = (cfg.dma_cutoff < 0) ? EIM_CUTOFF_CPU_ONLY : cfg.dma_cutoff;
+			mutex_unlock(&mdev->eim_mutex_lock);
+		}
+		break;
+
+	case EIM_IOC_GET_ENGINE_STATS:
+		mutex_lock(&mdev->eim_mutex_lock);
+		stats = mdev->engine_stats;
+		mutex_unlock(&mdev->eim_mutex_lock);
+		if (copy_to_user((void __user *)arg, &stats, sizeof(stats)))
+		{
+			return -EFAULT;
+		}
+		break;
+
+	case EIM_IOC_DEINTERLEAVE:
+		if (copy_from_user(&deint, (void __user *)arg, sizeof(deint)))
+		{
+			return -EFAULT;
+		}
+		ret = eim_deint_check(&deint);
+		if (ret)
+		{
+			return ret;
+		}
+		bytes = deint.channels * deint.count * deint.elem_size;
+
+		// one slot, like read()
+		mutex_lock(&mdev->eim_mutex_lock);
+		deint.offset = mdev->dma_rbuf_idx * SDMA_M2M_UNIT;
+		mdev->dma_rbuf_idx = (mdev->dma_rbuf_idx + 1) % SDMA_RBUF_CNT;
+		if ((EIM_ENGINE_DMA == deint.engine) ||
+			((EIM_ENGINE_AUTO == deint.engine) && (dma_cutoff >= 0) && (bytes >= (unsigned int)dma_cutoff)))
+		{
+			mdev->engine_stats.dma_reads++;
+			mdev->engine_stats.dma_read_bytes += bytes;
+			ret = eim_deint_dma(&deint, deint.offset, (int)(long)filp->private_data);
+		}
+		else
+		{
+			mdev->engine_stats.cpu_reads++;
+			mdev->engine_stats.cpu_read_bytes += bytes;
+			eim_deint_cpu(&deint, deint.offset);
+		}
+		mutex_unlock(&mdev->eim_mutex_lock);
+		if (ret)
+		{
+			return ret;
+		}
+
+		if (copy_to_user((void __user *)arg, &deint, sizeof(deint)))
+		{
+			return -EFAULT;
+		}
+		break;
+
+	case EIM_IOC_PROGRAM_BEGIN:
+		if (eim_program_start())
+		{
+			return -EIO;
+		}
+		mdev->prog_session = 1;
+		mdev->prog_bytes = 0;
+		break;
+
+	case EIM_IOC_PROGRAM_END:
+		if (!mdev->prog_session)
+		{
+			return -EINVAL;
+		}
+		mdev->prog_session = 0;
+		if (!READ_CONF_DONE())
+		{
+			printk(KERN_ERR "< eim.c > eim_ioctl : CONF_DONE is still low after %d bytes.\n", mdev->prog_bytes);
+			return -EIO;
+		}
+		break;
+
+	default:
+		return -ENOTTY;
+	}
+
     return 0;
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function maps physical memory into user space.
+// 	   This function maps the ring into user space, the mmap offset
+//     carries the cache attribute (EIM_RING_OFFSET).
 // Parameters :
 //	   filp - object file
 //	   vma - virtual memory area struct
 // Return Value :
 //	   0 - eim_mmap success
 // Errors :
-//     None.
+//     -EINVAL - unknown attribute or mapping larger than the ring
+//     -ENXIO - remap failed
 // ------------------------------------------------------------
 static int eim_mmap(struct file *filp, struct vm_area_struct *vma)
 {
 	int ret = 0;
 	unsigned long size = vma->vm_end - vma->vm_start;
 	unsigned long page = virt_to_phys(mdev->dma_rbuf);
+	unsigned long mode = vma->vm_pgoff >> (EIM_RING_MODE_SHIFT - PAGE_SHIFT);
+
+	if ((mode >= EIM_RING_MODE_CNT) || (size > PAGE_ALIGN(SDMA_M2M_RBUF)))
+	{
+		printk(KERN_ERR "< eim.c > eim_mmap : invalid mapping.\n");
+		return -EINVAL;
+	}
 
 	vma->vm_flags |= (VM_IO | VM_DONTEXPAND);
-	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	if (EIM_RING_NONCACHED == mode)
+	{
+		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	}
+	// EIM_RING_CACHED keeps the default cacheable MAP_SHARED attributes
 
 	ret = io_remap_pfn_range(vma, vma->vm_start, page >> PAGE_SHIFT, size, vma->vm_page_prot);
     if (ret)
@@ -890,7 +1449,7 @@ static ssize_t eim_dmode_store(struct device *dev, struct device_attribute *attr
 
 	eim_dmode = simple_strtoul(buf, NULL, 10);
     eim_dmode = eim_dmode <DOWNLOAD_PROGRAM ? DOWNLOAD_PROGRAM : eim_dmode;
-	eim_dmode = eim_dmode > DOWNLOAD_PARAMETERS ? DOWNLOAD_PARAMETERS : eim_dmode;
+	eim_dmode = eim_dmode > DOWNLOAD_PROGRAM_8BIT ? DOWNLOAD_PROGRAM_8BIT : eim_dmode;
 
 	mutex_lock(&mdev->eim_mutex_lock);
     mdev->eim_dmode = eim_dmode;
@@ -1023,6 +1582,57 @@ static bool dma_m2m_filter(struct dma_chan *chan, void *param)
 	return true;
 }
 
+// ------------------------------------------------------------
+// Description :
+// 	   This function finds the smallest read SDMA does faster than the
+//     CPU copy. It reads the EIM window into ring slot 0 at load, only
+//     with dma_calibrate = 1.
+// Parameters :
+//	   None.
+// Return Value :
+//	   the cutoff in bytes (EIM_CUTOFF_CPU_ONLY - SDMA never wins)
+// Errors :
+//     None.
+// ------------------------------------------------------------
+static int eim_read_calibrate(void)
+{
+	int cutoff = EIM_CUTOFF_CPU_ONLY;
+	int size = 0;
+	int i = 0;
+
+	for (size = EIM_CAL_MIN; size <= SDMA_M2M_UNIT; size <<= 1)
+	{
+		ktime_t start;
+		s64 cpu_ns = 0;
+		s64 dma_ns = 0;
+
+		start = ktime_get();
+		for (i = 0; i < EIM_CAL_LOOPS; i++)
+		{
+			eim_read_cpu(0, size);
+		}
+		cpu_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		start = ktime_get();
+		for (i = 0; i < EIM_CAL_LOOPS; i++)
+		{
+			if (eim_read_dma(0, size, 0))
+			{
+				return cutoff;
+			}
+		}
+		dma_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+		if (dma_ns < cpu_ns)
+		{
+			cutoff = size;
+			break;
+		}
+	}
+
+	return cutoff;
+}
+
 // ------------------------------------------------------------
 // Description :
 // 	   EIM initialization.
@@ -1052,7 +1662,7 @@ static int __init eim_init(void)
 	dma_cap_zero(dma_m2m_mask);
 	dma_cap_set(DMA_SLAVE, dma_m2m_mask);
 	m2m_dma_data.peripheral_type = IMX_DMATYPE_MEMORY;
-	m2m_dma_data.priority = DMA_PRIO_HIGH;
+	m2m_dma_data.priority = clamp(dma_prio, DMA_PRIO_HIGH, DMA_PRIO_LOW);
 
 	// allocate memory for eim device
 	// kzalloc() is equivalent to kmalloc() and memset()
@@ -1109,14 +1719,6 @@ static int __init eim_init(void)
 	mdev->dma_m2m_config.dst_addr_width = DMA_SLAVE_BUSWIDTH_1_BYTE;
 	dmaengine_slave_config(mdev->dma_m2m_chan, &mdev->dma_m2m_config);
 
-	// initiate 1KB write buffer
-	mdev->dma_wbuf = kzalloc(SDMA_M2M_RBUF, GFP_KERNEL);						//
-	if (!mdev->dma_wbuf)														//
-	{
-		printk(KERN_ERR "< eim.c > eim_init : kzalloc dma_wbuf failed.\n");
-		goto kfree_dma_wbuf;
-	}																			//
-
 	// initiate 16KB read buffer
 	mdev->dma_rbuf = kzalloc(SDMA_M2M_RBUF, GFP_DMA);
 	if (!mdev->dma_rbuf)
@@ -1125,6 +1727,10 @@ static int __init eim_init(void)
 		goto kfree_dma_rbuf;
 	}
 
+	// map the ring once, the CPU side is synchronised by eim_ioctl
+	// SDMA and the CPU copies both fill the ring, so it is mapped both ways
+	mdev->dma_rbuf_dma = dma_map_single(NULL, mdev->dma_rbuf, SDMA_M2M_RBUF, DMA_BIDIRECTIONAL);
+
 	// create directory '/sys/class/eim/'
     mdev->eim_class = class_create(THIS_MODULE, DEVICE_NAME);
     if (!mdev->eim_class)
@@ -1211,6 +1817,14 @@ static int __init eim_init(void)
     SET_DAT6_PUSHPULL();
     SET_DAT7_PUSHPULL();
 
+	// CPU / SDMA read cutoff (the window is readable from here on)
+	// calibration reads the FPGA, so it runs only when asked for
+	if (dma_cutoff < 0)
+	{
+		dma_cutoff = dma_calibrate ? eim_read_calibrate() : EIM_CUTOFF_DEFAULT;
+	}
+	printk(KERN_INFO "< eim.c > eim_init : SDMA reads from %d bytes.\n", dma_cutoff);
+
 #if DEBUG == 1
 	printk(KERN_INFO "eim init.\n");
 #endif
@@ -1225,13 +1839,11 @@ destroy_device :
 
 destroy_class :
 	class_destroy(mdev->eim_class);
+	dma_unmap_single(NULL, mdev->dma_rbuf_dma, SDMA_M2M_RBUF, DMA_BIDIRECTIONAL);
 
 kfree_dma_rbuf :
 	kfree(mdev->dma_rbuf);
 
-kfree_dma_wbuf :
-	kfree(mdev->dma_wbuf);						//
-
 delete_cdev :
 	cdev_del(mdev->cdev);
 
@@ -1281,16 +1893,12 @@ static void __exit eim_exit(void)
 
 		if (mdev->dma_rbuf)
 		{
+			dma_unmap_single(NULL, mdev->dma_rbuf_dma, SDMA_M2M_RBUF, DMA_BIDIRECTIONAL);
 			kfree(mdev->dma_rbuf);
 			mdev->dma_rbuf = NULL;
 		}
 
 
-		if (mdev->dma_wbuf)
-		{
-			kfree(mdev->dma_wbuf);
-			mdev->dma_wbuf = NULL;
-		}
 
         if (mdev->devno)
         {
@@ -1322,5 +1930,5 @@ module_exit(eim_exit);
 
 MODULE_AUTHOR("Young");
 MODULE_LICENSE("GPL");
-MODULE_VERSION("1.3");
+MODULE_VERSION("2.2");
 MODULE_DESCRIPTION("Freescale i.MX6 EIM port Module");
@@ -0,0 +1,142 @@
+// eim_deint_bench.cpp
+// channel deinterleave : CPU after eim_acquire against EIM_IOC_DEINTERLEAVE
+// (driver CPU engine and SDMA engine), 16-bit words interleaved word by word
+// the three outputs are compared first (the FPGA data must not change meanwhile)
+// ./eim_deint_bench             - 4 channels, 4096 loops of one 1KB slot
+// ./eim_deint_bench 8 10000     - 8 channels, 10000 loops
+
+#include "libeim.h"
+
+#include <sys/time.h>
+
+#define ELEM_SIZE   (2)
+
+static const char *engine_names[] = {
+    "driver auto",
+    "driver CPU",
+    "driver SDMA",
+};
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+// deinterleave one slot in user space, channel after channel
+static void deinterleave(unsigned short *out, const unsigned short *in, int channels, int count)
+{
+    for (int c = 0; c < channels; c++)
+    {
+        for (int j = 0; j < count; j++)
+        {
+            out[c * count + j] = in[j * channels + c];
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int channels = 4;
+    int loops = 4096;
+    int count = 0;
+    int len = 0;
+    unsigned short ref[SDMA_M2M_UNIT / ELEM_SIZE];
+    struct timeval tstart, tend;
+    const unsigned char *slot = NULL;
+    long us = 0;
+
+    if (argc >= 2)
+    {
+        channels = atoi(argv[1]);
+    }
+    if (argc >= 3)
+    {
+        loops = atoi(argv[2]);
+    }
+    loops = loops < 1 ? 1 : loops;
+    if ((channels <= 0) || (channels > SDMA_M2M_UNIT / ELEM_SIZE))
+    {
+        printf("input error : the channels must be 1 - %d.\n", SDMA_M2M_UNIT / ELEM_SIZE);
+        return -1;
+    }
+    count = SDMA_M2M_UNIT / ELEM_SIZE / channels;
+    len = channels * count * ELEM_SIZE;
+
+    eim my_eim;
+    if (my_eim.eim_init(len, len) < 0)
+    {
+        return -1;
+    }
+
+    printf("------------------------------------\n");
+    printf("eim deinterleave : %d channels x %d words, %d loops.\n", channels, count, loops);
+    printf("------------------------------------\n");
+
+    // reference : read the interleaved slot, deinterleave on the CPU
+    gettimeofday(&tstart, NULL);
+    for (int i = 0; i < loops; i++)
+    {
+        slot = my_eim.eim_acquire();
+        if (NULL == slot)
+        {
+            return -1;
+        }
+        deinterleave(ref, (const unsigned short *)slot, channels, count);
+        my_eim.eim_release();
+    }
+    gettimeofday(&tend, NULL);
+    us = elapsed_us(&tstart, &tend);
+    printf("%-14s : %8.2f MB/s, %6.2f us per slot\n", "read + CPU",
+            us ? (float)len * loops / us * 1000000 / 1024 / 1024 : 0, (float)us / loops);
+
+    for (int engine = EIM_ENGINE_AUTO; engine <= EIM_ENGINE_DMA; engine++)
+    {
+        struct eim_deinterleave req;
+        const char *check = "identical";
+
+        memset(&req, 0, sizeof(req));
+        req.elem_size = ELEM_SIZE;
+        req.stride = channels * ELEM_SIZE;
+        req.channels = channels;
+        req.count = count;
+        req.engine = engine;
+
+        // same data, both paths must give the same bytes
+        slot = my_eim.eim_acquire();
+        if (NULL == slot)
+        {
+            return -1;
+        }
+        deinterleave(ref, (const unsigned short *)slot, channels, count);
+        my_eim.eim_release();
+        slot = my_eim.eim_acquire_deinterleave(&req);
+        if (NULL == slot)
+        {
+            return -1;
+        }
+        if (memcmp(ref, slot, len))
+        {
+            check = "differs";
+        }
+        my_eim.eim_release();
+
+        gettimeofday(&tstart, NULL);
+        for (int i = 0; i < loops; i++)
+        {
+            slot = my_eim.eim_acquire_deinterleave(&req);
+            if (NULL == slot)
+            {
+                return -1;
+            }
+            my_eim.eim_release();
+        }
+        gettimeofday(&tend, NULL);
+        us = elapsed_us(&tstart, &tend);
+        printf("%-14s : %8.2f MB/s, %6.2f us per slot, output %s\n", engine_names[engine],
+                us ? (float)len * loops / us * 1000000 / 1024 / 1024 : 0, (float)us / loops, check);
+    }
+    printf("------------------------------------\n");
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+// NAME : eim ioctl interface
+// FUNC : ioctl commands and structures shared by eim.c and libeim
+// DATE : 2026.10.19
+// HIST : V1.0 2026.10.19 - cacheable ring and slot sync
+//        V1.1 2026.10.19 - CPU / SDMA read cutoff and engine counters
+//        V1.2 2026.10.19 - busy-poll completion budget
+//        V1.3 2026.10.19 - strided deinterleave request
+//        V1.4 2026.10.19 - packed x16 program download contract
+//        V1.5 2026.10.19 - 8-bit port program download
+//        V1.6 2026.10.19 - program session
+//        V1.7 2026.10.19 - packed marker on DA[15], program window, 0xFF pad
+
+#ifndef _EIM_IOCTL_H_
+#define _EIM_IOCTL_H_
+
+#ifdef __KERNEL__
+#include <linux/ioctl.h>
+#else
+#include <sys/ioctl.h>
+#endif
+
+// download modes ('/sys/class/eim/eim/dmode')
+#define EIM_DMODE_PROGRAM           (1)     // one RBF byte per 16-bit word, D[15:8] zero
+#define EIM_DMODE_PARAMETERS        (2)     // front-end parameters
+#define EIM_DMODE_PROGRAM_PACKED    (3)     // two RBF bytes per 16-bit word
+#define EIM_DMODE_PROGRAM_8BIT      (4)     // one RBF byte per cycle of an 8-bit port
+
+// 8-bit program download : write() switches the CS to an 8-bit port on
+// DATA[7:0] (CS1GCR1.DSZ) for the download and back to 16 bits afterwards,
+// the RBF is written unchanged and the FPGA sees one byte per bus cycle on
+// D[7:0] as in EIM_DMODE_PROGRAM, D[15:8] is not driven
+
+// packed program download, FPGA side contract :
+// - only DA[15:0] reach the FPGA and the 16-bit port shifts the address
+//   (AUS = 0), so byte offset 0x10000 of the EIM window drives DA[15]
+// - every program write() goes in EIM_PROGRAM_WINDOW pieces, each stored
+//   from the start of its window again : EIM_DMODE_PROGRAM_PACKED from
+//   EIM_PACKED_OFFSET (DA[15] high on every word), EIM_DMODE_PROGRAM and
+//   EIM_DMODE_PROGRAM_8BIT from 0 (DA[15] low on every word)
+// - a word with DA[15] high carries RBF byte 2n on D[7:0] and byte 2n + 1 on
+//   D[15:8], the FPGA clocks D[7:0] into FPP first and D[15:8] second
+//   (or feeds both to an FPP x16 port)
+// - the length is even, an odd RBF is padded with one 0xFF byte, which the
+//   FPGA ignores after CONF_DONE like any other trailing DCLK cycle
+// - nCONFIG / nSTATUS / CONF_DONE are handled by the driver as in
+//   EIM_DMODE_PROGRAM
+#define EIM_PACKED_OFFSET           (0x10000)
+#define EIM_PROGRAM_WINDOW          (0x8000)
+#define EIM_PACKED_PAD              (0xFF)
+
+// Ring Buffer (one read() fills one slot)
+#define SDMA_RBUF_CNT			(16)
+#define SDMA_M2M_UNIT			(1024)
+#define SDMA_M2M_RBUF			(SDMA_RBUF_CNT * SDMA_M2M_UNIT)
+
+// mmap cache attributes of the ring, selected by the mmap offset :
+// mmap(NULL, SDMA_M2M_RBUF, PROT_READ, MAP_SHARED, fd, EIM_RING_OFFSET(mode))
+// offset 0 stays the noncached ring of V1.3, the cacheable one is opt-in
+#define EIM_RING_NONCACHED      (0)     // noncached, as before V1.4
+#define EIM_RING_CACHED         (1)     // cacheable, needs the sync ioctls around every slot
+#define EIM_RING_MODE_CNT       (2)
+#define EIM_RING_MODE_SHIFT     (28)
+#define EIM_RING_OFFSET(mode)   ((long)(mode) << EIM_RING_MODE_SHIFT)
+
+// ring range to be synchronised
+struct eim_ring_sync
+{
+    unsigned int offset;        // bytes from the ring start
+    unsigned int len;           // bytes
+};
+
+// read engine (EIM_IOC_GET_CONFIG / EIM_IOC_SET_CONFIG)
+// dma_cutoff : smallest read in bytes carried by SDMA, smaller ones are CPU copies
+//              GET : the current cutoff (EIM_CUTOFF_CPU_ONLY : SDMA never used)
+//              SET : 0 keeps the current cutoff, < 0 selects CPU copies only
+struct eim_config
+{
+    int dma_cutoff;
+};
+
+#define EIM_CUTOFF_CPU_ONLY     (0x7FFFFFFF)
+
+// reads and bytes carried by each copy engine
+struct eim_engine_stats
+{
+    unsigned int cpu_reads;
+    unsigned int dma_reads;
+    unsigned long long cpu_read_bytes;
+    unsigned long long dma_read_bytes;
+};
+
+// ioctl commands
+// SYNC_FOR_CPU : after read() returns, before the CPU reads the slot (invalidate)
+// SYNC_FOR_DEVICE : when the CPU is done with the slot, before SDMA refills it
+#define EIM_IOC_MAGIC           'E'
+#define EIM_IOC_SYNC_FOR_CPU    _IOW(EIM_IOC_MAGIC, 1, struct eim_ring_sync)
+#define EIM_IOC_SYNC_FOR_DEVICE _IOW(EIM_IOC_MAGIC, 2, struct eim_ring_sync)
+#define EIM_IOC_GET_CONFIG      _IOR(EIM_IOC_MAGIC, 3, struct eim_config)
+#define EIM_IOC_SET_CONFIG      _IOW(EIM_IOC_MAGIC, 4, struct eim_config)
+#define EIM_IOC_GET_ENGINE_STATS _IOR(EIM_IOC_MAGIC, 5, struct eim_engine_stats)
+// SET_POLL : busy-poll budget of the following SDMA reads on this file, in
+//            microseconds (argument by value, 0 : sleep until the SDMA interrupt,
+//            at most EIM_POLL_MAX_US), read() sleeps once the budget runs out
+#define EIM_IOC_SET_POLL        _IO(EIM_IOC_MAGIC, 6)
+
+#define EIM_POLL_MAX_US         (1000)
+
+// strided gather of interleaved channels into the next slot (EIM_IOC_DEINTERLEAVE)
+// element j of channel c is read at window offset c * elem_size + j * stride and
+// written at slot offset (c * count + j) * elem_size, every channel lands
+// contiguously; channels * count * elem_size is at most SDMA_M2M_UNIT
+// the slot is used like one filled by read() (sync ioctls, then the next slot)
+struct eim_deinterleave
+{
+    unsigned int elem_size;     // 1, 2 or 4 bytes
+    unsigned int stride;        // bytes between two elements of a channel, multiple of elem_size
+    unsigned int channels;
+    unsigned int count;         // elements per channel
+    int engine;                 // EIM_ENGINE_AUTO / EIM_ENGINE_CPU / EIM_ENGINE_DMA
+    unsigned int offset;        // returned : byte offset of the slot in the ring
+};
+
+#define EIM_ENGINE_AUTO         (0)     // dma_cutoff decides on the output bytes
+#define EIM_ENGINE_CPU          (1)
+#define EIM_ENGINE_DMA          (2)
+
+#define EIM_IOC_DEINTERLEAVE    _IOWR(EIM_IOC_MAGIC, 7, struct eim_deinterleave)
+
+// program session : PROGRAM_BEGIN pulses nCONFIG, the following writes of a
+// program dmode feed the same configuration without a new pulse (each one is
+// clocked from the start of the window like any write, the FPGA takes the
+// bitstream in order), and PROGRAM_END checks CONF_DONE (-EIO if low), for
+// programs produced piece by piece (a decompressor) ; a write outside a
+// session is a whole program
+#define EIM_IOC_PROGRAM_BEGIN   _IO(EIM_IOC_MAGIC, 8)
+#define EIM_IOC_PROGRAM_END     _IO(EIM_IOC_MAGIC, 9)
+
+#endif
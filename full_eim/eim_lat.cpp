@@ -0,0 +1,114 @@
+// eim_lat.cpp
+// SDMA read latency percentiles, sleeping completion against busy-poll completion
+// each sample : eim_acquire (read() + slot sync) and eim_release of 64 / 128 / 256 / 512 bytes,
+//               the read cutoff is lowered to 1 byte so every read goes through SDMA
+// ./eim_lat                     - 10000 samples per size and mode, 50 us poll budget
+// ./eim_lat 20000 100           - 20000 samples, 100 us poll budget
+
+#include "libeim.h"
+
+#include <time.h>
+
+static const int sizes[] = {64, 128, 256, 512};
+
+// nanoseconds of the monotonic clock
+static long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+
+    return (x > y) - (x < y);
+}
+
+// value at percentile p of sorted samples
+static long long percentile(const long long *lat, int n, double p)
+{
+    int i = (int)(p / 100 * (n - 1) + 0.5);
+
+    return lat[i];
+}
+
+int main(int argc, char **argv)
+{
+    long long *lat = NULL;
+    int samples = 10000;
+    int budget = 50;
+    int cutoff = 0;
+
+    if (argc >= 2)
+    {
+        samples = atoi(argv[1]);
+    }
+    if (argc >= 3)
+    {
+        budget = atoi(argv[2]);
+    }
+    samples = samples < 1 ? 1 : samples;
+    if ((budget < 1) || (budget > EIM_POLL_MAX_US))
+    {
+        printf("input error : the poll budget must be 1 - %d us.\n", EIM_POLL_MAX_US);
+        return -1;
+    }
+
+    lat = new long long[samples];
+
+    // the cutoff is module wide, one handle holds and restores it
+    eim ctl_eim;
+    if (ctl_eim.eim_init(SDMA_M2M_UNIT, SDMA_M2M_UNIT) < 0)
+    {
+        delete [] lat;
+        return -1;
+    }
+    cutoff = ctl_eim.eim_get_dma_cutoff();
+    ctl_eim.eim_set_dma_cutoff(1);
+
+    printf("------------------------------------\n");
+    printf("eim SDMA read latency : %d samples, poll budget %d us.\n", samples, budget);
+    printf("%5s %-6s %9s %9s %9s %9s %9s  (us)\n", "bytes", "mode", "p50", "p90", "p99", "p99.9", "max");
+    printf("------------------------------------\n");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+    {
+        eim my_eim;
+        if (my_eim.eim_init(sizes[s], sizes[s]) < 0)
+        {
+            break;
+        }
+
+        for (int poll = 0; poll < 2; poll++)
+        {
+            if (my_eim.eim_set_poll(poll ? budget : 0) < 0)
+            {
+                break;
+            }
+
+            for (int i = 0; i < samples; i++)
+            {
+                long long start = now_ns();
+                my_eim.eim_acquire();
+                my_eim.eim_release();
+                lat[i] = now_ns() - start;
+            }
+            qsort(lat, samples, sizeof(long long), cmp_ll);
+
+            printf("%5d %-6s %9.2f %9.2f %9.2f %9.2f %9.2f\n", sizes[s], poll ? "poll" : "sleep",
+                    percentile(lat, samples, 50) / 1000.0, percentile(lat, samples, 90) / 1000.0,
+                    percentile(lat, samples, 99) / 1000.0, percentile(lat, samples, 99.9) / 1000.0,
+                    lat[samples - 1] / 1000.0);
+        }
+    }
+    printf("------------------------------------\n");
+
+    // restore driver settings
+    ctl_eim.eim_set_dma_cutoff(cutoff);
+    delete [] lat;
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+// eim_ring_bench.cpp
+// Ring Buffer consumer throughput, noncached mapping against cacheable mapping
+// each loop : eim_write, eim_acquire (read() + slot sync), checksum the slot, eim_release
+// checksum MB/s is the slot walk alone, loop MB/s includes read() and the sync ioctls
+// ./eim_ring_bench              - 4096 loops of 1KB per mapping
+// ./eim_ring_bench 10000 480    - 10000 loops of 480 bytes per mapping
+
+#include "libeim.h"
+
+#include <sys/time.h>
+
+static const char *mode_names[EIM_RING_MODE_CNT] = {
+    "noncached",
+    "cached + sync",
+};
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+int main(int argc, char **argv)
+{
+    int loops = 4096;
+    int len = SDMA_M2M_UNIT;
+
+    if (argc >= 2)
+    {
+        loops = atoi(argv[1]);
+    }
+    if (argc >= 3)
+    {
+        len = atoi(argv[2]);
+    }
+    loops = loops < 1 ? 1 : loops;
+    if ((len <= 0) || (len > SDMA_M2M_UNIT))
+    {
+        printf("input error : the length must be 1 - %d.\n", SDMA_M2M_UNIT);
+        return -1;
+    }
+
+    eim my_eim;
+    if (my_eim.eim_init(len, len) < 0)
+    {
+        return -1;
+    }
+
+    printf("------------------------------------\n");
+    printf("eim ring : %d loops of %d bytes per mapping.\n", loops, len);
+    printf("------------------------------------\n");
+    // cached first, the library default (noncached) is left behind
+    for (int mode = EIM_RING_MODE_CNT - 1; mode >= 0; mode--)
+    {
+        struct timeval tstart, tend;
+        long total_us = 0;
+        long sum_us = 0;
+        int errors = 0;
+
+        if (my_eim.eim_set_ring_mode(mode) < 0)
+        {
+            printf("%-20s : mmap failed.\n", mode_names[mode]);
+            continue;
+        }
+
+        gettimeofday(&tstart, NULL);
+        for (int cnt = 0; cnt < loops; cnt++)
+        {
+            const unsigned char *slot = NULL;
+            struct timeval sstart, send;
+            unsigned int sum = 0;
+            unsigned int expect = 0;
+
+            // the parameter pattern is (i + n) % 256
+            my_eim.eim_write();
+            slot = my_eim.eim_acquire();
+            if (NULL == slot)
+            {
+                errors++;
+                continue;
+            }
+
+            gettimeofday(&sstart, NULL);
+            for (int i = 0; i < len; i++)
+            {
+                sum += slot[i];
+            }
+            gettimeofday(&send, NULL);
+            sum_us += elapsed_us(&sstart, &send);
+
+            for (int i = 0; i < len; i++)
+            {
+                expect += (slot[0] + i) % 256;
+            }
+            if (sum != expect)
+            {
+                errors++;
+            }
+            my_eim.eim_release();
+        }
+        gettimeofday(&tend, NULL);
+        total_us = elapsed_us(&tstart, &tend);
+
+        printf("%-20s : checksum %8.2f MB/s, loop %8.2f MB/s, %d errors\n", mode_names[mode],
+                sum_us ? (float)len * loops / sum_us * 1000000 / 1024 / 1024 : 0,
+                total_us ? (float)len * loops / total_us * 1000000 / 1024 / 1024 : 0,
+                errors);
+    }
+    printf("------------------------------------\n");
+    {
+        struct eim_engine_stats stats;
+
+        if (0 == my_eim.eim_get_engine_stats(&stats))
+        {
+            printf("read cutoff %d bytes : CPU %u reads %llu bytes, SDMA %u reads %llu bytes\n",
+                    my_eim.eim_get_dma_cutoff(), stats.cpu_reads, stats.cpu_read_bytes,
+                    stats.dma_reads, stats.dma_read_bytes);
+            printf("------------------------------------\n");
+        }
+    }
+
+    return 0;
+}
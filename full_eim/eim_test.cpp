@@ -16,14 +16,20 @@ int main(int argc, char **argv)
     eim my_eim;
     my_eim.eim_init(LEN, LEN);
 
-    if ('1' == *argv[1])
+    if (('1' == *argv[1]) || ('3' == *argv[1]) || ('4' == *argv[1]))
     {
         struct timeval wtstart, wtend;
         long wtuse = 0;
         int ret = 0;
 
+        // 1 - one byte per word, 3 - packed, two bytes per word, 4 - 8-bit port
         gettimeofday(&wtstart, NULL);
-        ret = my_eim.eim_write16();
+        if ('3' == *argv[1])
+            ret = my_eim.eim_write16_packed();
+        else if ('4' == *argv[1])
+            ret = my_eim.eim_write8_program();
+        else
+            ret = my_eim.eim_write16();
         gettimeofday(&wtend, NULL);
         wtuse = 1000000 * (wtend.tv_sec - wtstart.tv_sec) + (wtend.tv_usec - wtstart.tv_usec);
 
@@ -39,6 +45,31 @@ int main(int argc, char **argv)
             printf("Configure FPGA fails.\n");
         }
     }
+    else if (('5' == *argv[1]) || ('6' == *argv[1]))
+    {
+        struct timeval wtstart, wtend;
+        long wtuse = 0;
+        int ret = 0;
+
+        // 5 - 8-bit port straight from the mapped RBF
+        // 6 - 8-bit port from the RBZ1 file, decompressed while it is written
+        gettimeofday(&wtstart, NULL);
+        ret = my_eim.eim_write_program(('6' == *argv[1]) ? "./fpga_ram.rbz" : "./fpga_ram.rbf", EIM_DOWNLOAD_PROGRAM8);
+        gettimeofday(&wtend, NULL);
+        wtuse = 1000000 * (wtend.tv_sec - wtstart.tv_sec) + (wtend.tv_usec - wtstart.tv_usec);
+
+        if (0 == ret)
+        {
+            printf("Configure FPGA from the %s succeeds.\n", ('6' == *argv[1]) ? "compressed RBF" : "mapped RBF");
+            printf("------------------------------------\n");
+            printf("The time of FPGA configuration : %0.2f s.\n", (float)wtuse / 1000000); 
+            printf("------------------------------------\n");
+        }
+        else
+        {
+            printf("Configure FPGA fails.\n");
+        }
+    }
     else if ('2' == *argv[1])
     {
         unsigned char rbuf[LEN];
@@ -72,7 +103,7 @@ int main(int argc, char **argv)
     }
     else
     {
-        printf("input error : the second argument must be 1 or 2.\n");
+        printf("input error : the second argument must be 1 - 6.\n");
         return -1;
     }
 
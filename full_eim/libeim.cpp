@@ -26,6 +26,8 @@ eim::eim()
 	m_widx = 0;
     m_data_rbuf = NULL;
 	m_rbuf_idx = 0;
+	m_slot_len = 0;
+	m_ring_mode = EIM_RING_NONCACHED;
     m_data_rbuf16 = NULL;
 }
 
@@ -42,9 +44,14 @@ eim::eim()
 eim::~eim()
 {
     // release resources
+	if (m_fpga_wbuf)
+	{
+    	delete [] m_fpga_wbuf;
+		m_fpga_wbuf = NULL;
+	}
 	if (m_para_wbuf)
 	{
-    	free(m_para_wbuf);
+    	delete [] m_para_wbuf;
 		m_para_wbuf = NULL;
 	}
 	if (m_data_rbuf)
@@ -54,8 +61,8 @@ eim::~eim()
 	}
 	if (m_data_rbuf16)
 	{
-		free(m_data_rbuf16);
-		m_data_rbuf = NULL;
+		delete [] m_data_rbuf16;
+		m_data_rbuf16 = NULL;
 	}
 
     // close file
@@ -100,6 +107,8 @@ int eim::eim_init(int paralength, int datalength)
     m_MUM = eim_get_mum();
     m_BCD = eim_get_bcd();
     m_WWSC = eim_get_wwsc();
+
+    return 0;
 }
 
 // ------------------------------------------------------------
@@ -162,16 +171,11 @@ int eim::eim_write(void)
 // ------------------------------------------------------------
 int eim::eim_write16(void)
 {
-    // open FPGA program file
-    FILE *fp = NULL;
-	fp = fopen(m_fpgafile_addr, "rb");
-    if (NULL == fp)
+    // read FPGA program file
+    if (eim_read_program())
     {
-        cout<<"< libeim.cpp > eim_write16 : fopen failed."<<endl;
         return -1;
     }
-	fread(m_fpga_wbuf, sizeof(unsigned char), m_fpgalength, fp);
-    fclose(fp);
     
     // check dmode / MUM / WWSC
     if (EIM_DOWNLOAD_PROGRAM != m_dmode)
@@ -191,6 +195,11 @@ int eim::eim_write16(void)
     }
 
     // convert 8-bit to 16-bit
+    if (NULL == m_fpga_wbuf16)
+    {
+        m_fpga_wbuf16 = new unsigned char[m_fpgalength * 2];
+        memset(m_fpga_wbuf16, 0, sizeof(unsigned char) * m_fpgalength * 2);
+    }
     char2short(EIM_W_TYPE, EIM_LITTLE_ENDIAN);
 
     // download FPGA program
@@ -205,18 +214,452 @@ int eim::eim_write16(void)
     // release resources
 	if (m_fpga_wbuf)
 	{
-    	free(m_fpga_wbuf);
+    	delete [] m_fpga_wbuf;
 		m_fpga_wbuf = NULL;
 	}
 	if (m_fpga_wbuf16)
 	{
-    	free(m_fpga_wbuf16);
+    	delete [] m_fpga_wbuf16;
 		m_fpga_wbuf16 = NULL;
 	}
 
     return 0;
 }
 
+// ------------------------------------------------------------
+// Description :
+// 	   This function reads the FPGA program file into m_fpga_wbuf, the
+//     buffer (m_fpgalength + 1 bytes) is allocated again when a previous
+//     eim_write16 released it.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_read_program success.
+//    -1 - eim_read_program failure.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+int eim::eim_read_program(void)
+{
+    if (NULL == m_fpga_wbuf)
+    {
+        m_fpga_wbuf = new unsigned char[m_fpgalength + 1];
+        memset(m_fpga_wbuf, 0, sizeof(unsigned char) * (m_fpgalength + 1));
+    }
+
+    // open FPGA program file
+    FILE *fp = NULL;
+	fp = fopen(m_fpgafile_addr, "rb");
+    if (NULL == fp)
+    {
+        cout<<"< libeim.cpp > eim_read_program : fopen failed."<<endl;
+        return -1;
+    }
+    if (fread(m_fpga_wbuf, sizeof(unsigned char), m_fpgalength, fp) != (size_t)m_fpgalength)
+    {
+        cout<<"< libeim.cpp > eim_read_program : fread failed."<<endl;
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes the FPGA program packed, two RBF bytes per
+//     16-bit word (EIM_DMODE_PROGRAM_PACKED), the RBF is downloaded as
+//     read from the file.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_write16_packed success.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+int eim::eim_write16_packed(void)
+{
+    // read FPGA program file
+    if (eim_read_program())
+    {
+        return -1;
+    }
+
+    // the words carry two bytes, an odd RBF gets one pad byte
+    int len = 0;
+    len = (m_fpgalength + 1) & ~1;
+    if (len != m_fpgalength)
+    {
+        m_fpga_wbuf[m_fpgalength] = EIM_PACKED_PAD;
+    }
+    
+    // check dmode / MUM / WWSC
+    if (EIM_DOWNLOAD_PACKED != m_dmode)
+    {
+        eim_set_dmode(EIM_DOWNLOAD_PACKED);
+		m_dmode = EIM_DOWNLOAD_PACKED;
+    }
+    if (EIM_NOMUX != m_MUM)
+    {
+        eim_set_mum(EIM_NOMUX);
+		m_MUM = EIM_NOMUX;
+    }
+    if (EIM_WWSC_4CLKs != m_WWSC)
+    {
+        eim_set_wwsc(EIM_WWSC_4CLKs);
+		m_WWSC = EIM_WWSC_4CLKs;
+    }
+
+    // download FPGA program
+    int wcnt = 0;
+    wcnt = write(m_eim_fd, (void *)m_fpga_wbuf, len);
+    if (wcnt != len) 
+    {
+        cout<<"< libeim.cpp > eim_write16_packed : write failed."<<endl;;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes the FPGA program on an 8-bit port
+//     (EIM_DMODE_PROGRAM_8BIT), the RBF is downloaded as read from the file.
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_write8_program success.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+int eim::eim_write8_program(void)
+{
+    // read FPGA program file
+    if (eim_read_program())
+    {
+        return -1;
+    }
+    
+    // check dmode / MUM / WWSC
+    if (EIM_DOWNLOAD_PROGRAM8 != m_dmode)
+    {
+        eim_set_dmode(EIM_DOWNLOAD_PROGRAM8);
+		m_dmode = EIM_DOWNLOAD_PROGRAM8;
+    }
+    if (EIM_NOMUX != m_MUM)
+    {
+        eim_set_mum(EIM_NOMUX);
+		m_MUM = EIM_NOMUX;
+    }
+    if (EIM_WWSC_4CLKs != m_WWSC)
+    {
+        eim_set_wwsc(EIM_WWSC_4CLKs);
+		m_WWSC = EIM_WWSC_4CLKs;
+    }
+
+    // download FPGA program
+    int wcnt = 0;
+    wcnt = write(m_eim_fd, (void *)m_fpga_wbuf, m_fpgalength);
+    if (wcnt != m_fpgalength) 
+    {
+        cout<<"< libeim.cpp > eim_write8_program : write failed."<<endl;;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function switches dmode / MUM / WWSC to a program download.
+// Parameters :
+//     dmode - EIM_DOWNLOAD_PROGRAM / EIM_DOWNLOAD_PACKED / EIM_DOWNLOAD_PROGRAM8
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+void eim::eim_program_mode(int dmode)
+{
+    if (dmode != m_dmode)
+    {
+        eim_set_dmode(dmode);
+		m_dmode = dmode;
+    }
+    if (EIM_NOMUX != m_MUM)
+    {
+        eim_set_mum(EIM_NOMUX);
+		m_MUM = EIM_NOMUX;
+    }
+    if (EIM_WWSC_4CLKs != m_WWSC)
+    {
+        eim_set_wwsc(EIM_WWSC_4CLKs);
+		m_WWSC = EIM_WWSC_4CLKs;
+    }
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes the FPGA program from the RBF file at path
+//     (see eim_write_program_fd).
+// Parameters :
+//     path - RBF file
+//     dmode - EIM_DOWNLOAD_PROGRAM8 / EIM_DOWNLOAD_PACKED / EIM_DOWNLOAD_PROGRAM
+// Return Value :
+//     0 - eim_write_program success.
+// Errors :
+//     -1 - open, mmap or write failed.
+// ------------------------------------------------------------
+int eim::eim_write_program(const char *path, int dmode)
+{
+    int fd = 0;
+    int ret = 0;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        cout<<"< libeim.cpp > eim_write_program : open "<<path<<" failed."<<endl;
+        return -1;
+    }
+    ret = eim_write_program_fd(fd, dmode);
+    close(fd);
+
+    return ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes the FPGA program from a private mapping of
+//     the RBF file fd, the pages go to the driver without a heap copy
+//     (only the last page is copied to pad an odd packed RBF).
+//     The file is read ahead sequentially while the FPGA is clocked, a
+//     page fault only pauses DCLK. EIM_DOWNLOAD_PROGRAM widens the
+//     mapping in RBZ_PIPE_BLOCK pieces within one program session.
+// Parameters :
+//     fd - RBF file opened for reading
+//     dmode - EIM_DOWNLOAD_PROGRAM8 / EIM_DOWNLOAD_PACKED / EIM_DOWNLOAD_PROGRAM
+// Return Value :
+//     0 - eim_write_program_fd success.
+// Errors :
+//     -1 - fstat, mmap or write failed, CONF_DONE is low (widened).
+// ------------------------------------------------------------
+int eim::eim_write_program_fd(int fd, int dmode)
+{
+    struct stat st;
+    unsigned char magic[4] = {0};
+    unsigned char *rbf = NULL;
+    const unsigned char *src = NULL;
+    int len = 0;
+    int wlen = 0;
+    int wcnt = 0;
+    int ret = 0;
+
+    // compressed program
+    if ((sizeof(magic) == pread(fd, magic, sizeof(magic), 0)) && rbz_is_rbz(magic, sizeof(magic)))
+    {
+        return eim_write_program_rbz(fd, dmode);
+    }
+
+    if ((fstat(fd, &st) < 0) || (st.st_size <= 0))
+    {
+        cout<<"< libeim.cpp > eim_write_program_fd : fstat failed."<<endl;
+        return -1;
+    }
+    len = st.st_size;
+
+    rbf = (unsigned char *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == rbf)
+    {
+        cout<<"< libeim.cpp > eim_write_program_fd : mmap failed."<<endl;
+        return -1;
+    }
+    madvise(rbf, len, MADV_SEQUENTIAL);
+    madvise(rbf, len, MADV_WILLNEED);
+
+    src = rbf;
+    wlen = len;
+    if (EIM_DOWNLOAD_PACKED == dmode)
+    {
+        // an odd RBF ends inside its last page, the byte after EOF is the pad
+        wlen = (len + 1) & ~1;
+        if (wlen != len)
+        {
+            rbf[len] = EIM_PACKED_PAD;
+        }
+    }
+    else if (EIM_DOWNLOAD_PROGRAM == dmode)
+    {
+        // one byte per word, widened from the mapping a block at a time
+        delete [] m_fpga_wbuf16;
+        m_fpga_wbuf16 = new unsigned char[RBZ_PIPE_BLOCK * 2];
+        memset(m_fpga_wbuf16, 0, sizeof(unsigned char) * RBZ_PIPE_BLOCK * 2);
+
+        eim_program_mode(dmode);
+        if (ioctl(m_eim_fd, EIM_IOC_PROGRAM_BEGIN) < 0)
+        {
+            cout<<"< libeim.cpp > eim_write_program_fd : nSTATUS failed."<<endl;
+            ret = -1;
+        }
+        for (int pos = 0; (0 == ret) && (pos < len); pos += RBZ_PIPE_BLOCK)
+        {
+            int n = (len - pos < RBZ_PIPE_BLOCK) ? (len - pos) : RBZ_PIPE_BLOCK;
+
+            for (int i = 0; i < n; i++)
+            {
+                m_fpga_wbuf16[2 * i] = rbf[pos + i];
+            }
+            wlen = n * 2;
+            wcnt = write(m_eim_fd, (const void *)m_fpga_wbuf16, wlen);
+            if (wcnt != wlen)
+            {
+                cout<<"< libeim.cpp > eim_write_program_fd : write failed."<<endl;
+                ret = -1;
+            }
+        }
+        munmap(rbf, len);
+        delete [] m_fpga_wbuf16;
+        m_fpga_wbuf16 = NULL;
+
+        // END closes the session in any case, then checks CONF_DONE
+        if ((ioctl(m_eim_fd, EIM_IOC_PROGRAM_END) < 0) && (0 == ret))
+        {
+            cout<<"< libeim.cpp > eim_write_program_fd : CONF_DONE is still low."<<endl;
+            ret = -1;
+        }
+
+        return ret;
+    }
+    else
+    {
+        dmode = EIM_DOWNLOAD_PROGRAM8;
+    }
+
+    // download FPGA program
+    eim_program_mode(dmode);
+    wcnt = write(m_eim_fd, (const void *)src, wlen);
+    munmap(rbf, len);
+    if (wcnt != wlen) 
+    {
+        cout<<"< libeim.cpp > eim_write_program_fd : write failed."<<endl;;
+        return -1;
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function writes an RBZ1 compressed FPGA program. A decode
+//     thread reads and decompresses the file into RBZ_PIPE_BLOCKS blocks
+//     while the previous block is written, all blocks go to the FPGA in
+//     one program session (EIM_IOC_PROGRAM_BEGIN / END).
+// Parameters :
+//     fd - RBZ1 file opened for reading
+//     dmode - EIM_DOWNLOAD_PROGRAM8 / EIM_DOWNLOAD_PACKED / EIM_DOWNLOAD_PROGRAM
+// Return Value :
+//     0 - eim_write_program_rbz success.
+// Errors :
+//     -1 - corrupt file, write failed or CONF_DONE is low.
+// ------------------------------------------------------------
+int eim::eim_write_program_rbz(int fd, int dmode)
+{
+    struct rbz_pipe pipe;
+    FILE *fp = NULL;
+    unsigned char *block = NULL;
+    const unsigned char *src = NULL;
+    size_t len = 0;
+    int wlen = 0;
+    int wcnt = 0;
+    int ret = 0;
+
+    if ((EIM_DOWNLOAD_PACKED != dmode) && (EIM_DOWNLOAD_PROGRAM != dmode))
+    {
+        dmode = EIM_DOWNLOAD_PROGRAM8;
+    }
+    if (EIM_DOWNLOAD_PROGRAM == dmode)
+    {
+        delete [] m_fpga_wbuf16;
+        m_fpga_wbuf16 = new unsigned char[RBZ_PIPE_BLOCK * 2];
+        memset(m_fpga_wbuf16, 0, sizeof(unsigned char) * RBZ_PIPE_BLOCK * 2);
+    }
+
+    fp = fdopen(dup(fd), "rb");
+    if ((NULL == fp) || (0 != fseek(fp, 0, SEEK_SET)) || (rbz_pipe_open(&pipe, fp) < 0))
+    {
+        cout<<"< libeim.cpp > eim_write_program_rbz : open decoder failed."<<endl;
+        if (fp)
+        {
+            fclose(fp);
+        }
+        return -1;
+    }
+
+    eim_program_mode(dmode);
+    if (ioctl(m_eim_fd, EIM_IOC_PROGRAM_BEGIN) < 0)
+    {
+        cout<<"< libeim.cpp > eim_write_program_rbz : nSTATUS failed."<<endl;
+        ret = -1;
+    }
+
+    // download the blocks as they are decoded
+    while ((0 == ret) && (NULL != (block = rbz_pipe_get(&pipe, &len))))
+    {
+        src = block;
+        wlen = len;
+        if (EIM_DOWNLOAD_PACKED == dmode)
+        {
+            // only the last block can be odd, its spare byte is the pad
+            block[len] = EIM_PACKED_PAD;
+            wlen = (len + 1) & ~1;
+        }
+        else if (EIM_DOWNLOAD_PROGRAM == dmode)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                m_fpga_wbuf16[2 * i] = block[i];
+            }
+            src = m_fpga_wbuf16;
+            wlen = len * 2;
+        }
+        while (wlen > 0)
+        {
+            wcnt = write(m_eim_fd, (const void *)src, wlen);
+            if (wcnt <= 0)
+            {
+                cout<<"< libeim.cpp > eim_write_program_rbz : write failed."<<endl;
+                ret = -1;
+                break;
+            }
+            src += wcnt;
+            wlen -= wcnt;
+        }
+        rbz_pipe_put(&pipe);
+    }
+
+    if ((rbz_pipe_close(&pipe) < 0) && (0 == ret))
+    {
+        cout<<"< libeim.cpp > eim_write_program_rbz : corrupt RBZ1 file."<<endl;
+        ret = -1;
+    }
+    fclose(fp);
+    if (EIM_DOWNLOAD_PROGRAM == dmode)
+    {
+        delete [] m_fpga_wbuf16;
+        m_fpga_wbuf16 = NULL;
+    }
+
+    // END closes the session in any case, then checks CONF_DONE
+    if ((ioctl(m_eim_fd, EIM_IOC_PROGRAM_END) < 0) && (0 == ret))
+    {
+        cout<<"< libeim.cpp > eim_write_program_rbz : CONF_DONE is still low."<<endl;
+        ret = -1;
+    }
+
+    return ret;
+}
+
 // ------------------------------------------------------------
 // Description :
 // 	   This function reads 8-bit data from FPGA through eim.
@@ -229,14 +672,20 @@ int eim::eim_write16(void)
 // -------------------------------------------------------------
 int eim::eim_read(unsigned char *buf)
 {
+	const unsigned char *slot = NULL;
+
 	// trigger DMA trasferring from eim_mem_base to dma_rbuf in Kernel Space
-    read(m_eim_fd, NULL, m_datalength);
+	slot = eim_acquire();
+	if (NULL == slot)
+	{
+		return -1;
+	}
 
 	// copy from Ring Buffer to application buffer
-    memcpy(buf, m_data_rbuf + m_rbuf_idx * SDMA_M2M_UNIT, m_datalength);
+    memcpy(buf, slot, m_datalength);
 
-	// add the index of Ring Buffer
-	m_rbuf_idx = (m_rbuf_idx + 1) % SDMA_RBUF_CNT;
+	// give the slot back and add the index of Ring Buffer
+	eim_release();
 
     return 0;
 }
@@ -254,7 +703,10 @@ int eim::eim_read(unsigned char *buf)
 int eim::eim_read16(unsigned char *buf)
 {
 	// trigger DMA trasferring from eim_mem_base to dma_rbuf in Kernel Space
-    read(m_eim_fd, NULL, m_datalength);
+	if (NULL == eim_acquire())
+	{
+		return -1;
+	}
 
 	// convert from 8-bit to 16-bit
     char2short(EIM_R_TYPE, EIM_LITTLE_ENDIAN);
@@ -262,10 +714,280 @@ int eim::eim_read16(unsigned char *buf)
 	// copy from Ring Buffer to application buffer
     memcpy(buf, m_data_rbuf16, m_datalength * 2);
 
+	// give the slot back and add the index of Ring Buffer
+	eim_release();
+
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function uploads m_datalength bytes into the next slot of the
+//     Ring Buffer and hands the slot to the CPU (cached mapping : the slot
+//     range is invalidated by EIM_IOC_SYNC_FOR_CPU).
+// Parameters :
+//     None.
+// Return Value :
+//     the slot address - eim_acquire success.
+//     NULL - no Ring Buffer mapping or read failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+const unsigned char *eim::eim_acquire(void)
+{
+	if (NULL == m_data_rbuf)
+	{
+		return NULL;
+	}
+
+	// trigger DMA trasferring from eim_mem_base to dma_rbuf in Kernel Space
+    if (read(m_eim_fd, NULL, m_datalength) < 0)
+	{
+		cout<<"< libeim.cpp > eim_acquire : read failed."<<endl;
+		return NULL;
+	}
+	m_slot_len = m_datalength;
+
+	if (eim_sync_slot(EIM_IOC_SYNC_FOR_CPU) < 0)
+	{
+		cout<<"< libeim.cpp > eim_acquire : EIM_IOC_SYNC_FOR_CPU failed."<<endl;
+		return NULL;
+	}
+
+    return m_data_rbuf + m_rbuf_idx * SDMA_M2M_UNIT;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gathers interleaved channels of the FPGA data into the
+//     next slot of the Ring Buffer, each channel contiguous, and hands the
+//     slot to the CPU like eim_acquire.
+// Parameters :
+//     req - the strided pattern and engine (req->offset is filled in)
+// Return Value :
+//     the slot address - eim_acquire_deinterleave success.
+//     NULL - no Ring Buffer mapping or ioctl failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+const unsigned char *eim::eim_acquire_deinterleave(struct eim_deinterleave *req)
+{
+	if (NULL == m_data_rbuf)
+	{
+		return NULL;
+	}
+
+    if (ioctl(m_eim_fd, EIM_IOC_DEINTERLEAVE, req) < 0)
+	{
+		cout<<"< libeim.cpp > eim_acquire_deinterleave : ioctl failed."<<endl;
+		return NULL;
+	}
+	m_rbuf_idx = req->offset / SDMA_M2M_UNIT;
+	m_slot_len = req->channels * req->count * req->elem_size;
+
+	if (eim_sync_slot(EIM_IOC_SYNC_FOR_CPU) < 0)
+	{
+		cout<<"< libeim.cpp > eim_acquire_deinterleave : EIM_IOC_SYNC_FOR_CPU failed."<<endl;
+		return NULL;
+	}
+
+    return m_data_rbuf + req->offset;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gives the acquired slot back to SDMA and moves to the
+//     next slot (cached mapping : EIM_IOC_SYNC_FOR_DEVICE).
+// Parameters :
+//     None.
+// Return Value :
+//     0 - eim_release success.
+//     -1 - EIM_IOC_SYNC_FOR_DEVICE failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_release(void)
+{
+	int ret = 0;
+
+	ret = eim_sync_slot(EIM_IOC_SYNC_FOR_DEVICE);
+	if (ret < 0)
+	{
+		cout<<"< libeim.cpp > eim_release : EIM_IOC_SYNC_FOR_DEVICE failed."<<endl;
+	}
+
 	// add the index of Ring Buffer
 	m_rbuf_idx = (m_rbuf_idx + 1) % SDMA_RBUF_CNT;
 
-    return 0;
+    return ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function synchronises the current slot of the Ring Buffer,
+//     only the m_slot_len bytes written by SDMA are touched.
+// Parameters :
+//     cmd - EIM_IOC_SYNC_FOR_CPU / EIM_IOC_SYNC_FOR_DEVICE
+// Return Value :
+//     0 - eim_sync_slot success (or noncached mapping).
+//     -1 - ioctl failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_sync_slot(unsigned long cmd)
+{
+	struct eim_ring_sync sync;
+
+	if (EIM_RING_CACHED != m_ring_mode)
+	{
+		return 0;
+	}
+
+	sync.offset = m_rbuf_idx * SDMA_M2M_UNIT;
+	sync.len = m_slot_len;
+
+	return ioctl(m_eim_fd, cmd, &sync);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function maps the Ring Buffer again with another cache attribute.
+// Parameters :
+//     mode - EIM_RING_NONCACHED (default) or EIM_RING_CACHED
+// Return Value :
+//     0 - eim_set_ring_mode success.
+//     -1 - mmap failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_set_ring_mode(int mode)
+{
+	unsigned char *rbuf = NULL;
+
+    rbuf = (unsigned char *)mmap(NULL, SDMA_M2M_RBUF, PROT_READ, MAP_SHARED, m_eim_fd, EIM_RING_OFFSET(mode));
+    if (rbuf == MAP_FAILED)
+    {
+		cout<<"< libeim.cpp > eim_set_ring_mode : mmap failed."<<endl;
+		return -1;
+    }
+
+	if (m_data_rbuf)
+	{
+		munmap(m_data_rbuf, SDMA_M2M_RBUF);
+	}
+	m_data_rbuf = rbuf;
+	m_ring_mode = mode;
+
+	return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the cache attribute of the Ring Buffer mapping.
+// Parameters :
+//     None.
+// Return Value :
+//     m_ring_mode - EIM_RING_CACHED or EIM_RING_NONCACHED.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_get_ring_mode(void)
+{
+	return m_ring_mode;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function overrides the CPU / SDMA read cutoff measured at load.
+// Parameters :
+//     cutoff - smallest read carried by SDMA (0 keeps it, < 0 : CPU only)
+// Return Value :
+//     0 - eim_set_dma_cutoff success.
+//     -1 - ioctl failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_set_dma_cutoff(int cutoff)
+{
+	struct eim_config cfg;
+
+	cfg.dma_cutoff = cutoff;
+    if (ioctl(m_eim_fd, EIM_IOC_SET_CONFIG, &cfg) < 0)
+    {
+		cout<<"< libeim.cpp > eim_set_dma_cutoff : ioctl failed."<<endl;
+		return -1;
+    }
+
+	return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the CPU / SDMA read cutoff.
+// Parameters :
+//     None.
+// Return Value :
+//     the cutoff in bytes (EIM_CUTOFF_CPU_ONLY : SDMA never used).
+//     -1 - ioctl failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_get_dma_cutoff(void)
+{
+	struct eim_config cfg;
+
+    if (ioctl(m_eim_fd, EIM_IOC_GET_CONFIG, &cfg) < 0)
+    {
+		cout<<"< libeim.cpp > eim_get_dma_cutoff : ioctl failed."<<endl;
+		return -1;
+    }
+
+	return cfg.dma_cutoff;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function gets the reads and bytes carried by each copy engine.
+// Parameters :
+//     stats - engine counters
+// Return Value :
+//     0 - eim_get_engine_stats success.
+//     -1 - ioctl failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_get_engine_stats(struct eim_engine_stats *stats)
+{
+    if (ioctl(m_eim_fd, EIM_IOC_GET_ENGINE_STATS, stats) < 0)
+    {
+		cout<<"< libeim.cpp > eim_get_engine_stats : ioctl failed."<<endl;
+		return -1;
+    }
+
+	return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function sets how long an SDMA read spins on the descriptor
+// 	   status before it sleeps on the completion.
+// Parameters :
+//     budget_us - poll budget in us, 0 ~ EIM_POLL_MAX_US (0 : always sleep)
+// Return Value :
+//     0 - eim_set_poll success.
+//     -1 - ioctl failed.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+int eim::eim_set_poll(int budget_us)
+{
+    if (ioctl(m_eim_fd, EIM_IOC_SET_POLL, budget_us) < 0)
+    {
+		cout<<"< libeim.cpp > eim_set_poll : ioctl failed."<<endl;
+		return -1;
+    }
+
+	return 0;
 }
 
 // ------------------------------------------------------------
@@ -282,11 +1004,9 @@ void eim::eim_set_fpgalength(int fpgalength)
 {
     m_fpgalength = fpgalength;
 	
-    m_fpga_wbuf = new unsigned char[m_fpgalength];
-	memset(m_fpga_wbuf, 0, sizeof(unsigned char) * m_fpgalength);    
-
-    m_fpga_wbuf16 = new unsigned char[m_fpgalength * 2];
-	memset(m_fpga_wbuf16, 0, sizeof(unsigned char) * m_fpgalength * 2);    
+    delete [] m_fpga_wbuf;
+    m_fpga_wbuf = new unsigned char[m_fpgalength + 1];
+	memset(m_fpga_wbuf, 0, sizeof(unsigned char) * (m_fpgalength + 1));    
 }
 
 // ------------------------------------------------------------
@@ -351,11 +1071,12 @@ void eim::eim_set_datalength(int datalength)
 {
     m_datalength = datalength;
 
-	// 16KB 8-bit buffer (each uint occupies 1KB)
-    m_data_rbuf = (unsigned char *)mmap(NULL, SDMA_M2M_RBUF, PROT_READ, MAP_SHARED, m_eim_fd, 0);
+	// 16KB 8-bit buffer (each uint occupies 1KB), cacheable (see eim_acquire / eim_release)
+    m_data_rbuf = (unsigned char *)mmap(NULL, SDMA_M2M_RBUF, PROT_READ, MAP_SHARED, m_eim_fd, EIM_RING_OFFSET(m_ring_mode));
     if (m_data_rbuf == MAP_FAILED)
     {
 		cout<<"< libeim.cpp > eim_set_datalength : mmap failed."<<endl;
+		m_data_rbuf = NULL;
     }
 
 	// 1KB 16-bit buffer (one uint)
@@ -8,6 +8,10 @@
 #include <unistd.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "eim_ioctl.h"
+#include "rbz.h"
 
 using namespace std;
 
@@ -15,8 +19,10 @@ using namespace std;
 #define FPGA_FILE_LENGTH        (4928127)
 
 // dmode - download mode
-#define EIM_DOWNLOAD_PROGRAM    (1)
-#define EIM_DOWNLOAD_PARAMETERS (2)
+#define EIM_DOWNLOAD_PROGRAM    EIM_DMODE_PROGRAM
+#define EIM_DOWNLOAD_PARAMETERS EIM_DMODE_PARAMETERS
+#define EIM_DOWNLOAD_PACKED     EIM_DMODE_PROGRAM_PACKED
+#define EIM_DOWNLOAD_PROGRAM8   EIM_DMODE_PROGRAM_8BIT
 
 // MUM - mux mode
 #define EIM_NOMUX               (0)
@@ -40,11 +46,6 @@ using namespace std;
 #define EIM_BIG_ENDIAN          (0)
 #define EIM_LITTLE_ENDIAN       (1)
 
-// Ring Buffer
-#define SDMA_RBUF_CNT			(16)
-#define SDMA_M2M_UNIT			(1024)
-#define SDMA_M2M_RBUF			(SDMA_RBUF_CNT * SDMA_M2M_UNIT)
-
 
 class eim
 {
@@ -61,12 +62,51 @@ public:
     // download 16-bit data (FPGA program)
     int eim_write16(void);
 
+    // download FPGA program packed, two bytes per 16-bit word (no widening)
+    int eim_write16_packed(void);
+
+    // download FPGA program on an 8-bit port, one byte per bus cycle (no widening)
+    int eim_write8_program(void);
+
+    // download FPGA program straight from a read-only mapping of the RBF
+    // dmode - EIM_DOWNLOAD_PROGRAM8 / EIM_DOWNLOAD_PACKED (the mapping is written
+    //         as it is) or EIM_DOWNLOAD_PROGRAM (widened from the mapping)
+    // an RBZ1 file (rbzpack) is decompressed on the fly, see eim_write_program_rbz
+    int eim_write_program(const char *path, int dmode);
+    int eim_write_program_fd(int fd, int dmode);
+
+    // download an RBZ1 compressed FPGA program, a decode thread fills the next
+    // blocks while the current one is clocked out in the same program session
+    int eim_write_program_rbz(int fd, int dmode);
+
     // upload 8-bit data
     int eim_read(unsigned char *buf);
 
     // upload 16-bit data
     int eim_read16(unsigned char *buf);
 
+    // upload one slot in place (the slot stays valid until eim_release)
+    const unsigned char *eim_acquire(void);
+    int eim_release(void);
+
+    // gather interleaved channels into one slot in place (released by eim_release),
+    // channel c starts at slot + c * req->count * req->elem_size
+    const unsigned char *eim_acquire_deinterleave(struct eim_deinterleave *req);
+
+    // set & get cache attribute of the Ring Buffer mapping (EIM_RING_NONCACHED / EIM_RING_CACHED)
+    int eim_set_ring_mode(int mode);
+    int eim_get_ring_mode(void);
+
+    // set & get CPU / SDMA read cutoff in bytes (0 keeps it, < 0 : CPU copies only)
+    int eim_set_dma_cutoff(int cutoff);
+    int eim_get_dma_cutoff(void);
+
+    // reads and bytes carried by the CPU copy and by SDMA
+    int eim_get_engine_stats(struct eim_engine_stats *stats);
+
+    // busy-poll budget of SDMA reads in us (0 : sleep on the completion)
+    int eim_set_poll(int budget_us);
+
     // set & get fpgalength
     void eim_set_fpgalength(int length);
     int eim_get_fpgalength(void);
@@ -114,10 +154,10 @@ private:
     int m_BCD;
     int m_WWSC;
 
-    // 8-bit FPGA program 
+    // 8-bit FPGA program (one spare byte pads an odd packed download)
     unsigned char *m_fpga_wbuf;
 
-    // 16-bit FPGA program adding zero
+    // 16-bit FPGA program adding zero (allocated by eim_write16 only)
     unsigned char *m_fpga_wbuf16;
 
     // 8-bit front-end parameters
@@ -132,6 +172,15 @@ private:
 	// the index of Ring Buffer
 	int m_rbuf_idx;
 
+	// bytes of the acquired slot (m_datalength, or the deinterleave output)
+	int m_slot_len;
+
+	// cache attribute of the Ring Buffer mapping
+	int m_ring_mode;
+
+	// synchronise the current slot for the CPU or SDMA (cached mapping only)
+	int eim_sync_slot(unsigned long cmd);
+
     // 16-bit data to be uploaded (1KB uint of Ring Buffer)
     unsigned char *m_data_rbuf16;
 
@@ -149,6 +198,12 @@ private:
 
     // convert 8-bit data to 16-bit data
     void char2short(int convtype, int endian);
+
+    // switch dmode / MUM / WWSC to the program download of dmode
+    void eim_program_mode(int dmode);
+
+    // read the FPGA program file into m_fpga_wbuf (allocated when NULL)
+    int eim_read_program(void);
 };
 
 #endif
@@ -0,0 +1,379 @@
+// NAME : rbz compressed bitstream format
+// FUNC : RLE compression of RBF images, streaming decoder and decode thread
+//        shared by libeim, fpp_test and rbzpack (no external dependency)
+// DATE : 2026.10.19
+// HIST : V1.0 2026.10.19 - RBZ1 format, decoder and pipe
+
+#ifndef _RBZ_H_
+#define _RBZ_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// file layout : header, then tokens up to the end of the file
+//   header : "RBZ1", raw length (u32 LE), Adler-32 of the raw bytes (u32 LE)
+//   token t < 0x80        : t + 1 literal bytes follow (1 - 128)
+//   token 0x80 <= t < 0xFF : the next byte repeated t - 0x80 + 3 times (3 - 129)
+//   token 0xFF            : u16 LE n and a byte, repeated n + 130 times (130 - 65665)
+// RBF images are mostly zero runs, which cost 4 bytes per 64KB
+#define RBZ_MAGIC               "RBZ1"
+#define RBZ_HDR_LEN             (12)
+#define RBZ_LIT_MAX             (128)
+#define RBZ_RUN_MIN             (3)
+#define RBZ_RUN_SHORT_MAX       (129)
+#define RBZ_RUN_LONG_MIN        (130)
+#define RBZ_RUN_LONG_MAX        (RBZ_RUN_LONG_MIN + 0xFFFF)
+#define RBZ_TOKEN_RUN           (0x80)
+#define RBZ_TOKEN_LONG          (0xFF)
+
+// Adler-32
+#define RBZ_ADLER_MOD           (65521)
+
+// decoder states
+#define RBZ_ST_HDR              (0)
+#define RBZ_ST_TOKEN            (1)
+#define RBZ_ST_LIT              (2)
+#define RBZ_ST_LONG0            (3)
+#define RBZ_ST_LONG1            (4)
+#define RBZ_ST_BYTE             (5)
+#define RBZ_ST_RUN              (6)
+#define RBZ_ST_ERROR            (7)
+
+// streaming decoder, input and output may be cut anywhere
+struct rbz_dec
+{
+    int state;
+    unsigned char hdr[RBZ_HDR_LEN];
+    unsigned int hdr_cnt;
+    unsigned int raw_len;       // from the header
+    unsigned int check;         // from the header
+    unsigned int out_cnt;       // bytes produced so far
+    unsigned int count;         // bytes left of the current literal / run
+    unsigned char byte;         // byte of the current run
+    unsigned int adler_a;
+    unsigned int adler_b;
+};
+
+// 1 if buf starts with an RBZ1 header
+static inline int rbz_is_rbz(const unsigned char *buf, size_t len)
+{
+    return (len >= 4) && (0 == memcmp(buf, RBZ_MAGIC, 4));
+}
+
+static inline unsigned int rbz_get32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static inline void rbz_put32(unsigned char *p, unsigned int v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+// Adler-32 over n copies of c, or over buf when buf is not NULL
+static inline void rbz_adler(unsigned int *a, unsigned int *b, const unsigned char *buf, unsigned char c, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        *a += buf ? buf[i] : c;
+        if (*a >= RBZ_ADLER_MOD)
+            *a -= RBZ_ADLER_MOD;
+        *b += *a;
+        if (*b >= RBZ_ADLER_MOD)
+            *b -= RBZ_ADLER_MOD;
+    }
+}
+
+static inline void rbz_dec_init(struct rbz_dec *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->state = RBZ_ST_HDR;
+    d->adler_a = 1;
+}
+
+// decodes in[*in_pos, in_len) into out[0, out_cap), returns the bytes written
+// and advances *in_pos, call again with more input or more room until
+// rbz_dec_done, a corrupt stream sets RBZ_ST_ERROR
+static inline size_t rbz_decode(struct rbz_dec *d, const unsigned char *in, size_t in_len, size_t *in_pos,
+        unsigned char *out, size_t out_cap)
+{
+    size_t ip = *in_pos;
+    size_t op = 0;
+    size_t n = 0;
+
+    while ((RBZ_ST_ERROR != d->state) && (op < out_cap))
+    {
+        if (RBZ_ST_RUN == d->state)
+        {
+            n = d->count < out_cap - op ? d->count : out_cap - op;
+            memset(out + op, d->byte, n);
+            rbz_adler(&d->adler_a, &d->adler_b, NULL, d->byte, n);
+            op += n;
+            d->count -= n;
+            d->state = d->count ? RBZ_ST_RUN : RBZ_ST_TOKEN;
+            continue;
+        }
+        if (ip >= in_len)
+        {
+            break;
+        }
+        switch (d->state)
+        {
+        case RBZ_ST_HDR:
+            d->hdr[d->hdr_cnt++] = in[ip++];
+            if (RBZ_HDR_LEN == d->hdr_cnt)
+            {
+                d->raw_len = rbz_get32(d->hdr + 4);
+                d->check = rbz_get32(d->hdr + 8);
+                d->state = rbz_is_rbz(d->hdr, RBZ_HDR_LEN) ? RBZ_ST_TOKEN : RBZ_ST_ERROR;
+            }
+            break;
+        case RBZ_ST_TOKEN:
+            if (in[ip] < RBZ_TOKEN_RUN)
+            {
+                d->count = in[ip] + 1;
+                d->state = RBZ_ST_LIT;
+            }
+            else if (in[ip] < RBZ_TOKEN_LONG)
+            {
+                d->count = in[ip] - RBZ_TOKEN_RUN + RBZ_RUN_MIN;
+                d->state = RBZ_ST_BYTE;
+            }
+            else
+            {
+                d->state = RBZ_ST_LONG0;
+            }
+            ip++;
+            break;
+        case RBZ_ST_LIT:
+            n = d->count;
+            n = n < out_cap - op ? n : out_cap - op;
+            n = n < in_len - ip ? n : in_len - ip;
+            memcpy(out + op, in + ip, n);
+            rbz_adler(&d->adler_a, &d->adler_b, in + ip, 0, n);
+            ip += n;
+            op += n;
+            d->count -= n;
+            d->state = d->count ? RBZ_ST_LIT : RBZ_ST_TOKEN;
+            break;
+        case RBZ_ST_LONG0:
+            d->count = in[ip++];
+            d->state = RBZ_ST_LONG1;
+            break;
+        case RBZ_ST_LONG1:
+            d->count = (d->count | (in[ip++] << 8)) + RBZ_RUN_LONG_MIN;
+            d->state = RBZ_ST_BYTE;
+            break;
+        case RBZ_ST_BYTE:
+            d->byte = in[ip++];
+            d->state = RBZ_ST_RUN;
+            break;
+        }
+    }
+
+    d->out_cnt += op;
+    if (d->out_cnt > d->raw_len)
+    {
+        d->state = RBZ_ST_ERROR;
+    }
+    *in_pos = ip;
+
+    return op;
+}
+
+// 1 once the header length is produced (0 before), -1 on a corrupt stream
+// or a checksum mismatch
+static inline int rbz_dec_done(const struct rbz_dec *d)
+{
+    if (RBZ_ST_ERROR == d->state)
+        return -1;
+    if ((RBZ_ST_HDR == d->state) || (d->out_cnt < d->raw_len) || (RBZ_ST_TOKEN != d->state))
+        return 0;
+    return ((d->adler_b << 16) | d->adler_a) == d->check ? 1 : -1;
+}
+
+// decode thread : reads the compressed file and fills RBZ_PIPE_BLOCKS blocks of
+// RBZ_PIPE_BLOCK bytes (the last one may be shorter), so flash reads and
+// decompression overlap the download of the previous blocks
+// every block has one spare byte for a pad
+#define RBZ_PIPE_BLOCKS         (4)
+#define RBZ_PIPE_BLOCK          (256 * 1024)
+#define RBZ_PIPE_IN             (64 * 1024)
+
+struct rbz_pipe
+{
+    FILE *fp;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned char *blocks[RBZ_PIPE_BLOCKS];
+    size_t lens[RBZ_PIPE_BLOCKS];
+    int head;                   // next block the consumer takes
+    int filled;                 // blocks ready for the consumer
+    int eof;                    // the producer is done
+    int error;                  // -1 : read error or corrupt stream
+    int stop;                   // the consumer gave up
+    struct rbz_dec dec;
+};
+
+static inline void *rbz_pipe_producer(void *arg)
+{
+    struct rbz_pipe *p = (struct rbz_pipe *)arg;
+    unsigned char *in = (unsigned char *)malloc(RBZ_PIPE_IN);
+    size_t in_len = 0;
+    size_t in_pos = 0;
+    int tail = 0;
+    int error = in ? 0 : -1;
+
+    while (0 == error)
+    {
+        size_t len = 0;
+        int stop = 0;
+
+        // wait for a free block
+        pthread_mutex_lock(&p->lock);
+        while ((RBZ_PIPE_BLOCKS == p->filled) && !p->stop)
+            pthread_cond_wait(&p->cond, &p->lock);
+        stop = p->stop;
+        pthread_mutex_unlock(&p->lock);
+        if (stop)
+            break;
+
+        // decode until the block is full or the stream ends
+        while ((len < RBZ_PIPE_BLOCK) && (1 != rbz_dec_done(&p->dec)))
+        {
+            if (in_pos == in_len)
+            {
+                in_len = fread(in, 1, RBZ_PIPE_IN, p->fp);
+                in_pos = 0;
+                if (0 == in_len)
+                    break;
+            }
+            len += rbz_decode(&p->dec, in, in_len, &in_pos, p->blocks[tail] + len, RBZ_PIPE_BLOCK - len);
+            if (rbz_dec_done(&p->dec) < 0)
+                break;
+        }
+        if (rbz_dec_done(&p->dec) < 0)
+            error = -1;
+        else if ((0 == len) && (1 != rbz_dec_done(&p->dec)))
+            error = -1;     // truncated
+
+        pthread_mutex_lock(&p->lock);
+        if (len && (0 == error))
+        {
+            p->lens[tail] = len;
+            p->filled++;
+            tail = (tail + 1) % RBZ_PIPE_BLOCKS;
+        }
+        if (error || (1 == rbz_dec_done(&p->dec)))
+        {
+            p->error = error;
+            p->eof = 1;
+        }
+        stop = p->eof;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+        if (stop)
+            break;
+    }
+
+    if (error)
+    {
+        pthread_mutex_lock(&p->lock);
+        p->error = -1;
+        p->eof = 1;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+    free(in);
+
+    return NULL;
+}
+
+// starts decoding fp, returns 0 or -1 (nothing to close on failure)
+static inline int rbz_pipe_open(struct rbz_pipe *p, FILE *fp)
+{
+    int i = 0;
+
+    memset(p, 0, sizeof(*p));
+    p->fp = fp;
+    rbz_dec_init(&p->dec);
+    for (i = 0; i < RBZ_PIPE_BLOCKS; i++)
+    {
+        p->blocks[i] = (unsigned char *)malloc(RBZ_PIPE_BLOCK + 1);
+        if (NULL == p->blocks[i])
+            goto err_free;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    if (pthread_create(&p->thread, NULL, rbz_pipe_producer, p))
+    {
+        pthread_mutex_destroy(&p->lock);
+        pthread_cond_destroy(&p->cond);
+        goto err_free;
+    }
+
+    return 0;
+
+err_free:
+    for (i = 0; i < RBZ_PIPE_BLOCKS; i++)
+        free(p->blocks[i]);
+    return -1;
+}
+
+// the next decoded block and its length, NULL at the end of the stream
+// (rbz_pipe_close tells a clean end from an error)
+static inline unsigned char *rbz_pipe_get(struct rbz_pipe *p, size_t *len)
+{
+    unsigned char *block = NULL;
+
+    pthread_mutex_lock(&p->lock);
+    while ((0 == p->filled) && !p->eof)
+        pthread_cond_wait(&p->cond, &p->lock);
+    if (p->filled && (0 == p->error))
+    {
+        block = p->blocks[p->head];
+        *len = p->lens[p->head];
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return block;
+}
+
+// hands the block of the last rbz_pipe_get back to the producer
+static inline void rbz_pipe_put(struct rbz_pipe *p)
+{
+    pthread_mutex_lock(&p->lock);
+    p->head = (p->head + 1) % RBZ_PIPE_BLOCKS;
+    p->filled--;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+// stops the producer and frees the blocks, returns 0 if the whole stream
+// was decoded and its checksum matched, -1 otherwise
+static inline int rbz_pipe_close(struct rbz_pipe *p)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+
+    ret = (p->error || (1 != rbz_dec_done(&p->dec))) ? -1 : 0;
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->cond);
+    for (int i = 0; i < RBZ_PIPE_BLOCKS; i++)
+        free(p->blocks[i]);
+
+    return ret;
+}
+
+#endif
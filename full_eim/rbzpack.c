@@ -0,0 +1,221 @@
+// rbzpack.c
+// RBF <-> RBZ1 converter (format in rbz.h), built for the host and the board
+// ./rbzpack fpga_ram.rbf fpga_ram.rbz       - compress
+// ./rbzpack -d fpga_ram.rbz fpga_ram.rbf    - decompress and check the Adler-32
+// ./rbzpack -t fpga_ram.rbz                 - check only
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "rbz.h"
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+// read a whole file, returns the buffer or NULL
+static unsigned char *read_file(const char *path, size_t *len)
+{
+    FILE *fp = NULL;
+    unsigned char *buf = NULL;
+    long size = 0;
+
+    fp = fopen(path, "rb");
+    if (NULL == fp)
+    {
+        printf("open %s failed.\n", path);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = (unsigned char *)malloc(size > 0 ? size : 1);
+    if ((size < 0) || (NULL == buf) || ((size_t)size != fread(buf, 1, size, fp)))
+    {
+        printf("read %s failed.\n", path);
+        free(buf);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *len = size;
+
+    return buf;
+}
+
+// length of the run of in[0] at in, at most max
+static size_t run_len(const unsigned char *in, size_t len, size_t max)
+{
+    size_t n = 1;
+
+    while ((n < len) && (n < max) && (in[n] == in[0]))
+        n++;
+
+    return n;
+}
+
+// compress in into out (worst case RBZ_HDR_LEN + len + len / RBZ_LIT_MAX + 1),
+// returns the compressed length
+static size_t rbz_pack(const unsigned char *in, size_t len, unsigned char *out)
+{
+    unsigned int a = 1;
+    unsigned int b = 0;
+    size_t ip = 0;
+    size_t op = RBZ_HDR_LEN;
+    size_t lit = 0;     // start of the pending literal
+
+    rbz_adler(&a, &b, in, 0, len);
+    memcpy(out, RBZ_MAGIC, 4);
+    rbz_put32(out + 4, len);
+    rbz_put32(out + 8, (b << 16) | a);
+
+    while (ip <= len)
+    {
+        size_t run = ip < len ? run_len(in + ip, len - ip, RBZ_RUN_LONG_MAX) : 0;
+
+        // flush the literal before a run, at the end or when it is full
+        if ((ip > lit) && ((run >= RBZ_RUN_MIN) || (ip == len) || (ip - lit == RBZ_LIT_MAX)))
+        {
+            out[op++] = ip - lit - 1;
+            memcpy(out + op, in + lit, ip - lit);
+            op += ip - lit;
+            lit = ip;
+        }
+        if (ip == len)
+            break;
+
+        if (run >= RBZ_RUN_LONG_MIN)
+        {
+            out[op++] = RBZ_TOKEN_LONG;
+            out[op++] = (run - RBZ_RUN_LONG_MIN) & 0xFF;
+            out[op++] = (run - RBZ_RUN_LONG_MIN) >> 8;
+            out[op++] = in[ip];
+        }
+        else if (run >= RBZ_RUN_MIN)
+        {
+            out[op++] = RBZ_TOKEN_RUN + run - RBZ_RUN_MIN;
+            out[op++] = in[ip];
+        }
+        else
+        {
+            ip++;
+            continue;
+        }
+        ip += run;
+        lit = ip;
+    }
+
+    return op;
+}
+
+int main(int argc, char **argv)
+{
+    int unpack = 0;
+    int test = 0;
+    const char *src = NULL;
+    const char *dst = NULL;
+    unsigned char *in = NULL;
+    unsigned char *out = NULL;
+    size_t in_len = 0;
+    size_t out_len = 0;
+    struct timeval tstart, tend;
+
+    if ((argc == 4) && (0 == strcmp(argv[1], "-d")))
+    {
+        unpack = 1;
+        src = argv[2];
+        dst = argv[3];
+    }
+    else if ((argc == 3) && (0 == strcmp(argv[1], "-t")))
+    {
+        unpack = 1;
+        test = 1;
+        src = argv[2];
+    }
+    else if (argc == 3)
+    {
+        src = argv[1];
+        dst = argv[2];
+    }
+    else
+    {
+        printf("Usage : %s in.rbf out.rbz | -d in.rbz out.rbf | -t in.rbz\n", argv[0]);
+        return -1;
+    }
+
+    in = read_file(src, &in_len);
+    if (NULL == in)
+    {
+        return -1;
+    }
+
+    gettimeofday(&tstart, NULL);
+    if (unpack)
+    {
+        struct rbz_dec dec;
+        size_t in_pos = 0;
+
+        if ((in_len < RBZ_HDR_LEN) || !rbz_is_rbz(in, in_len))
+        {
+            printf("%s is not an RBZ1 file.\n", src);
+            return -1;
+        }
+        out_len = rbz_get32(in + 4);
+        out = (unsigned char *)malloc(out_len + 1);
+        if (NULL == out)
+        {
+            printf("malloc failed.\n");
+            return -1;
+        }
+        rbz_dec_init(&dec);
+        rbz_decode(&dec, in, in_len, &in_pos, out, out_len);
+        // an empty program still has to reach the token state
+        if (0 == out_len)
+        {
+            rbz_decode(&dec, in, in_len, &in_pos, out, 1);
+        }
+        if (1 != rbz_dec_done(&dec))
+        {
+            printf("%s is corrupt (truncated or wrong checksum).\n", src);
+            return -1;
+        }
+    }
+    else
+    {
+        out = (unsigned char *)malloc(RBZ_HDR_LEN + in_len + in_len / RBZ_LIT_MAX + 1);
+        if (NULL == out)
+        {
+            printf("malloc failed.\n");
+            return -1;
+        }
+        out_len = rbz_pack(in, in_len, out);
+    }
+    gettimeofday(&tend, NULL);
+
+    if (!test)
+    {
+        FILE *fp = fopen(dst, "wb");
+
+        if ((NULL == fp) || (out_len != fwrite(out, 1, out_len, fp)))
+        {
+            printf("write %s failed.\n", dst);
+            return -1;
+        }
+        fclose(fp);
+    }
+
+    printf("------------------------------------\n");
+    printf("%s : %d bytes -> %d bytes (%.2fx) in %ld us.\n", unpack ? "unpack" : "pack",
+            (int)in_len, (int)out_len, unpack ? (float)out_len / (in_len ? in_len : 1)
+            : (float)in_len / (out_len ? out_len : 1), elapsed_us(&tstart, &tend));
+    printf("------------------------------------\n");
+
+    free(in);
+    free(out);
+
+    return 0;
+}
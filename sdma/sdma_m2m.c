@@ -2,9 +2,18 @@
 // FUNC : Direct Memory Access from Memory to Memory
 // DATE : 2013.11.07 by Young
 // DESP : DMA wbuf -> rbuf (mmap to USER_SPACE buffer)
+//        opt-in busy-poll of read() (poll_us module parameter, SDMA_M2M_IOC_SET_POLL)
+//        asynchronous user buffer copies (SDMA_M2M_IOC_SUBMIT / SDMA_M2M_IOC_REAP, poll)
+//        multi-slot read() chained into batch slots per descriptor (SDMA_M2M_IOC_GET_STATS)
+//        channel pool : read() on a control channel, jobs striped over bulk channels
 // HIST : V1.0 2013.11.07 - sdma_m2m driver program
 //		  V1.1 2013.11.16 - add sdev & DMA initilization
 //		  V1.2 2013.11.19 - add ring buffer
+//		  V1.3 2026.10.19 - add ring mmap cache attributes and slot sync ioctls
+//		  V1.4 2026.10.19 - add busy-poll completion mode (SDMA_M2M_IOC_SET_POLL, poll_us)
+//		  V1.5 2026.10.19 - add asynchronous copy job queue and completion ring
+//		  V1.6 2026.10.19 - chain multi-slot reads, one interrupt per batch (batch, SDMA_M2M_IOC_GET_STATS)
+//		  V1.7 2026.10.19 - control / bulk channel pool with striping (bulk_chans, ctrl_prio, bulk_prio)
 
 #include <linux/slab.h>
 #include <linux/dma-mapping.h>
@@ -14,13 +23,83 @@
 #include <linux/completion.h>
 #include <linux/signal.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <linux/mm.h>
+#include <linux/cache.h>
+#include <linux/pagemap.h>
+#include <linux/sched.h>
+#include <linux/poll.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+
+#include "sdma_m2m_ioctl.h"
 
 #define DEVICE_NAME			"sdma_m2m"
-#define SDMA_M2M_WBUF		(1024)						// 1KB
-#define RBUF_CNT			16
-#define SDMA_M2M_RBUF  		(RBUF_CNT * SDMA_M2M_WBUF)	// 16KB
+#define SDMA_M2M_WBUF		(SDMA_M2M_SLOT)				// 1KB
+#define RBUF_CNT			(SDMA_M2M_SLOT_CNT)
+#define SDMA_M2M_RBUF  		(SDMA_M2M_RING)				// 16KB
 #define DEBUG 				0
 
+// a stripe per started SDMA_M2M_STRIPE_MIN, jobs up to this size stay on one bulk channel
+#define SDMA_M2M_STRIPE_MIN	(64 * 1024)
+
+// busy-poll budget of a newly opened file in microseconds (0 : sleep)
+// small copies finish well before a sleep / wakeup round trip
+static int poll_us = 0;
+module_param(poll_us, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(poll_us, "default busy-poll budget of read() in microseconds (0 : sleep)");
+
+// ring slots chained into one descriptor by read(), SDMA interrupts once per descriptor
+static int batch = RBUF_CNT;
+module_param(batch, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(batch, "ring slots per SDMA descriptor of read() (1 - 16)");
+
+// channel pool, read at load : read() runs on the control channel, copy jobs
+// are striped over the bulk channels (DMA_PRIO_HIGH 0 / MEDIUM 1 / LOW 2)
+static int bulk_chans = 2;
+module_param(bulk_chans, int, S_IRUGO);
+MODULE_PARM_DESC(bulk_chans, "SDMA channels for copy jobs (1 - 4)");
+
+static int ctrl_prio = DMA_PRIO_HIGH;
+module_param(ctrl_prio, int, S_IRUGO);
+MODULE_PARM_DESC(ctrl_prio, "priority of the read() channel (0 high - 2 low)");
+
+static int bulk_prio = DMA_PRIO_MEDIUM;
+module_param(bulk_prio, int, S_IRUGO);
+MODULE_PARM_DESC(bulk_prio, "priority of the copy job channels (0 high - 2 low)");
+
+// one queued copy job
+typedef struct _sdma_m2m_kjob
+{
+	struct list_head list;
+	struct sdma_m2m_job job;
+
+	// pinned pages, source pages first
+	struct page **pages;
+	int src_pages;
+	int dst_pages;
+
+	// source and destination entries of equal lengths (M2M pairs them
+	// entry by entry), both lists share one allocation
+	struct scatterlist *src_sg;
+	struct scatterlist *dst_sg;
+	int nents;
+}sdma_m2m_kjob;
+
+// one channel of the pool
+typedef struct _sdma_m2m_pchan
+{
+	struct dma_chan *chan;
+
+	// issue time and bytes of the descriptor in flight
+	ktime_t start;
+	unsigned int bytes;
+
+	struct sdma_m2m_chan_stats stats;
+}sdma_m2m_pchan;
+
 // sdma_m2m device struct
 typedef struct _sdma_m2m_dev
 {
@@ -31,23 +110,33 @@ typedef struct _sdma_m2m_dev
 	struct class *sdma_m2m_class;
 	struct device *sdma_m2m_device;
     
-	// DMA channel
+	// DMA channel (control channel of the pool, read() only)
 	struct dma_chan *dma_m2m_chan;
 
+	// channel pool, pchan[0] is the control channel, 1 ~ bulk_cnt the bulk channels
+	sdma_m2m_pchan pchan[SDMA_M2M_CHAN_MAX];
+	int bulk_cnt;
+
 	// DMA tx descriptor
 	struct dma_async_tx_descriptor *dma_m2m_desc;
 
 	// DMA configuration
 	struct dma_slave_config dma_m2m_config;
 
-	// scatterlist
-	struct scatterlist sg1;
-	struct scatterlist sg2;
+	// scatterlist, one entry per ring slot
+	struct scatterlist sg1[RBUF_CNT];
+	struct scatterlist sg2[RBUF_CNT];
 
 	// write and read buffer
 	unsigned char *wbuf;
 	unsigned char *rbuf;
 	int rbuf_cnt;
+
+	// bus address of the ring (mapped once, synchronised by ioctl)
+	dma_addr_t rbuf_dma;
+
+	// read() counters (SDMA_M2M_IOC_GET_STATS)
+	struct sdma_m2m_stats stats;
     
 	// device open state
     atomic_t open_state;
@@ -56,6 +145,23 @@ typedef struct _sdma_m2m_dev
 	// ensures that DMA work has been completed before read returns
 	struct completion dma_callback_ok;
 
+	// read() state (sg1 / sg2 / rbuf_cnt)
+	struct mutex read_lock;
+
+	// asynchronous copy jobs, job_lock covers the queue and the completion ring
+	// job_count - jobs queued, running or completed but not reaped
+	// stripes_left - bulk channels still copying the running job
+	struct mutex job_lock;
+	struct list_head job_queue;
+	sdma_m2m_kjob *job_running;
+	atomic_t stripes_left;
+	struct work_struct job_work;
+	int job_count;
+	struct sdma_m2m_cqe cq[SDMA_M2M_CQ_CNT];
+	int cq_head;
+	int cq_cnt;
+	wait_queue_head_t cq_wait;
+
 }sdma_m2m_dev;
 static sdma_m2m_dev *sdev = NULL;
 
@@ -87,6 +193,9 @@ int sdma_m2m_open(struct inode * inode, struct file * filp)
         return -EBUSY;
     }
 
+	// per file busy-poll budget (SDMA_M2M_IOC_SET_POLL)
+	filp->private_data = (void *)(long)clamp(poll_us, 0, SDMA_M2M_POLL_MAX_US);
+
 	return 0;
 }
 
@@ -108,6 +217,15 @@ int sdma_m2m_release(struct inode *inode, struct file * filp)
         return -EFAULT;
     }
 
+	// the queued jobs hold pages of this file's owner, let them finish
+	// and drop the completions nobody reaped
+	wait_event(sdev->cq_wait, (NULL == sdev->job_running) && list_empty(&sdev->job_queue));
+	mutex_lock(&sdev->job_lock);
+	sdev->cq_head = 0;
+	sdev->cq_cnt = 0;
+	sdev->job_count = 0;
+	mutex_unlock(&sdev->job_lock);
+
     atomic_inc(&sdev->open_state);
 
     return 0;  
@@ -148,92 +266,768 @@ static void dma_m2m_callback(void *data)
 	printk(KERN_INFO "< sdma_m2m.c > dma_m2m_callback : %s.\n", __func__);
 #endif
 
+	sdev->stats.irqs++;
+	sdev->pchan[0].stats.transfers++;
+	sdev->pchan[0].stats.bytes += sdev->pchan[0].bytes;
+	sdev->pchan[0].stats.busy_ns += ktime_to_ns(ktime_sub(ktime_get(), sdev->pchan[0].start));
+
 	// trigger wait_for_completion process
 	complete(&sdev->dma_callback_ok);
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function implements read file operation.
+// 	   This function waits for a submitted copy. It spins on the descriptor
+//     status for up to budget_us and sleeps on the callback after that.
+// Parameters :
+//	   cookie - cookie returned by dmaengine_submit
+//	   budget_us - busy-poll budget in microseconds (0 : sleep at once)
+// Return Value :
+//     None.
+// Errors :
+//     None.
+// -------------------------------------------------------------
+static void sdma_m2m_wait(dma_cookie_t cookie, int budget_us)
+{
+	ktime_t end;
+
+	if (budget_us > 0)
+	{
+		end = ktime_add_us(ktime_get(), budget_us);
+		do
+		{
+			// the callback still runs, consume its completion so the next
+			// request does not see a stale one
+			if ((DMA_SUCCESS == dma_async_is_tx_complete(sdev->dma_m2m_chan, cookie, NULL, NULL)) &&
+				try_wait_for_completion(&sdev->dma_callback_ok))
+			{
+				return;
+			}
+			cpu_relax();
+		} while (ktime_to_ns(ktime_sub(end, ktime_get())) > 0);
+	}
+
+	wait_for_completion(&sdev->dma_callback_ok);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function implements read file operation : wbuf is copied into
+//     the next ceil(count / SDMA_M2M_SLOT) ring slots, batch slots per
+//     descriptor and one SDMA interrupt per descriptor.
 // Parameters :
 //	   filp - object file
 //	   buf - buffer pointer in user space
-//	   count - the actual number of data to read
+//	   count - the actual number of data to read (no more than SDMA_M2M_RING)
 //	   fops - the offset of data
 // Return Value :
-//     positive value - the actual number of data read
-//	   negative value - copy_to_user error
+//     0 - sdma_m2m_read success
 // Errors :
-//     None.
+//     -EINVAL - count is 0 or larger than the ring
+//     -EIO - device_prep_slave_sg failed
 // -------------------------------------------------------------
 ssize_t sdma_m2m_read(struct file *filp, char __user *buf, size_t count, loff_t *offset)
 {
-	// correspond sg1 and wbuf
-	sg_init_one(&sdev->sg1, sdev->wbuf, count);
-	dma_map_sg(NULL, &sdev->sg1, 1, sdev->dma_m2m_config.direction);
-	sdev->dma_m2m_desc = sdev->dma_m2m_chan->device->device_prep_slave_sg(sdev->dma_m2m_chan, &sdev->sg1, 1, sdev->dma_m2m_config.direction, 1);
-    if (!sdev->dma_m2m_desc)
-    {
-        printk(KERN_INFO "< sdma_m2m.c > sdma_m2m_write : device_prep_slave_sg wbuf failed.\n");
-        return -1;
-    }
+	dma_cookie_t cookie;
+	int blocks = 0;
+	int per_desc = clamp(batch, 1, RBUF_CNT);
+	int done = 0;
+	int n = 0;
+	int i = 0;
+	int ret = 0;
 
-	// correspond sg2 and rbuf
-	sg_init_one(&sdev->sg2, sdev->rbuf + sdev->rbuf_cnt * 1024, count);
-	// change index of ring buffer
-	sdev->rbuf_cnt = (sdev->rbuf_cnt + 1) % RBUF_CNT;		
-	dma_map_sg(NULL, &sdev->sg2, 1, sdev->dma_m2m_config.direction);
-	sdev->dma_m2m_desc = sdev->dma_m2m_chan->device->device_prep_slave_sg(sdev->dma_m2m_chan, &sdev->sg2, 1, sdev->dma_m2m_config.direction, 0);
-    if (!sdev->dma_m2m_desc)
-    {
-        printk(KERN_INFO "< sdma_m2m.c > sdma_m2m_write : device_prep_slave_sg rbuf failed.\n");
-        return -1;
-    }
+	if ((0 == count) || (count > SDMA_M2M_RBUF))
+	{
+		return -EINVAL;
+	}
+	blocks = (count + SDMA_M2M_SLOT - 1) / SDMA_M2M_SLOT;
+
+	// copy jobs run on the bulk channels, read() keeps the control channel
+	mutex_lock(&sdev->read_lock);
+
+	// correspond sg1 and wbuf, every block copies wbuf (the last one may be short)
+	sg_init_table(sdev->sg1, blocks);
+	for (i = 0; i < blocks; i++)
+	{
+		sg_set_buf(&sdev->sg1[i], sdev->wbuf, min_t(size_t, count - i * SDMA_M2M_SLOT, SDMA_M2M_SLOT));
+	}
+	dma_map_sg(NULL, sdev->sg1, blocks, sdev->dma_m2m_config.direction);
 
-	// set callback function
-	sdev->dma_m2m_desc->callback = dma_m2m_callback;
+	for (done = 0; done < blocks; done += n)
+	{
+		n = min(blocks - done, per_desc);
 
-	// add to the DMA transferring queue
-	dmaengine_submit(sdev->dma_m2m_desc);	
+		sdev->dma_m2m_desc = sdev->dma_m2m_chan->device->device_prep_slave_sg(sdev->dma_m2m_chan, &sdev->sg1[done], n, sdev->dma_m2m_config.direction, 1);
+	    if (!sdev->dma_m2m_desc)
+	    {
+	        printk(KERN_INFO "< sdma_m2m.c > sdma_m2m_read : device_prep_slave_sg wbuf failed.\n");
+			ret = -EIO;
+			break;
+	    }
 
-	// start DMA transferring
-	sdev->dma_m2m_chan->device->device_issue_pending(sdev->dma_m2m_chan);	
+		// correspond sg2 and rbuf (the ring stays mapped, see sdma_m2m_ioctl)
+		sg_init_table(sdev->sg2, n);
+		for (i = 0; i < n; i++)
+		{
+			sg_dma_address(&sdev->sg2[i]) = sdev->rbuf_dma + sdev->rbuf_cnt * SDMA_M2M_SLOT;
+			sg_dma_len(&sdev->sg2[i]) = sg_dma_len(&sdev->sg1[done + i]);
+			// change index of ring buffer
+			sdev->rbuf_cnt = (sdev->rbuf_cnt + 1) % RBUF_CNT;
+		}
+		sdev->dma_m2m_desc = sdev->dma_m2m_chan->device->device_prep_slave_sg(sdev->dma_m2m_chan, sdev->sg2, n, sdev->dma_m2m_config.direction, 0);
+	    if (!sdev->dma_m2m_desc)
+	    {
+	        printk(KERN_INFO "< sdma_m2m.c > sdma_m2m_read : device_prep_slave_sg rbuf failed.\n");
+			// the slots of this descriptor were not filled, give them back
+			sdev->rbuf_cnt = (sdev->rbuf_cnt + RBUF_CNT - n) % RBUF_CNT;
+			ret = -EIO;
+			break;
+	    }
+
+		// set callback function (SDMA interrupts on the last block only)
+		sdev->dma_m2m_desc->callback = dma_m2m_callback;
+		sdev->pchan[0].bytes = 0;
+		for (i = 0; i < n; i++)
+		{
+			sdev->pchan[0].bytes += sg_dma_len(&sdev->sg2[i]);
+		}
+		sdev->pchan[0].start = ktime_get();
+
+		// add to the DMA transferring queue
+		cookie = dmaengine_submit(sdev->dma_m2m_desc);
+
+		// start DMA transferring
+		sdev->dma_m2m_chan->device->device_issue_pending(sdev->dma_m2m_chan);
 
 #if DEBUG == 1
-	// delay 5s
-	ssleep(5);
+		// delay 5s
+		ssleep(5);
 #endif
 
-	// wait for DMA callback function completion
-	// ensure that DMA work has been completed before read returns
-	wait_for_completion(&sdev->dma_callback_ok);	
+		// wait for DMA callback function completion (busy-poll first if the file asks for it)
+		// ensure that DMA work has been completed before read returns
+		sdma_m2m_wait(cookie, (int)(long)filp->private_data);
+
+		sdev->stats.blocks += n;
+	}
+	sdev->stats.reads++;
+	sdev->stats.bytes += min_t(size_t, count, done * SDMA_M2M_SLOT);
 
 	// release resources
-	dma_unmap_sg(NULL, &sdev->sg1, 1, sdev->dma_m2m_config.direction);
-	dma_unmap_sg(NULL, &sdev->sg2, 1, sdev->dma_m2m_config.direction);
+	dma_unmap_sg(NULL, sdev->sg1, blocks, sdev->dma_m2m_config.direction);
+	mutex_unlock(&sdev->read_lock);
+
+	return ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function pins the user pages of a job and builds its source
+//     and destination lists, split where either side crosses a page.
+// Parameters :
+//	   kjob - job with kjob->job filled in
+// Return Value :
+//	   0 - sdma_m2m_job_pin success (pages pinned and mapped)
+// Errors :
+//     -EINVAL - empty, too long, misaligned (SDMA_M2M_JOB_ALIGN, SDMA_M2M_JOB_DST_ALIGN)
+//               or overlapping job
+//     -ENOMEM - no memory for the page or entry lists
+//     -EFAULT - pinning or mapping failed
+// ------------------------------------------------------------
+static int sdma_m2m_job_pin(sdma_m2m_kjob *kjob)
+{
+	struct device *dev = sdev->dma_m2m_chan->device->dev;
+	unsigned long src = kjob->job.src;
+	unsigned long dst = kjob->job.dst;
+	unsigned int left = kjob->job.len;
+	int src_pages = 0;
+	int dst_pages = 0;
+	int pinned = 0;
+	int ret = 0;
+	int n = 0;
+	int i = 0;
+
+	if ((0 == left) || (left > SDMA_M2M_JOB_MAX_LEN) || ((src < dst + left) && (dst < src + left)))
+	{
+		return -EINVAL;
+	}
+
+	// 2-byte bus width : imx-sdma refuses odd entries when the job is prepared
+	// dst covers whole cache lines : mapping and unmapping it must not clean
+	// or invalidate bytes the caller writes while the job runs
+	BUILD_BUG_ON(SDMA_M2M_JOB_DST_ALIGN < L1_CACHE_BYTES);
+	if ((src & (SDMA_M2M_JOB_ALIGN - 1)) || ((dst | left) & (SDMA_M2M_JOB_DST_ALIGN - 1)))
+	{
+		return -EINVAL;
+	}
+	src_pages = (offset_in_page(src) + left + PAGE_SIZE - 1) >> PAGE_SHIFT;
+	dst_pages = (offset_in_page(dst) + left + PAGE_SIZE - 1) >> PAGE_SHIFT;
+
+	// never more entries than pages on both sides
+	kjob->pages = kmalloc(sizeof(struct page *) * (src_pages + dst_pages), GFP_KERNEL);
+	kjob->src_sg = kmalloc(sizeof(struct scatterlist) * (src_pages + dst_pages) * 2, GFP_KERNEL);
+	if (!kjob->pages || !kjob->src_sg)
+	{
+		ret = -ENOMEM;
+		goto free_lists;
+	}
+	kjob->dst_sg = kjob->src_sg + src_pages + dst_pages;
+
+	// SDMA reads the source pages and writes the destination pages
+	down_read(&current->mm->mmap_sem);
+	ret = get_user_pages(current, current->mm, src & PAGE_MASK, src_pages, 0, 0, kjob->pages, NULL);
+	pinned = (ret > 0) ? ret : 0;
+	if (pinned == src_pages)
+	{
+		ret = get_user_pages(current, current->mm, dst & PAGE_MASK, dst_pages, 1, 0, kjob->pages + src_pages, NULL);
+		pinned += (ret > 0) ? ret : 0;
+	}
+	up_read(&current->mm->mmap_sem);
+	if (pinned != src_pages + dst_pages)
+	{
+		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_job_pin : get_user_pages failed.\n");
+		ret = -EFAULT;
+		goto release_pages;
+	}
+
+	sg_init_table(kjob->src_sg, src_pages + dst_pages);
+	sg_init_table(kjob->dst_sg, src_pages + dst_pages);
+	while (left)
+	{
+		unsigned int len = min_t(unsigned int, left, PAGE_SIZE - offset_in_page(src));
+		len = min_t(unsigned int, len, PAGE_SIZE - offset_in_page(dst));
+
+		sg_set_page(&kjob->src_sg[n], kjob->pages[(src >> PAGE_SHIFT) - (kjob->job.src >> PAGE_SHIFT)],
+				len, offset_in_page(src));
+		sg_set_page(&kjob->dst_sg[n], kjob->pages[src_pages + (dst >> PAGE_SHIFT) - (kjob->job.dst >> PAGE_SHIFT)],
+				len, offset_in_page(dst));
+		src += len;
+		dst += len;
+		left -= len;
+		n++;
+	}
+	sg_mark_end(&kjob->src_sg[n - 1]);
+	sg_mark_end(&kjob->dst_sg[n - 1]);
+
+	if (0 == dma_map_sg(dev, kjob->src_sg, n, DMA_TO_DEVICE))
+	{
+		ret = -EFAULT;
+		goto release_pages;
+	}
+	if (0 == dma_map_sg(dev, kjob->dst_sg, n, DMA_FROM_DEVICE))
+	{
+		dma_unmap_sg(dev, kjob->src_sg, n, DMA_TO_DEVICE);
+		ret = -EFAULT;
+		goto release_pages;
+	}
+
+	kjob->src_pages = src_pages;
+	kjob->dst_pages = dst_pages;
+	kjob->nents = n;
+
+	return 0;
+
+release_pages:
+	for (i = 0; i < pinned; i++)
+	{
+		page_cache_release(kjob->pages[i]);
+	}
+
+free_lists:
+	kfree(kjob->pages);
+	kfree(kjob->src_sg);
+
+	return ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function unpins a finished job, frees it and adds its
+//     completion to the ring (called with job_lock held).
+// Parameters :
+//	   kjob - the finished job
+//	   status - 0 or -errno
+// Return Value :
+//	   None.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+static void sdma_m2m_job_done(sdma_m2m_kjob *kjob, int status)
+{
+	struct device *dev = sdev->dma_m2m_chan->device->dev;
+	struct sdma_m2m_cqe *cqe = NULL;
+	int i = 0;
+
+	dma_unmap_sg(dev, kjob->src_sg, kjob->nents, DMA_TO_DEVICE);
+	dma_unmap_sg(dev, kjob->dst_sg, kjob->nents, DMA_FROM_DEVICE);
+	for (i = 0; i < kjob->src_pages + kjob->dst_pages; i++)
+	{
+		// a failed job may have written part of its destination
+		if (i >= kjob->src_pages)
+		{
+			set_page_dirty_lock(kjob->pages[i]);
+		}
+		page_cache_release(kjob->pages[i]);
+	}
+
+	// job_count bounds the ring, it never overflows
+	cqe = &sdev->cq[(sdev->cq_head + sdev->cq_cnt) % SDMA_M2M_CQ_CNT];
+	cqe->tag = kjob->job.tag;
+	cqe->status = status;
+	cqe->len = status ? 0 : kjob->job.len;
+	sdev->cq_cnt++;
+
+	kfree(kjob->pages);
+	kfree(kjob->src_sg);
+	kfree(kjob);
+}
+
+static void sdma_m2m_job_callback(void *data)
+{
+	sdma_m2m_pchan *pc = (sdma_m2m_pchan *)data;
+
+	pc->stats.transfers++;
+	pc->stats.bytes += pc->bytes;
+	pc->stats.busy_ns += ktime_to_ns(ktime_sub(ktime_get(), pc->start));
+
+	// the last stripe finishes the job, unpinning may sleep so do it in process context
+	if (atomic_dec_and_test(&sdev->stripes_left))
+	{
+		schedule_work(&sdev->job_work);
+	}
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function splits a job into stripes of whole entries, one per
+//     bulk channel (no more than one per started SDMA_M2M_STRIPE_MIN),
+//     and starts them together.
+// Parameters :
+//	   kjob - the job, pinned and mapped
+// Return Value :
+//	   0 - sdma_m2m_job_stripe success
+// Errors :
+//     -EIO - device_prep_slave_sg failed, no stripe was started
+// ------------------------------------------------------------
+static int sdma_m2m_job_stripe(sdma_m2m_kjob *kjob)
+{
+	struct dma_async_tx_descriptor *desc[SDMA_M2M_BULK_MAX];
+	sdma_m2m_pchan *pc = NULL;
+	unsigned int target = 0;
+	unsigned int bytes = 0;
+	int stripes = 0;
+	int first = 0;
+	int n = 0;
+	int s = 0;
+	int i = 0;
+
+	stripes = min_t(int, sdev->bulk_cnt, kjob->nents);
+	stripes = min_t(int, stripes, DIV_ROUND_UP(kjob->job.len, SDMA_M2M_STRIPE_MIN));
+
+	for (s = 0; s < stripes; s++)
+	{
+		pc = &sdev->pchan[1 + s];
+
+		// entries up to an even share of the bytes, the last stripe takes the rest
+		target = (s == stripes - 1) ? kjob->job.len : (unsigned int)((u64)kjob->job.len * (s + 1) / stripes);
+		pc->bytes = 0;
+		for (n = 0; (first + n < kjob->nents) && (0 == n || bytes < target); n++)
+		{
+			bytes += sg_dma_len(&kjob->src_sg[first + n]);
+			pc->bytes += sg_dma_len(&kjob->src_sg[first + n]);
+		}
+
+		// M2M takes the source list first and then the destination list
+		desc[s] = pc->chan->device->device_prep_slave_sg(pc->chan, &kjob->src_sg[first], n, sdev->dma_m2m_config.direction, 1);
+		if (desc[s])
+		{
+			desc[s] = pc->chan->device->device_prep_slave_sg(pc->chan, &kjob->dst_sg[first], n, sdev->dma_m2m_config.direction, 0);
+		}
+		if (!desc[s])
+		{
+			printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_job_stripe : device_prep_slave_sg failed.\n");
+			// prepared channels are busy until terminated
+			for (i = 0; i <= s; i++)
+			{
+				dmaengine_terminate_all(sdev->pchan[1 + i].chan);
+			}
+			return -EIO;
+		}
+		desc[s]->callback = sdma_m2m_job_callback;
+		desc[s]->callback_param = pc;
+		first += n;
+	}
+
+	atomic_set(&sdev->stripes_left, stripes);
+	for (s = 0; s < stripes; s++)
+	{
+		pc = &sdev->pchan[1 + s];
+		pc->start = ktime_get();
+		dmaengine_submit(desc[s]);
+		pc->chan->device->device_issue_pending(pc->chan);
+	}
+
+	return 0;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function starts the next queued job if the bulk channels are
+//     idle (called with job_lock held).
+// Parameters :
+//	   None.
+// Return Value :
+//	   None.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+static void sdma_m2m_job_start(void)
+{
+	sdma_m2m_kjob *kjob = NULL;
+
+	while (!sdev->job_running && !list_empty(&sdev->job_queue))
+	{
+		kjob = list_first_entry(&sdev->job_queue, sdma_m2m_kjob, list);
+		list_del(&kjob->list);
+
+		if (sdma_m2m_job_stripe(kjob))
+		{
+			sdma_m2m_job_done(kjob, -EIO);
+			continue;
+		}
+		sdev->job_running = kjob;
+	}
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function completes the running job and starts the next one.
+// Parameters :
+//	   work - sdev->job_work
+// Return Value :
+//	   None.
+// Errors :
+//     None.
+// ------------------------------------------------------------
+static void sdma_m2m_job_work(struct work_struct *work)
+{
+	mutex_lock(&sdev->job_lock);
+	if (sdev->job_running)
+	{
+		sdma_m2m_job_done(sdev->job_running, 0);
+		sdev->job_running = NULL;
+	}
+	sdma_m2m_job_start();
+	mutex_unlock(&sdev->job_lock);
+
+	wake_up(&sdev->cq_wait);
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function queues a batch of jobs (SDMA_M2M_IOC_SUBMIT), the
+//     first one runs while the rest are being pinned. Every job is pinned
+//     without job_lock, which is taken only to reserve its completion
+//     and to queue it.
+// Parameters :
+//	   arg - struct sdma_m2m_batch in user space
+// Return Value :
+//	   the number of jobs queued
+// Errors :
+//     -EAGAIN - the completion ring is full
+//     -ENODEV - no bulk channel
+//     -EFAULT - copy_from_user or pinning failed
+//     -EINVAL - invalid job (misaligned src / dst / len included)
+//     -ENOMEM - no memory for the job
+//     (returned only when the first job of the batch fails)
+// ------------------------------------------------------------
+static long sdma_m2m_job_submit(unsigned long arg)
+{
+	struct sdma_m2m_batch req;
+	sdma_m2m_kjob *kjob = NULL;
+	unsigned int queued = 0;
+	int ret = 0;
+
+	if (0 == sdev->bulk_cnt)
+	{
+		return -ENODEV;
+	}
+	if (copy_from_user(&req, (void __user *)arg, sizeof(req)))
+	{
+		return -EFAULT;
+	}
+
+	for (queued = 0; queued < req.count; queued++)
+	{
+		// reserve the completion, job_count bounds the ring
+		mutex_lock(&sdev->job_lock);
+		if (sdev->job_count >= SDMA_M2M_CQ_CNT)
+		{
+			ret = -EAGAIN;
+		}
+		else
+		{
+			sdev->job_count++;
+		}
+		mutex_unlock(&sdev->job_lock);
+		if (ret)
+		{
+			break;
+		}
+
+		// the running job completes and the next one starts meanwhile
+		kjob = kzalloc(sizeof(sdma_m2m_kjob), GFP_KERNEL);
+		if (!kjob)
+		{
+			ret = -ENOMEM;
+		}
+		else if (copy_from_user(&kjob->job, (void __user *)(req.jobs + queued), sizeof(struct sdma_m2m_job)))
+		{
+			ret = -EFAULT;
+		}
+		else
+		{
+			ret = sdma_m2m_job_pin(kjob);
+		}
+
+		mutex_lock(&sdev->job_lock);
+		if (ret)
+		{
+			sdev->job_count--;
+		}
+		else
+		{
+			list_add_tail(&kjob->list, &sdev->job_queue);
+			sdma_m2m_job_start();
+		}
+		mutex_unlock(&sdev->job_lock);
+
+		// jobs refused by sdma_m2m_job_start already have a completion
+		wake_up(&sdev->cq_wait);
+		if (ret)
+		{
+			kfree(kjob);
+			break;
+		}
+	}
+
+	return queued ? (long)queued : ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function copies waiting completions to user space
+//     (SDMA_M2M_IOC_REAP), it does not block.
+// Parameters :
+//	   arg - struct sdma_m2m_reap in user space
+// Return Value :
+//	   the number of completions copied
+// Errors :
+//     -EFAULT - copy from / to user space failed
+// ------------------------------------------------------------
+static long sdma_m2m_job_reap(unsigned long arg)
+{
+	struct sdma_m2m_reap reap;
+	unsigned int n = 0;
+	int ret = 0;
+
+	if (copy_from_user(&reap, (void __user *)arg, sizeof(reap)))
+	{
+		return -EFAULT;
+	}
+
+	mutex_lock(&sdev->job_lock);
+	while ((n < reap.max) && sdev->cq_cnt)
+	{
+		if (copy_to_user((void __user *)(reap.cqes + n), &sdev->cq[sdev->cq_head], sizeof(struct sdma_m2m_cqe)))
+		{
+			ret = -EFAULT;
+			break;
+		}
+		sdev->cq_head = (sdev->cq_head + 1) % SDMA_M2M_CQ_CNT;
+		sdev->cq_cnt--;
+		sdev->job_count--;
+		n++;
+	}
+	mutex_unlock(&sdev->job_lock);
+
+	// room for more jobs (POLLOUT)
+	if (n)
+	{
+		wake_up(&sdev->cq_wait);
+	}
+
+	return n ? (long)n : ret;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function implements poll file operation for the job queue.
+// Parameters :
+//	   filp - object file
+//	   wait - poll table
+// Return Value :
+//	   POLLIN - completions are waiting (SDMA_M2M_IOC_REAP)
+//	   POLLOUT - another job can be queued (SDMA_M2M_IOC_SUBMIT)
+// Errors :
+//     None.
+// ------------------------------------------------------------
+static unsigned int sdma_m2m_poll(struct file *filp, poll_table *wait)
+{
+	unsigned int mask = 0;
+
+	poll_wait(filp, &sdev->cq_wait, wait);
+
+	mutex_lock(&sdev->job_lock);
+	if (sdev->cq_cnt)
+	{
+		mask |= POLLIN | POLLRDNORM;
+	}
+	if (sdev->job_count < SDMA_M2M_CQ_CNT)
+	{
+		mask |= POLLOUT | POLLWRNORM;
+	}
+	mutex_unlock(&sdev->job_lock);
+
+	return mask;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   This function synchronises a ring range for the CPU or SDMA
+//     (only needed with SDMA_M2M_MMAP_CACHED mappings), sets the
+//     busy-poll budget of the file, queues and reaps copy jobs, or
+//     returns the read() and channel counters.
+// Parameters :
+//	   filp - object file
+//	   cmd - SDMA_M2M_IOC_SYNC_FOR_CPU / SDMA_M2M_IOC_SYNC_FOR_DEVICE / SDMA_M2M_IOC_SET_POLL /
+//	         SDMA_M2M_IOC_SUBMIT / SDMA_M2M_IOC_REAP / SDMA_M2M_IOC_GET_STATS /
+//	         SDMA_M2M_IOC_GET_CHAN_STATS
+//	   arg - struct sdma_m2m_sync / sdma_m2m_batch / sdma_m2m_reap / sdma_m2m_stats /
+//	         sdma_m2m_chan_info in user space,
+//	         or the budget in microseconds
+// Return Value :
+//	   0 - sdma_m2m_ioctl success
+//	   the number of jobs queued / completions reaped (SUBMIT / REAP)
+// Errors :
+//     -EFAULT - copy from / to user space failed
+//     -EINVAL - the range is outside the ring or the budget is out of range
+//     -ENOTTY - unknown command
+// ------------------------------------------------------------
+static long sdma_m2m_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+	struct sdma_m2m_sync sync;
+
+	if (SDMA_M2M_IOC_SET_POLL == cmd)
+	{
+		if (arg > SDMA_M2M_POLL_MAX_US)
+		{
+			return -EINVAL;
+		}
+		filp->private_data = (void *)arg;
+		return 0;
+	}
+	if (SDMA_M2M_IOC_SUBMIT == cmd)
+	{
+		return sdma_m2m_job_submit(arg);
+	}
+	if (SDMA_M2M_IOC_REAP == cmd)
+	{
+		return sdma_m2m_job_reap(arg);
+	}
+	if (SDMA_M2M_IOC_GET_CHAN_STATS == cmd)
+	{
+		struct sdma_m2m_chan_info info;
+		int i = 0;
+
+		memset(&info, 0, sizeof(info));
+		info.chans = 1 + sdev->bulk_cnt;
+		for (i = 0; i < info.chans; i++)
+		{
+			info.chan[i] = sdev->pchan[i].stats;
+		}
+		if (copy_to_user((void __user *)arg, &info, sizeof(info)))
+		{
+			return -EFAULT;
+		}
+		return 0;
+	}
+	if (SDMA_M2M_IOC_GET_STATS == cmd)
+	{
+		if (copy_to_user((void __user *)arg, &sdev->stats, sizeof(struct sdma_m2m_stats)))
+		{
+			return -EFAULT;
+		}
+		return 0;
+	}
+
+	if ((SDMA_M2M_IOC_SYNC_FOR_CPU != cmd) && (SDMA_M2M_IOC_SYNC_FOR_DEVICE != cmd))
+	{
+		return -ENOTTY;
+	}
+	if (copy_from_user(&sync, (void __user *)arg, sizeof(sync)))
+	{
+		return -EFAULT;
+	}
+	if ((sync.offset >= SDMA_M2M_RBUF) || (sync.len > SDMA_M2M_RBUF - sync.offset))
+	{
+		return -EINVAL;
+	}
+
+	// only the slot range is invalidated / cleaned
+	if (SDMA_M2M_IOC_SYNC_FOR_CPU == cmd)
+	{
+		dma_sync_single_for_cpu(NULL, sdev->rbuf_dma + sync.offset, sync.len, DMA_FROM_DEVICE);
+	}
+	else
+	{
+		dma_sync_single_for_device(NULL, sdev->rbuf_dma + sync.offset, sync.len, DMA_FROM_DEVICE);
+	}
 
 	return 0;
 }
 
 // ------------------------------------------------------------
 // Description :
-// 	   This function maps physical memory into user space.
+// 	   This function maps the ring into user space, the mmap offset
+//     carries the cache attribute (SDMA_M2M_MMAP_OFFSET).
 // Parameters :
 //	   filp - object file
 //	   vma - virtual memory area struct
 // Return Value :
 //	   0 - sdma_m2m_mmap success
 // Errors :
-//     None.
+//     -EINVAL - unknown attribute or mapping larger than the ring
+//     -EAGAIN - remap failed
 // ------------------------------------------------------------
 static int sdma_m2m_mmap(struct file *filp, struct vm_area_struct *vma)
 {
 	int ret = 0;
     unsigned long size = vma->vm_end - vma->vm_start;
     unsigned long page = virt_to_phys(sdev->rbuf);
+	unsigned long mode = vma->vm_pgoff >> (SDMA_M2M_MMAP_MODE_SHIFT - PAGE_SHIFT);
+
+	if ((mode >= SDMA_M2M_MMAP_MODE_CNT) || (size > PAGE_ALIGN(SDMA_M2M_RBUF)))
+	{
+		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_mmap : invalid mapping.\n");
+		return -EINVAL;
+	}
 
 	vma->vm_flags |= (VM_IO | VM_DONTEXPAND);
-	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	switch (mode)
+	{
+	case SDMA_M2M_MMAP_WC:
+		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+		break;
+	case SDMA_M2M_MMAP_CACHED:
+		// default MAP_SHARED attributes are cacheable
+		break;
+	case SDMA_M2M_MMAP_LEGACY:
+	case SDMA_M2M_MMAP_SO:
+	default:
+		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+		break;
+	}
 
 	ret = io_remap_pfn_range(vma, vma->vm_start, page >> PAGE_SHIFT, size, vma->vm_page_prot);
 	if (ret)
@@ -251,7 +1045,9 @@ struct file_operations sdma_m2m_fops =
 	.release	=	sdma_m2m_release,
 	.write		=	sdma_m2m_write,
 	.read		=	sdma_m2m_read,
+	.unlocked_ioctl	=	sdma_m2m_ioctl,
     .mmap		=	sdma_m2m_mmap,
+	.poll		=	sdma_m2m_poll,
 };
 
 static bool dma_m2m_filter(struct dma_chan *chan, void *param)
@@ -267,25 +1063,53 @@ static bool dma_m2m_filter(struct dma_chan *chan, void *param)
 
 // ------------------------------------------------------------
 // Description :
-// 	   SDMA_M2M initialization.
+// 	   This function requests one memory to memory channel and applies
+//     the M2M configuration.
 // Parameters :
-//	   None.
+//	   prio - DMA_PRIO_HIGH / DMA_PRIO_MEDIUM / DMA_PRIO_LOW
 // Return Value :
-//	   0 - sdma_m2m_init success.
+//	   the channel, NULL if none is left
 // Errors :
 //     None.
 // ------------------------------------------------------------
-static int __init sdma_m2m_init(void)
+static struct dma_chan *sdma_m2m_request(int prio)
 {
-	int err = 0;
 	dma_cap_mask_t dma_m2m_mask;
 	struct imx_dma_data m2m_dma_data = {0};
+	struct dma_chan *chan = NULL;
 
 	dma_cap_zero(dma_m2m_mask);
 	dma_cap_set(DMA_SLAVE, dma_m2m_mask);
 
 	m2m_dma_data.peripheral_type = IMX_DMATYPE_MEMORY;
-	m2m_dma_data.priority = DMA_PRIO_HIGH;
+	m2m_dma_data.priority = clamp(prio, DMA_PRIO_HIGH, DMA_PRIO_LOW);
+
+	chan = dma_request_channel(dma_m2m_mask, dma_m2m_filter, &m2m_dma_data);
+	if (chan)
+	{
+		dmaengine_slave_config(chan, &sdev->dma_m2m_config);
+	}
+
+	return chan;
+}
+
+// ------------------------------------------------------------
+// Description :
+// 	   SDMA_M2M initialization.
+// Parameters :
+//	   None.
+// Return Value :
+//	   0 - sdma_m2m_init success.
+// Errors :
+//     -ENOMEM - no memory for the device or its buffers
+//     -EINVAL - no control channel
+//     -EFAULT - character device registration failed
+//     (every channel obtained is released on failure)
+// ------------------------------------------------------------
+static int __init sdma_m2m_init(void)
+{
+	int err = 0;
+	int i = 0;
 
 	// allocate memory for sdma_m2m device
     sdev = kzalloc(sizeof(sdma_m2m_dev), GFP_KERNEL);
@@ -299,25 +1123,48 @@ static int __init sdma_m2m_init(void)
 	sdev->rbuf_cnt = 0;	
 	atomic_set(&sdev->open_state, 1);
 	init_completion(&sdev->dma_callback_ok);
+	mutex_init(&sdev->read_lock);
+
+	// initiate the job queue and the completion ring
+	mutex_init(&sdev->job_lock);
+	INIT_LIST_HEAD(&sdev->job_queue);
+	INIT_WORK(&sdev->job_work, sdma_m2m_job_work);
+	init_waitqueue_head(&sdev->cq_wait);
 
-	// request DMA channel
-	sdev->dma_m2m_chan = dma_request_channel(dma_m2m_mask, dma_m2m_filter, &m2m_dma_data);
+	// DMA channel configuration
+	sdev->dma_m2m_config.direction = DMA_MEM_TO_MEM;
+	sdev->dma_m2m_config.dst_addr_width = DMA_SLAVE_BUSWIDTH_2_BYTES;
+
+	// request the control channel
+	sdev->dma_m2m_chan = sdma_m2m_request(ctrl_prio);
 	if (!sdev->dma_m2m_chan) 
 	{
-		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_open : dma_request_channel failed.\n");
-		return -EINVAL;
+		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_init : dma_request_channel failed.\n");
+		err = -EINVAL;
+		goto kfree_sdev;
 	}
+	sdev->pchan[0].chan = sdev->dma_m2m_chan;
+	sdev->pchan[0].stats.prio = clamp(ctrl_prio, DMA_PRIO_HIGH, DMA_PRIO_LOW);
 
-	// configure DMA channel 
-	sdev->dma_m2m_config.direction = DMA_MEM_TO_MEM;
-	sdev->dma_m2m_config.dst_addr_width = DMA_SLAVE_BUSWIDTH_2_BYTES;
-	dmaengine_slave_config(sdev->dma_m2m_chan, &sdev->dma_m2m_config);
+	// request the bulk channels, copy jobs are refused without any
+	for (i = 0; i < clamp(bulk_chans, 1, SDMA_M2M_BULK_MAX); i++)
+	{
+		sdev->pchan[1 + i].chan = sdma_m2m_request(bulk_prio);
+		if (!sdev->pchan[1 + i].chan)
+		{
+			printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_init : only %d bulk channels.\n", i);
+			break;
+		}
+		sdev->pchan[1 + i].stats.prio = clamp(bulk_prio, DMA_PRIO_HIGH, DMA_PRIO_LOW);
+		sdev->bulk_cnt++;
+	}
 
 	// write buffer 1KB
 	sdev->wbuf = kzalloc(SDMA_M2M_WBUF, GFP_DMA);
 	if (!sdev->wbuf) 
 	{
-		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_open : kzalloc wbuf failed.\n");
+		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_init : kzalloc wbuf failed.\n");
+		err = -ENOMEM;
 		goto kfree_wbuf;
 	}
 	
@@ -325,10 +1172,14 @@ static int __init sdma_m2m_init(void)
     sdev->rbuf = kzalloc(SDMA_M2M_RBUF, GFP_DMA);
 	if (!sdev->rbuf) 
 	{
-		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_open : kzalloc rbuf failed.\n");
+		printk(KERN_ERR "< sdma_m2m.c > sdma_m2m_init : kzalloc rbuf failed.\n");
+		err = -ENOMEM;
 		goto kfree_rbuf;
 	}
 
+	// map the ring once, the CPU side is synchronised by sdma_m2m_ioctl
+	sdev->rbuf_dma = dma_map_single(NULL, sdev->rbuf, SDMA_M2M_RBUF, DMA_FROM_DEVICE);
+
 	// register a character device
 	sdev->gMajor = register_chrdev(0, DEVICE_NAME, &sdma_m2m_fops);
 	if (sdev->gMajor < 0) 
@@ -370,6 +1221,7 @@ destroy_class:
 
 unregister_chrdev:
 	unregister_chrdev(sdev->gMajor, DEVICE_NAME);
+	dma_unmap_single(NULL, sdev->rbuf_dma, SDMA_M2M_RBUF, DMA_FROM_DEVICE);
 
 kfree_rbuf:
 	kfree(sdev->rbuf);
@@ -377,8 +1229,16 @@ kfree_rbuf:
 kfree_wbuf:
 	kfree(sdev->wbuf);
 
+	// every channel obtained above
+	for (i = 1; i <= sdev->bulk_cnt; i++)
+	{
+		dma_release_channel(sdev->pchan[i].chan);
+	}
+	dma_release_channel(sdev->dma_m2m_chan);
+
 kfree_sdev:
 	kfree(sdev);
+	sdev = NULL;
 
 	return err;
 }
@@ -395,6 +1255,8 @@ kfree_sdev:
 // ------------------------------------------------------------
 static void sdma_m2m_exit(void)
 {
+	int i = 0;
+
 	if (sdev)
 	{
 		if (sdev->sdma_m2m_device)
@@ -409,6 +1271,7 @@ static void sdma_m2m_exit(void)
 		
 		if (sdev->rbuf)
 		{
+			dma_unmap_single(NULL, sdev->rbuf_dma, SDMA_M2M_RBUF, DMA_FROM_DEVICE);
 			kfree(sdev->rbuf);
 			sdev->rbuf = NULL;
 		}
@@ -417,6 +1280,13 @@ static void sdma_m2m_exit(void)
 			kfree(sdev->wbuf);
 			sdev->wbuf = NULL;
 		}
+		cancel_work_sync(&sdev->job_work);
+		for (i = 1; i <= sdev->bulk_cnt; i++)
+		{
+			dma_release_channel(sdev->pchan[i].chan);
+			sdev->pchan[i].chan = NULL;
+		}
+		sdev->bulk_cnt = 0;
 		if (sdev->dma_m2m_chan)
 		{
 			dma_release_channel(sdev->dma_m2m_chan);
@@ -434,5 +1304,5 @@ module_exit(sdma_m2m_exit);
 
 MODULE_AUTHOR("Young");
 MODULE_LICENSE("GPL");  
-MODULE_VERSION("1.2");
+MODULE_VERSION("1.7");
 MODULE_DESCRIPTION("Freescale i.MX6 SDMA_M2M Module"); 
@@ -0,0 +1,183 @@
+// sdma_m2m_async.c
+// asynchronous copy job queue : SDMA moves a user buffer while the CPU is free
+// the buffer is split into jobs, queued by SDMA_M2M_IOC_SUBMIT and collected
+// with poll() + SDMA_M2M_IOC_REAP, then compared with memcpy of the same buffer
+// ./sdma_m2m_async              - 8 MB buffer, 256 KB jobs
+// ./sdma_m2m_async 32 64        - 32 MB buffer, 64 KB jobs
+// the channel pool counters show how the jobs were striped over the bulk channels
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/time.h>
+
+#include "sdma_m2m_ioctl.h"
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+// MB/s of len bytes
+static float mbps(long us, long len)
+{
+    return us ? (float)len / us * 1000000 / 1024 / 1024 : 0;
+}
+
+static const char *prio_names[3] = {"high", "medium", "low"};
+
+// per channel share of the run, before - counters at the start
+static void print_chans(const struct sdma_m2m_chan_info *before, const struct sdma_m2m_chan_info *after, long us)
+{
+    for (unsigned int i = 0; i < after->chans; i++)
+    {
+        const struct sdma_m2m_chan_stats *b = &before->chan[i];
+        const struct sdma_m2m_chan_stats *a = &after->chan[i];
+
+        printf("%s %u (%-6s) : %6u transfers, %8.2f MB, busy %5.1f %%\n", i ? "bulk" : "ctrl", i,
+                prio_names[a->prio % 3], a->transfers - b->transfers,
+                (float)(a->bytes - b->bytes) / 1024 / 1024,
+                us ? (float)(a->busy_ns - b->busy_ns) / 10 / us : 0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long len = 8 * 1024 * 1024;
+    int job_len = 256 * 1024;
+    unsigned char *src = NULL;
+    unsigned char *dst = NULL;
+    struct sdma_m2m_job *jobs = NULL;
+    struct sdma_m2m_cqe cqes[SDMA_M2M_CQ_CNT];
+    struct sdma_m2m_chan_info chan_before, chan_after;
+    struct timeval tstart, tend;
+    int job_cnt = 0;
+    int queued = 0;
+    int reaped = 0;
+    int errors = 0;
+    long polls = 0;
+    long dma_us = 0;
+    long cpu_us = 0;
+    int fd = 0;
+
+    if (argc >= 2)
+    {
+        len = atol(argv[1]) * 1024 * 1024;
+    }
+    if (argc >= 3)
+    {
+        job_len = atoi(argv[2]) * 1024;
+    }
+    if ((len <= 0) || (job_len <= 0) || (job_len > SDMA_M2M_JOB_MAX_LEN))
+    {
+        printf("Wrong arguments (jobs are 1 - %d KB).\n", SDMA_M2M_JOB_MAX_LEN / 1024);
+        return -1;
+    }
+    job_cnt = (len + job_len - 1) / job_len;
+
+    // job destinations start and end on cache lines
+    src = (unsigned char *)malloc(len);
+    if (posix_memalign((void **)&dst, SDMA_M2M_JOB_DST_ALIGN, len))
+    {
+        dst = NULL;
+    }
+    jobs = (struct sdma_m2m_job *)malloc(sizeof(struct sdma_m2m_job) * job_cnt);
+    if ((NULL == src) || (NULL == dst) || (NULL == jobs))
+    {
+        printf("malloc failed.\n");
+        return -1;
+    }
+    for (long i = 0; i < len; i++)
+    {
+        src[i] = i % 251;
+    }
+    // fault the destination in, the timing covers the copy only
+    memset(dst, 0, len);
+
+    for (int i = 0; i < job_cnt; i++)
+    {
+        jobs[i].src = (unsigned long)(src + (long)i * job_len);
+        jobs[i].dst = (unsigned long)(dst + (long)i * job_len);
+        jobs[i].len = (i == job_cnt - 1) ? len - (long)i * job_len : job_len;
+        jobs[i].tag = i;
+    }
+
+    fd = open("/dev/sdma_m2m", O_RDWR);
+    if (fd < 0)
+    {
+        printf("open /dev/sdma_m2m failed.\n");
+        return -1;
+    }
+
+    memset(&chan_before, 0, sizeof(chan_before));
+    memset(&chan_after, 0, sizeof(chan_after));
+    ioctl(fd, SDMA_M2M_IOC_GET_CHAN_STATS, &chan_before);
+
+    gettimeofday(&tstart, NULL);
+    while (reaped < job_cnt)
+    {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        struct sdma_m2m_reap reap = {cqes, SDMA_M2M_CQ_CNT};
+        int n = 0;
+
+        // keep the queue full, SUBMIT takes as many jobs as the ring has room for
+        if (queued < job_cnt)
+        {
+            struct sdma_m2m_batch batch = {jobs + queued, job_cnt - queued};
+
+            n = ioctl(fd, SDMA_M2M_IOC_SUBMIT, &batch);
+            if ((n < 0) && (queued == reaped))
+            {
+                printf("SDMA_M2M_IOC_SUBMIT failed.\n");
+                break;
+            }
+            queued += (n > 0) ? n : 0;
+        }
+
+        // the CPU is free here, a pipeline would do its own work instead of poll()
+        poll(&pfd, 1, 1000);
+        polls++;
+
+        n = ioctl(fd, SDMA_M2M_IOC_REAP, &reap);
+        for (int i = 0; i < n; i++)
+        {
+            if ((cqes[i].status != 0) || (cqes[i].len != jobs[cqes[i].tag].len))
+            {
+                errors++;
+            }
+        }
+        reaped += (n > 0) ? n : 0;
+    }
+    gettimeofday(&tend, NULL);
+    dma_us = elapsed_us(&tstart, &tend);
+    ioctl(fd, SDMA_M2M_IOC_GET_CHAN_STATS, &chan_after);
+    if (memcmp(src, dst, len))
+    {
+        errors++;
+    }
+
+    gettimeofday(&tstart, NULL);
+    memcpy(dst, src, len);
+    gettimeofday(&tend, NULL);
+    cpu_us = elapsed_us(&tstart, &tend);
+
+    printf("------------------------------------\n");
+    printf("sdma_m2m async : %ld bytes in %d jobs of %d bytes.\n", len, job_cnt, job_len);
+    printf("------------------------------------\n");
+    printf("SDMA jobs : %8.2f MB/s, %ld poll() calls, %d errors\n", mbps(dma_us, len), polls, errors);
+    printf("memcpy    : %8.2f MB/s\n", mbps(cpu_us, len));
+    printf("------------------------------------\n");
+    print_chans(&chan_before, &chan_after, dma_us);
+    printf("------------------------------------\n");
+
+    close(fd);
+    free(src);
+    free(dst);
+    free(jobs);
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+// sdma_m2m_bench.c
+// ring consumer throughput for every mmap cache attribute
+// each loop : write 1KB, read() (SDMA wbuf -> slot), checksum the slot
+// the cached mapping brackets the checksum with the slot sync ioctls
+// ./sdma_m2m_bench              - 4096 loops per attribute
+// ./sdma_m2m_bench 10000        - 10000 loops per attribute
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include "sdma_m2m_ioctl.h"
+
+static const char *mode_names[SDMA_M2M_MMAP_MODE_CNT] = {
+    "legacy (noncached)",
+    "write-combine",
+    "strongly ordered",
+    "cached + sync",
+};
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned char wbuf[SDMA_M2M_SLOT] = {0};
+    // read() fills the ring, rbuf is only the buffer argument
+    unsigned char rbuf[SDMA_M2M_SLOT] = {0};
+    int loops = 4096;
+    int fd = 0;
+
+    if (argc == 2)
+    {
+        loops = atoi(argv[1]);
+    }
+    loops = loops < 1 ? 1 : loops;
+
+    fd = open("/dev/sdma_m2m", O_RDWR);
+    if (fd < 0)
+    {
+        printf("open /dev/sdma_m2m failed.\n");
+        return -1;
+    }
+
+    printf("------------------------------------\n");
+    printf("sdma_m2m ring : %d loops of %d bytes per attribute.\n", loops, SDMA_M2M_SLOT);
+    printf("------------------------------------\n");
+    for (int mode = 0; mode < SDMA_M2M_MMAP_MODE_CNT; mode++)
+    {
+        unsigned char *ring = NULL;
+        struct timeval tstart, tend;
+        long total_us = 0;
+        long sum_us = 0;
+        int errors = 0;
+        int slot = 0;
+
+        ring = (unsigned char *)mmap(NULL, SDMA_M2M_RING, PROT_READ, MAP_SHARED, fd, SDMA_M2M_MMAP_OFFSET(mode));
+        if (MAP_FAILED == ring)
+        {
+            printf("%-20s : mmap failed.\n", mode_names[mode]);
+            continue;
+        }
+
+        // read() continues from the driver's current slot, find it with a marker
+        for (int i = 0; i < SDMA_M2M_SLOT; i++)
+        {
+            wbuf[i] = 0xA5 ^ (i * 7) ^ (mode << 4);
+        }
+        write(fd, wbuf, SDMA_M2M_SLOT);
+        read(fd, rbuf, SDMA_M2M_SLOT);
+        {
+            struct sdma_m2m_sync all = {0, SDMA_M2M_RING};
+            ioctl(fd, SDMA_M2M_IOC_SYNC_FOR_CPU, &all);
+            for (int i = 0; i < SDMA_M2M_SLOT_CNT; i++)
+            {
+                if (0 == memcmp(ring + i * SDMA_M2M_SLOT, wbuf, SDMA_M2M_SLOT))
+                {
+                    slot = (i + 1) % SDMA_M2M_SLOT_CNT;
+                }
+            }
+            ioctl(fd, SDMA_M2M_IOC_SYNC_FOR_DEVICE, &all);
+        }
+
+        gettimeofday(&tstart, NULL);
+        for (int cnt = 0; cnt < loops; cnt++)
+        {
+            struct sdma_m2m_sync sync;
+            struct timeval sstart, send;
+            unsigned int sum = 0;
+            unsigned int expect = 0;
+
+            for (int i = 0; i < SDMA_M2M_SLOT; i++)
+            {
+                wbuf[i] = cnt + i;
+                expect += wbuf[i];
+            }
+            write(fd, wbuf, SDMA_M2M_SLOT);
+            read(fd, rbuf, SDMA_M2M_SLOT);
+
+            sync.offset = slot * SDMA_M2M_SLOT;
+            sync.len = SDMA_M2M_SLOT;
+
+            gettimeofday(&sstart, NULL);
+            if (SDMA_M2M_MMAP_CACHED == mode)
+            {
+                ioctl(fd, SDMA_M2M_IOC_SYNC_FOR_CPU, &sync);
+            }
+            for (int i = 0; i < SDMA_M2M_SLOT; i++)
+            {
+                sum += ring[sync.offset + i];
+            }
+            if (SDMA_M2M_MMAP_CACHED == mode)
+            {
+                ioctl(fd, SDMA_M2M_IOC_SYNC_FOR_DEVICE, &sync);
+            }
+            gettimeofday(&send, NULL);
+            sum_us += elapsed_us(&sstart, &send);
+
+            if (sum != expect)
+            {
+                errors++;
+            }
+            slot = (slot + 1) % SDMA_M2M_SLOT_CNT;
+        }
+        gettimeofday(&tend, NULL);
+        total_us = elapsed_us(&tstart, &tend);
+
+        printf("%-20s : checksum %8.2f MB/s, loop %8.2f MB/s, %d errors\n", mode_names[mode],
+                sum_us ? (float)SDMA_M2M_SLOT * loops / sum_us * 1000000 / 1024 / 1024 : 0,
+                total_us ? (float)SDMA_M2M_SLOT * loops / total_us * 1000000 / 1024 / 1024 : 0,
+                errors);
+
+        munmap(ring, SDMA_M2M_RING);
+    }
+    printf("------------------------------------\n");
+
+    close(fd);
+    return 0;
+}
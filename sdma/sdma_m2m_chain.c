@@ -0,0 +1,124 @@
+// sdma_m2m_chain.c
+// read() throughput and SDMA interrupt rate against the chaining batch size
+// each loop : one read() filling the whole ring (16 slots), with batch slots
+//             per descriptor (module parameter batch = 1, 2, 4, 8, 16)
+// ./sdma_m2m_chain              - 4096 loops per batch size
+// ./sdma_m2m_chain 10000        - 10000 loops per batch size
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+
+#include "sdma_m2m_ioctl.h"
+
+#define BATCH_PARAM "/sys/module/sdma_m2m/parameters/batch"
+
+// write an integer to a module parameter file
+static void write_param(const char *path, int val)
+{
+    char wbuf[16] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return;
+    }
+    snprintf(wbuf, sizeof(wbuf), "%d", val);
+    write(fd, (void *)wbuf, strlen(wbuf));
+    close(fd);
+}
+
+// read an integer from a module parameter file
+static int read_param(const char *path)
+{
+    char rbuf[16] = {0};
+    int fd = 0;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    read(fd, (void *)rbuf, sizeof(rbuf) - 1);
+    close(fd);
+
+    return atoi(rbuf);
+}
+
+// microseconds between two time stamps
+static long elapsed_us(const struct timeval *start, const struct timeval *end)
+{
+    return 1000000 * (end->tv_sec - start->tv_sec) + (end->tv_usec - start->tv_usec);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned char wbuf[SDMA_M2M_SLOT] = {0};
+    // read() fills the ring, rbuf is only the buffer argument
+    static unsigned char rbuf[SDMA_M2M_RING];
+    int loops = 4096;
+    int saved = 0;
+    int fd = 0;
+
+    if (argc == 2)
+    {
+        loops = atoi(argv[1]);
+    }
+    loops = loops < 1 ? 1 : loops;
+
+    fd = open("/dev/sdma_m2m", O_RDWR);
+    if (fd < 0)
+    {
+        printf("open /dev/sdma_m2m failed.\n");
+        return -1;
+    }
+    write(fd, wbuf, SDMA_M2M_SLOT);
+    saved = read_param(BATCH_PARAM);
+
+    printf("------------------------------------\n");
+    printf("sdma_m2m chaining : %d reads of %d bytes per batch size.\n", loops, SDMA_M2M_RING);
+    printf("------------------------------------\n");
+    for (int batch = 1; batch <= SDMA_M2M_SLOT_CNT; batch <<= 1)
+    {
+        struct sdma_m2m_stats before, after;
+        struct timeval tstart, tend;
+        unsigned int irqs = 0;
+        long us = 0;
+
+        write_param(BATCH_PARAM, batch);
+        memset(&before, 0, sizeof(before));
+        memset(&after, 0, sizeof(after));
+        ioctl(fd, SDMA_M2M_IOC_GET_STATS, &before);
+
+        gettimeofday(&tstart, NULL);
+        for (int i = 0; i < loops; i++)
+        {
+            read(fd, rbuf, SDMA_M2M_RING);
+        }
+        gettimeofday(&tend, NULL);
+        us = elapsed_us(&tstart, &tend);
+
+        ioctl(fd, SDMA_M2M_IOC_GET_STATS, &after);
+        irqs = after.irqs - before.irqs;
+
+        printf("batch %2d : %8.2f MB/s, %5.2f irqs per KB, %8.0f irqs/s\n", batch,
+                us ? (float)SDMA_M2M_RING * loops / us * 1000000 / 1024 / 1024 : 0,
+                (float)irqs / (after.blocks - before.blocks ? after.blocks - before.blocks : 1),
+                us ? (float)irqs / us * 1000000 : 0);
+    }
+    printf("------------------------------------\n");
+
+    // restore driver settings
+    if (saved > 0)
+    {
+        write_param(BATCH_PARAM, saved);
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,139 @@
+// NAME : sdma_m2m ioctl interface
+// FUNC : ioctl commands and structures shared by sdma_m2m.c and its tools
+// DATE : 2026.10.19
+// HIST : V1.0 2026.10.19 - ring mmap cache attributes and slot sync
+//        V1.1 2026.10.19 - busy-poll completion budget
+//        V1.2 2026.10.19 - asynchronous copy jobs and completion ring
+//        V1.3 2026.10.19 - multi-slot read() counters
+//        V1.4 2026.10.19 - channel pool counters
+
+#ifndef _SDMA_M2M_IOCTL_H_
+#define _SDMA_M2M_IOCTL_H_
+
+#ifdef __KERNEL__
+#include <linux/ioctl.h>
+#else
+#include <sys/ioctl.h>
+#endif
+
+// ring buffer
+// read(fd, NULL, count) copies wbuf into the next ceil(count / SDMA_M2M_SLOT)
+// slots, count is at most SDMA_M2M_RING
+#define SDMA_M2M_SLOT           (1024)                          // 1KB per slot
+#define SDMA_M2M_SLOT_CNT       (16)
+#define SDMA_M2M_RING           (SDMA_M2M_SLOT_CNT * SDMA_M2M_SLOT)
+
+// mmap cache attributes of the ring, selected by the mmap offset :
+// mmap(NULL, SDMA_M2M_RING, prot, MAP_SHARED, fd, SDMA_M2M_MMAP_OFFSET(mode))
+#define SDMA_M2M_MMAP_LEGACY    (0)     // noncached, as before
+#define SDMA_M2M_MMAP_WC        (1)     // write-combine (normal non-cacheable, bufferable)
+#define SDMA_M2M_MMAP_SO        (2)     // strongly ordered
+#define SDMA_M2M_MMAP_CACHED    (3)     // cacheable, needs the sync ioctls around every slot
+#define SDMA_M2M_MMAP_MODE_CNT  (4)
+#define SDMA_M2M_MMAP_MODE_SHIFT (28)
+#define SDMA_M2M_MMAP_OFFSET(mode) ((long)(mode) << SDMA_M2M_MMAP_MODE_SHIFT)
+
+// ring range to be synchronised
+struct sdma_m2m_sync
+{
+    unsigned int offset;        // bytes from the ring start
+    unsigned int len;           // bytes
+};
+
+// ioctl commands
+// SYNC_FOR_CPU : after read() returns, before the CPU reads the slot (invalidate)
+// SYNC_FOR_DEVICE : when the CPU is done with the slot, before it is reused
+#define SDMA_M2M_IOC_MAGIC              'S'
+#define SDMA_M2M_IOC_SYNC_FOR_CPU       _IOW(SDMA_M2M_IOC_MAGIC, 1, struct sdma_m2m_sync)
+#define SDMA_M2M_IOC_SYNC_FOR_DEVICE    _IOW(SDMA_M2M_IOC_MAGIC, 2, struct sdma_m2m_sync)
+// SET_POLL : busy-poll budget of the following read() calls on this file, in
+//            microseconds (argument by value, 0 : sleep until the SDMA interrupt,
+//            at most SDMA_M2M_POLL_MAX_US), read() sleeps once the budget runs out
+#define SDMA_M2M_IOC_SET_POLL           _IO(SDMA_M2M_IOC_MAGIC, 3)
+
+#define SDMA_M2M_POLL_MAX_US            (1000)
+
+// asynchronous copy jobs between user buffers
+// SUBMIT : queue a batch of jobs, the pages are pinned until the job completes,
+//          returns the number of jobs queued (fewer than count once the
+//          completion ring would overflow, -EAGAIN if none fits)
+// REAP : take up to max completions without blocking, returns their number,
+//        poll() reports POLLIN while completions are waiting and POLLOUT while
+//        another job can be queued
+// jobs run on the bulk channels of the pool, striped over them when
+// larger than 64KB, read() keeps its own control channel
+#define SDMA_M2M_IOC_SUBMIT             _IOW(SDMA_M2M_IOC_MAGIC, 4, struct sdma_m2m_batch)
+#define SDMA_M2M_IOC_REAP               _IOW(SDMA_M2M_IOC_MAGIC, 5, struct sdma_m2m_reap)
+
+#define SDMA_M2M_CQ_CNT                 (64)                    // jobs queued or not reaped
+#define SDMA_M2M_JOB_MAX_LEN            (512 * 1024)            // bytes per job
+#define SDMA_M2M_JOB_ALIGN              (2)                     // src alignment
+#define SDMA_M2M_JOB_DST_ALIGN          (32)                    // dst / len alignment, one L1 cache line
+
+// read() counters, irqs / blocks shows the chaining (module parameter batch)
+#define SDMA_M2M_IOC_GET_STATS          _IOR(SDMA_M2M_IOC_MAGIC, 6, struct sdma_m2m_stats)
+
+struct sdma_m2m_stats
+{
+    unsigned int reads;         // read() calls
+    unsigned int blocks;        // ring slots filled
+    unsigned int irqs;          // SDMA completion interrupts taken by read()
+    unsigned long long bytes;
+};
+
+// channel pool : chan[0] is the control channel of read(), chan[1] ~ the bulk
+// channels of the copy jobs (module parameters bulk_chans, ctrl_prio, bulk_prio)
+// busy_ns over wall time is the utilization of a channel
+#define SDMA_M2M_IOC_GET_CHAN_STATS     _IOR(SDMA_M2M_IOC_MAGIC, 7, struct sdma_m2m_chan_info)
+
+#define SDMA_M2M_BULK_MAX               (4)
+#define SDMA_M2M_CHAN_MAX               (1 + SDMA_M2M_BULK_MAX)
+
+struct sdma_m2m_chan_stats
+{
+    unsigned int transfers;     // descriptors completed
+    unsigned int prio;          // 0 high, 1 medium, 2 low
+    unsigned long long bytes;
+    unsigned long long busy_ns; // issue to completion interrupt
+};
+
+struct sdma_m2m_chan_info
+{
+    unsigned int chans;         // control + bulk channels in use
+    struct sdma_m2m_chan_stats chan[SDMA_M2M_CHAN_MAX];
+};
+
+// one copy, src and dst are user addresses and must not overlap
+// the bulk channels move halfwords, so src must be a multiple of
+// SDMA_M2M_JOB_ALIGN, the destination lines are invalidated while the caller
+// keeps running, so dst and len must be multiples of SDMA_M2M_JOB_DST_ALIGN
+// (no other data shares a cache line with dst, SUBMIT returns -EINVAL otherwise)
+struct sdma_m2m_job
+{
+    unsigned long src;
+    unsigned long dst;
+    unsigned int len;           // 32 ~ SDMA_M2M_JOB_MAX_LEN bytes, SDMA_M2M_JOB_DST_ALIGN multiple
+    unsigned int tag;           // returned in the completion
+};
+
+struct sdma_m2m_batch
+{
+    struct sdma_m2m_job *jobs;
+    unsigned int count;
+};
+
+// completion of one job, in the order the jobs were queued
+struct sdma_m2m_cqe
+{
+    unsigned int tag;
+    int status;                 // 0 or -errno
+    unsigned int len;           // bytes copied
+};
+
+struct sdma_m2m_reap
+{
+    struct sdma_m2m_cqe *cqes;
+    unsigned int max;
+};
+
+#endif
@@ -0,0 +1,118 @@
+// sdma_m2m_lat.c
+// read() latency percentiles, sleeping completion against busy-poll completion
+// each sample : one read() (SDMA wbuf -> slot) of 64 / 128 / 256 / 512 bytes
+// ./sdma_m2m_lat                - 10000 samples per size and mode, 50 us poll budget
+// ./sdma_m2m_lat 20000 100      - 20000 samples, 100 us poll budget
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/ioctl.h>
+
+#include "sdma_m2m_ioctl.h"
+
+static const int sizes[] = {64, 128, 256, 512};
+
+// nanoseconds of the monotonic clock
+static long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+
+    return (x > y) - (x < y);
+}
+
+// value at percentile p of sorted samples
+static long long percentile(const long long *lat, int n, double p)
+{
+    int i = (int)(p / 100 * (n - 1) + 0.5);
+
+    return lat[i];
+}
+
+int main(int argc, char **argv)
+{
+    unsigned char wbuf[SDMA_M2M_SLOT] = {0};
+    long long *lat = NULL;
+    int samples = 10000;
+    int budget = 50;
+    int fd = 0;
+
+    if (argc >= 2)
+    {
+        samples = atoi(argv[1]);
+    }
+    if (argc >= 3)
+    {
+        budget = atoi(argv[2]);
+    }
+    samples = samples < 1 ? 1 : samples;
+    if ((budget < 1) || (budget > SDMA_M2M_POLL_MAX_US))
+    {
+        printf("the poll budget must be 1 - %d us.\n", SDMA_M2M_POLL_MAX_US);
+        return -1;
+    }
+
+    lat = (long long *)malloc(sizeof(long long) * samples);
+    if (NULL == lat)
+    {
+        printf("malloc failed.\n");
+        return -1;
+    }
+
+    fd = open("/dev/sdma_m2m", O_RDWR);
+    if (fd < 0)
+    {
+        printf("open /dev/sdma_m2m failed.\n");
+        free(lat);
+        return -1;
+    }
+    write(fd, wbuf, SDMA_M2M_SLOT);
+
+    printf("------------------------------------\n");
+    printf("sdma_m2m read() latency : %d samples, poll budget %d us.\n", samples, budget);
+    printf("%5s %-6s %9s %9s %9s %9s %9s  (us)\n", "bytes", "mode", "p50", "p90", "p99", "p99.9", "max");
+    printf("------------------------------------\n");
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+    {
+        for (int poll = 0; poll < 2; poll++)
+        {
+            if (ioctl(fd, SDMA_M2M_IOC_SET_POLL, poll ? budget : 0) < 0)
+            {
+                printf("SDMA_M2M_IOC_SET_POLL failed.\n");
+                break;
+            }
+
+            for (int i = 0; i < samples; i++)
+            {
+                long long start = now_ns();
+                read(fd, NULL, sizes[s]);
+                lat[i] = now_ns() - start;
+            }
+            qsort(lat, samples, sizeof(long long), cmp_ll);
+
+            printf("%5d %-6s %9.2f %9.2f %9.2f %9.2f %9.2f\n", sizes[s], poll ? "poll" : "sleep",
+                    percentile(lat, samples, 50) / 1000.0, percentile(lat, samples, 90) / 1000.0,
+                    percentile(lat, samples, 99) / 1000.0, percentile(lat, samples, 99.9) / 1000.0,
+                    lat[samples - 1] / 1000.0);
+        }
+    }
+    printf("------------------------------------\n");
+
+    ioctl(fd, SDMA_M2M_IOC_SET_POLL, 0);
+    close(fd);
+    free(lat);
+
+    return 0;
+}